@@ -0,0 +1,666 @@
+/*
+ * Optional lip-sync daemon: one ONNX Runtime session shared by every game
+ * process on the machine, optionally with requests from all clients batched
+ * into single [B, T, C] runs. Clients (LipSyncContext.connect_daemon) talk to
+ * it over a UNIX socket and pass their windows through shared memory; see
+ * src/daemon_protocol.h. Its memory is one session plus a small record per
+ * client, however many contexts connect.
+ *
+ *   scons lipsync_daemon
+ *   bin/lipsync_daemon --model project/addons/godot_openlipsync/model.onnx
+ *       [--socket /tmp/openlipsync.sock] [--max-batch 1] [--batch-window-us 300] [--threads 1] [--stats <seconds>]
+ *   bin/lipsync_daemon --check [--socket <path>] [--clients 8] [--seconds 2]
+ *
+ * Without SCons:
+ *   c++ -O2 -std=c++17 -Isrc -Ithirdparty/onnxruntime/include -o lipsync_daemon \
+ *       daemon/lipsync_daemon.cpp src/daemon_client.cpp src/onnx_graph.cpp src/custom_ops.cpp src/mel_frontend.cpp src/half_float.cpp \
+ *       -Lthirdparty/onnxruntime/lib -lonnxruntime -Wl,-rpath,thirdparty/onnxruntime/lib
+ *
+ * Batching is off by default (--max-batch 1): measured with bench_scaling in
+ * daemon mode on one core, 16 clients got 423-544 requests/s one at a time
+ * and 380-469 in batches of up to 16, so it only pays where the batched
+ * GEMMs win over the wait. With --max-batch above 1, a batch is run when
+ * max-batch requests are waiting, when every client has one waiting, or
+ * batch-window-us after the first one arrived, whichever comes first. Requests of different lengths run as separate batches. At
+ * startup a batch of two is compared with two single runs; a model that
+ * can't batch is served one request at a time.
+ *
+ * --check connects that many clients from threads of its own to a running
+ * daemon, sends random windows for a while, and verifies that each reply
+ * matches a solo run of the same window.
+ */
+
+#include "custom_ops.h"
+#include "daemon_client.h"
+#include "daemon_protocol.h"
+#include "onnx_graph.h"
+#include <onnxruntime_cxx_api.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace daemon_protocol;
+
+static volatile std::sig_atomic_t running = 1;
+
+static void _on_signal(int p_signal) {
+    (void)p_signal;
+    running = 0;
+}
+
+static uint64_t _ticks_usec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Options {
+    std::string socket_path = DEFAULT_SOCKET;
+    std::string model_path;
+    uint32_t max_batch = 1; // Batching lost to single runs in bench_scaling
+    uint32_t batch_window_usec = 300;
+    int threads = 1;
+    double stats_seconds = 0.0;
+    bool check = false;
+    int check_clients = 8;
+    double check_seconds = 2.0;
+};
+
+// The shared session and the shape facts the clients are told about
+class SharedModel {
+public:
+    bool load(const Options &p_options);
+    // Runs p_batch windows of p_frames, packed in p_input, and writes each one's
+    // last-frame visemes to r_output (p_batch * viseme_count floats)
+    bool run(const float *p_input, uint32_t p_batch, uint32_t p_frames, float *r_output);
+
+    uint32_t n_mels = 0;
+    uint32_t viseme_count = 0;
+    uint32_t receptive_field = 0;
+    uint32_t max_batch = 1;
+
+private:
+    bool _check_batching();
+
+    Ort::Env env{ ORT_LOGGING_LEVEL_WARNING, "OpenLipSyncDaemon" };
+    std::unique_ptr<Ort::Session> session;
+    std::string input_name;
+    std::string output_name;
+    Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+};
+
+bool SharedModel::load(const Options &p_options) {
+    std::ifstream file(p_options.model_path, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    const std::string bytes = contents.str();
+    if (!file || bytes.empty()) {
+        std::fprintf(stderr, "lipsync_daemon: Could not read model file %s\n", p_options.model_path.c_str());
+        return false;
+    }
+
+    // The same rewrites OnnxModel makes, plus a symbolic batch dim
+    std::string data = bytes;
+    onnx_graph::Model graph;
+    std::string error;
+    bool batchable = false;
+    if (!graph.load((const uint8_t *)bytes.data(), bytes.size(), error)) {
+        std::fprintf(stderr, "lipsync_daemon: Keeping the original graph, could not parse it: %s\n", error.c_str());
+    } else {
+        receptive_field = (uint32_t)std::max<int64_t>(onnx_graph::receptive_field(graph), 0);
+        int fused = 0;
+        if (!onnx_graph::slice_output_to_last_step(graph, error)) {
+            std::fprintf(stderr, "lipsync_daemon: Keeping full output, graph rewrite failed: %s\n", error.c_str());
+        }
+        if (!onnx_graph::fuse_causal_conv1d(graph, fused, error)) {
+            std::fprintf(stderr, "lipsync_daemon: Keeping stock Conv nodes, fusion failed: %s\n", error.c_str());
+        }
+        batchable = onnx_graph::make_batch_dynamic(graph, error);
+        if (!batchable) {
+            std::fprintf(stderr, "lipsync_daemon: Serving one request at a time, could not make the batch dim dynamic: %s\n", error.c_str());
+        }
+        data = graph.save();
+    }
+
+    try {
+        Ort::SessionOptions session_options;
+        session_options.SetIntraOpNumThreads(p_options.threads);
+        session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_BASIC);
+        custom_ops::add_to_session_options(session_options);
+        session.reset(new Ort::Session(env, data.data(), data.size(), session_options));
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        input_name = session->GetInputNameAllocated(0, allocator).get();
+        output_name = session->GetOutputNameAllocated(0, allocator).get();
+        Ort::TypeInfo input_info = session->GetInputTypeInfo(0);
+        Ort::TypeInfo output_info = session->GetOutputTypeInfo(0);
+        if (input_info.GetTensorTypeAndShapeInfo().GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT ||
+                output_info.GetTensorTypeAndShapeInfo().GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+            std::fprintf(stderr, "lipsync_daemon: Only float feature models are served.\n");
+            return false;
+        }
+        std::vector<int64_t> input_shape = input_info.GetTensorTypeAndShapeInfo().GetShape();
+        std::vector<int64_t> output_shape = output_info.GetTensorTypeAndShapeInfo().GetShape();
+        if (input_shape.size() != 3 || input_shape.back() <= 0 || output_shape.empty() || output_shape.back() <= 0 ||
+                output_shape.back() > (int64_t)MAX_VISEMES) {
+            std::fprintf(stderr, "lipsync_daemon: Expected a [1, T, C] feature input and at most %u visemes.\n", MAX_VISEMES);
+            return false;
+        }
+        n_mels = (uint32_t)input_shape.back();
+        viseme_count = (uint32_t)output_shape.back();
+    } catch (const Ort::Exception &e) {
+        std::fprintf(stderr, "lipsync_daemon: ONNX Runtime Error: %s\n", e.what());
+        return false;
+    }
+
+    max_batch = p_options.max_batch > 1 && batchable && _check_batching() ? p_options.max_batch : 1;
+    return true;
+}
+
+bool SharedModel::run(const float *p_input, uint32_t p_batch, uint32_t p_frames, float *r_output) {
+    try {
+        const int64_t shape[3] = { (int64_t)p_batch, (int64_t)p_frames, (int64_t)n_mels };
+        Ort::Value input = Ort::Value::CreateTensor<float>(memory_info, (float *)p_input, (size_t)p_batch * p_frames * n_mels, shape, 3);
+        const char *input_names[] = { input_name.c_str() };
+        const char *output_names[] = { output_name.c_str() };
+        std::vector<Ort::Value> outputs = session->Run(Ort::RunOptions{ nullptr }, input_names, &input, 1, output_names, 1);
+        const size_t count = outputs[0].GetTensorTypeAndShapeInfo().GetElementCount();
+        const size_t per_window = count / p_batch;
+        if (count % p_batch != 0 || per_window < viseme_count) {
+            return false;
+        }
+        const float *values = outputs[0].GetTensorData<float>();
+        for (uint32_t b = 0; b < p_batch; b++) {
+            std::memcpy(r_output + (size_t)b * viseme_count, values + (b + 1) * per_window - viseme_count, viseme_count * sizeof(float));
+        }
+        return true;
+    } catch (const Ort::Exception &e) {
+        std::fprintf(stderr, "lipsync_daemon: ONNX Runtime Error: %s\n", e.what());
+        return false;
+    }
+}
+
+// Reshapes that bake in a batch of 1 pass the shape rewrite but fail or mix
+// windows at run time, so compare a batch against solo runs once
+bool SharedModel::_check_batching() {
+    const uint32_t frames = std::max<uint32_t>(receptive_field, 16);
+    std::vector<float> input((size_t)2 * frames * n_mels);
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    for (float &value : input) {
+        value = noise(rng);
+    }
+    std::vector<float> batched(2 * viseme_count);
+    std::vector<float> solo(2 * viseme_count);
+    if (!run(input.data(), 2, frames, batched.data()) ||
+            !run(input.data(), 1, frames, solo.data()) ||
+            !run(input.data() + (size_t)frames * n_mels, 1, frames, solo.data() + viseme_count)) {
+        std::fprintf(stderr, "lipsync_daemon: The model failed a batched run, serving one request at a time.\n");
+        return false;
+    }
+    for (size_t i = 0; i < batched.size(); i++) {
+        if (std::fabs(batched[i] - solo[i]) > 1e-4f) {
+            std::fprintf(stderr, "lipsync_daemon: Batched results differ from solo runs, serving one request at a time.\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Client {
+    int fd = -1;
+    float *buffer = nullptr;
+    size_t buffer_bytes = 0;
+    uint32_t max_frames = 0;
+    bool greeted = false;
+    bool pending = false;
+    Request request = {};
+    // The message being received: a Hello until greeted, then Requests. Sockets
+    // are non-blocking, so a client that sends half a message holds up no one.
+    char inbox[sizeof(Hello) > sizeof(Request) ? sizeof(Hello) : sizeof(Request)];
+    size_t received = 0;
+};
+
+class Server {
+public:
+    Server(const Options &p_options, SharedModel &p_model) :
+            options(p_options), model(p_model) {}
+    bool listen();
+    void serve();
+
+private:
+    void _accept();
+    bool _receive(Client &p_client);
+    bool _greet(Client &p_client);
+    bool _read_request(Client &p_client);
+    void _drop(size_t p_index);
+    void _run_pending();
+    size_t _pending_count() const;
+
+    const Options &options;
+    SharedModel &model;
+    int listen_fd = -1;
+    std::vector<Client> clients;
+    std::vector<float> batch_input;
+    std::vector<float> batch_output;
+
+    // Totals since the last stats line
+    uint64_t stats_start = 0;
+    uint64_t requests = 0;
+    uint64_t runs = 0;
+    uint64_t run_usec = 0;
+};
+
+static bool _set_non_blocking(int p_fd) {
+    const int flags = ::fcntl(p_fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(p_fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool Server::listen() {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (options.socket_path.size() >= sizeof(address.sun_path)) {
+        std::fprintf(stderr, "lipsync_daemon: Socket path too long\n");
+        return false;
+    }
+    std::memcpy(address.sun_path, options.socket_path.c_str(), options.socket_path.size() + 1);
+    // A stale socket from a daemon that didn't exit cleanly would make bind fail
+    ::unlink(options.socket_path.c_str());
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 || ::bind(listen_fd, (const sockaddr *)&address, sizeof(address)) != 0 || ::listen(listen_fd, 64) != 0 ||
+            !_set_non_blocking(listen_fd)) {
+        std::fprintf(stderr, "lipsync_daemon: Could not listen on %s: %s\n", options.socket_path.c_str(), std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void Server::serve() {
+    std::printf("Serving %s: %u mels in, %u visemes out, receptive field %u, batches of up to %u\n",
+            options.socket_path.c_str(), model.n_mels, model.viseme_count, model.receptive_field, model.max_batch);
+    std::fflush(stdout);
+    stats_start = _ticks_usec();
+    uint64_t first_pending = 0;
+    std::vector<pollfd> fds;
+    while (running) {
+        size_t pending = _pending_count();
+        int timeout = -1;
+        if (pending > 0) {
+            const uint64_t waited = _ticks_usec() - first_pending;
+            // Every connected client is waiting on us, so nothing else can join the batch
+            if (pending >= model.max_batch || pending == clients.size() || waited >= options.batch_window_usec) {
+                _run_pending();
+                pending = _pending_count();
+                // Still look at the sockets before the next run, or a steady
+                // stream of full batches would starve new connections
+                timeout = 0;
+            } else {
+                timeout = (int)((options.batch_window_usec - waited + 999) / 1000);
+            }
+        }
+        if (options.stats_seconds > 0.0) {
+            const int until_stats = (int)std::max<int64_t>((int64_t)(stats_start + options.stats_seconds * 1e6) - (int64_t)_ticks_usec(), 0) / 1000;
+            timeout = timeout < 0 ? until_stats : std::min(timeout, until_stats);
+        }
+
+        fds.clear();
+        fds.push_back({ listen_fd, POLLIN, 0 });
+        for (const Client &client : clients) {
+            // A client with a request in flight sends nothing more until it has its reply
+            fds.push_back({ client.fd, (short)(client.pending ? 0 : POLLIN), 0 });
+        }
+        // poll() has millisecond resolution; spin the sub-millisecond rest of a batch window
+        const int ready = ::poll(fds.data(), fds.size(), pending > 0 && timeout <= 1 ? 0 : timeout);
+        if (ready < 0 && errno != EINTR) {
+            std::fprintf(stderr, "lipsync_daemon: poll failed: %s\n", std::strerror(errno));
+            break;
+        }
+        if (ready > 0) {
+            // Back to front, so dropping a client doesn't shift the ones still to check
+            for (size_t i = clients.size(); i-- > 0;) {
+                const short events = fds[i + 1].revents;
+                if (events & (POLLERR | POLLHUP | POLLNVAL)) {
+                    _drop(i);
+                } else if (events & POLLIN) {
+                    const bool was_pending = clients[i].pending;
+                    if (!_receive(clients[i])) {
+                        _drop(i);
+                    } else if (!was_pending && clients[i].pending && _pending_count() == 1) {
+                        first_pending = _ticks_usec();
+                    }
+                }
+            }
+            if (fds[0].revents & POLLIN) {
+                _accept();
+            }
+        }
+
+        if (options.stats_seconds > 0.0 && _ticks_usec() - stats_start >= options.stats_seconds * 1e6) {
+            const double seconds = (_ticks_usec() - stats_start) / 1e6;
+            std::printf("%zu clients, %.0f requests/s, %.1f per batch, %.0f us per batch\n", clients.size(), requests / seconds,
+                    runs > 0 ? (double)requests / runs : 0.0, runs > 0 ? (double)run_usec / runs : 0.0);
+            std::fflush(stdout);
+            stats_start = _ticks_usec();
+            requests = 0;
+            runs = 0;
+            run_usec = 0;
+        }
+    }
+    while (!clients.empty()) {
+        _drop(clients.size() - 1);
+    }
+    ::close(listen_fd);
+    ::unlink(options.socket_path.c_str());
+}
+
+void Server::_accept() {
+    // Everyone queued, so a burst of connections isn't spread over batch runs
+    while (true) {
+        const int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        // Replies are a few bytes and a client has at most one in flight, so a
+        // send that would block means the client stopped reading; it gets dropped
+        if (!_set_non_blocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+        Client client;
+        client.fd = fd;
+        clients.push_back(client);
+    }
+}
+
+bool Server::_receive(Client &p_client) {
+    const size_t size = p_client.greeted ? sizeof(Request) : sizeof(Hello);
+    while (p_client.received < size) {
+        const ssize_t got = ::recv(p_client.fd, p_client.inbox + p_client.received, size - p_client.received, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true; // The rest comes in a later poll
+        }
+        if (got <= 0) {
+            return false;
+        }
+        p_client.received += (size_t)got;
+    }
+    p_client.received = 0;
+    return p_client.greeted ? _read_request(p_client) : _greet(p_client);
+}
+
+bool Server::_greet(Client &p_client) {
+    Hello hello;
+    std::memcpy(&hello, p_client.inbox, sizeof(hello));
+    HelloReply reply = {};
+    reply.magic = MAGIC;
+    reply.status = STATUS_OK;
+    hello.buffer_name[sizeof(hello.buffer_name) - 1] = '\0';
+    if (hello.magic != MAGIC || hello.version != VERSION || hello.n_mels != model.n_mels ||
+            hello.max_frames == 0 || hello.max_frames > MAX_FRAMES) {
+        reply.status = STATUS_BAD_REQUEST;
+    } else {
+        const size_t size = buffer_size(hello.max_frames, hello.n_mels);
+        const int fd = shm_open(hello.buffer_name, O_RDWR, 0);
+        struct stat info;
+        void *memory = MAP_FAILED;
+        if (fd >= 0 && fstat(fd, &info) == 0 && (size_t)info.st_size >= size) {
+            memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        if (memory == MAP_FAILED) {
+            reply.status = STATUS_BUFFER_FAILED;
+        } else {
+            p_client.buffer = (float *)memory;
+            p_client.buffer_bytes = size;
+            p_client.max_frames = hello.max_frames;
+        }
+    }
+    reply.viseme_count = model.viseme_count;
+    reply.receptive_field = model.receptive_field;
+    reply.max_batch = model.max_batch;
+    if (!send_all(p_client.fd, &reply, sizeof(reply)) || reply.status != STATUS_OK) {
+        return false;
+    }
+    p_client.greeted = true;
+    return true;
+}
+
+bool Server::_read_request(Client &p_client) {
+    std::memcpy(&p_client.request, p_client.inbox, sizeof(p_client.request));
+    if (p_client.request.frames == 0 || p_client.request.frames > p_client.max_frames) {
+        Reply reply = { p_client.request.sequence, STATUS_BAD_REQUEST, model.viseme_count, 0 };
+        return send_all(p_client.fd, &reply, sizeof(reply));
+    }
+    p_client.pending = true;
+    return true;
+}
+
+void Server::_drop(size_t p_index) {
+    Client &client = clients[p_index];
+    if (client.buffer) {
+        munmap(client.buffer, client.buffer_bytes);
+    }
+    ::close(client.fd);
+    clients.erase(clients.begin() + p_index);
+}
+
+size_t Server::_pending_count() const {
+    size_t count = 0;
+    for (const Client &client : clients) {
+        count += client.pending ? 1 : 0;
+    }
+    return count;
+}
+
+void Server::_run_pending() {
+    // Windows of equal length share a tensor; each length is its own set of batches
+    std::map<uint32_t, std::vector<size_t>> by_frames;
+    for (size_t i = 0; i < clients.size(); i++) {
+        if (clients[i].pending) {
+            by_frames[clients[i].request.frames].push_back(i);
+        }
+    }
+    std::vector<size_t> failed;
+    for (const auto &group : by_frames) {
+        const uint32_t frames = group.first;
+        const std::vector<size_t> &members = group.second;
+        const size_t window_floats = (size_t)frames * model.n_mels;
+        for (size_t first = 0; first < members.size(); first += model.max_batch) {
+            const uint32_t batch = (uint32_t)std::min<size_t>(model.max_batch, members.size() - first);
+            batch_input.resize(batch * window_floats);
+            batch_output.resize((size_t)batch * model.viseme_count);
+            for (uint32_t b = 0; b < batch; b++) {
+                std::memcpy(batch_input.data() + b * window_floats, clients[members[first + b]].buffer, window_floats * sizeof(float));
+            }
+            const uint64_t start = _ticks_usec();
+            const bool ok = model.run(batch_input.data(), batch, frames, batch_output.data());
+            run_usec += _ticks_usec() - start;
+            runs++;
+            requests += batch;
+            for (uint32_t b = 0; b < batch; b++) {
+                Client &client = clients[members[first + b]];
+                if (ok) {
+                    std::memcpy((char *)client.buffer + output_offset(client.max_frames, model.n_mels),
+                            batch_output.data() + (size_t)b * model.viseme_count, model.viseme_count * sizeof(float));
+                }
+                client.pending = false;
+                Reply reply = { client.request.sequence, ok ? STATUS_OK : STATUS_INFERENCE_FAILED, model.viseme_count, batch };
+                if (!send_all(client.fd, &reply, sizeof(reply))) {
+                    failed.push_back(members[first + b]);
+                }
+            }
+        }
+    }
+    std::sort(failed.begin(), failed.end());
+    for (size_t i = failed.size(); i-- > 0;) {
+        _drop(failed[i]);
+    }
+}
+
+// --check: many clients at once against a running daemon, each reply compared
+// with a solo request of the same window from a client of its own
+static int _run_check(const Options &p_options) {
+    DaemonClient reference;
+    std::string error;
+    const uint32_t frames = 100;
+    const uint32_t n_mels = 80;
+    if (!reference.connect(p_options.socket_path, frames, n_mels, error)) {
+        std::fprintf(stderr, "lipsync_daemon --check: %s\n", error.c_str());
+        return 2;
+    }
+    const uint32_t visemes = reference.viseme_count();
+    std::printf("Daemon: %u visemes, batches of up to %u\n", visemes, reference.max_batch());
+
+    std::atomic<uint64_t> total(0);
+    std::atomic<uint64_t> batched_sum(0);
+    std::atomic<uint32_t> max_seen(0);
+    std::atomic<int> failures(0);
+    std::mutex first_error_mutex;
+    std::string first_error;
+    auto fail = [&](const std::string &p_error) {
+        std::lock_guard<std::mutex> lock(first_error_mutex);
+        if (first_error.empty()) {
+            first_error = p_error;
+        }
+        failures++;
+    };
+    std::vector<std::vector<float>> windows(p_options.check_clients, std::vector<float>((size_t)frames * n_mels));
+    std::vector<std::vector<float>> expected(p_options.check_clients, std::vector<float>(visemes));
+    for (int c = 0; c < p_options.check_clients; c++) {
+        std::mt19937 rng(c + 1);
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+        for (float &value : windows[c]) {
+            value = noise(rng);
+        }
+        if (!reference.infer(windows[c].data(), frames, expected[c].data(), error)) {
+            std::fprintf(stderr, "lipsync_daemon --check: %s\n", error.c_str());
+            return 2;
+        }
+    }
+    reference.close();
+
+    const uint64_t end = _ticks_usec() + (uint64_t)(p_options.check_seconds * 1e6);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < p_options.check_clients; c++) {
+        threads.emplace_back([&, c]() {
+            DaemonClient client;
+            std::string thread_error;
+            if (!client.connect(p_options.socket_path, frames, n_mels, thread_error)) {
+                fail(thread_error);
+                return;
+            }
+            std::vector<float> out(visemes);
+            while (_ticks_usec() < end) {
+                if (!client.infer(windows[c].data(), frames, out.data(), thread_error)) {
+                    fail(thread_error);
+                    return;
+                }
+                for (uint32_t v = 0; v < visemes; v++) {
+                    if (std::fabs(out[v] - expected[c][v]) > 1e-4f) {
+                        fail("A reply differs from the solo run");
+                        return;
+                    }
+                }
+                total++;
+                batched_sum += client.last_batch_size();
+                uint32_t seen = max_seen.load();
+                while (client.last_batch_size() > seen && !max_seen.compare_exchange_weak(seen, client.last_batch_size())) {
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    std::printf("%d clients: %llu requests in %.1f s (%.0f/s), mean batch %.1f, max %u\n", p_options.check_clients,
+            (unsigned long long)total.load(), p_options.check_seconds, total.load() / p_options.check_seconds,
+            total.load() > 0 ? (double)batched_sum.load() / total.load() : 0.0, max_seen.load());
+    if (failures.load() > 0 || total.load() == 0) {
+        std::fprintf(stderr, "Check FAILED: %d clients lost or got results that differ from a solo run (first: %s)\n", failures.load(),
+                first_error.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--check") {
+            options.check = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "lipsync_daemon: %s needs a value\n", arg.c_str());
+            return 2;
+        }
+        i++;
+        if (arg == "--socket") {
+            options.socket_path = value;
+        } else if (arg == "--model") {
+            options.model_path = value;
+        } else if (arg == "--max-batch") {
+            options.max_batch = (uint32_t)std::max(std::atoi(value), 1);
+        } else if (arg == "--batch-window-us") {
+            options.batch_window_usec = (uint32_t)std::max(std::atoi(value), 0);
+        } else if (arg == "--threads") {
+            options.threads = std::max(std::atoi(value), 1);
+        } else if (arg == "--stats") {
+            options.stats_seconds = std::atof(value);
+        } else if (arg == "--clients") {
+            options.check_clients = std::max(std::atoi(value), 1);
+        } else if (arg == "--seconds") {
+            options.check_seconds = std::atof(value);
+        } else {
+            std::fprintf(stderr, "lipsync_daemon: Unknown option %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    if (options.check) {
+        return _run_check(options);
+    }
+    if (options.model_path.empty()) {
+        std::fprintf(stderr, "Usage: lipsync_daemon --model <path.onnx> [--socket <path>] [--max-batch <n>] [--batch-window-us <n>] [--threads <n>] [--stats <seconds>]\n"
+                             "       lipsync_daemon --check [--socket <path>] [--clients <n>] [--seconds <n>]\n");
+        return 2;
+    }
+
+    std::signal(SIGINT, _on_signal);
+    std::signal(SIGTERM, _on_signal);
+    SharedModel model;
+    if (!model.load(options)) {
+        return 2;
+    }
+    Server server(options, model);
+    if (!server.listen()) {
+        return 2;
+    }
+    server.serve();
+    return 0;
+}
@@ -0,0 +1,134 @@
+@tool
+extends VBoxContainer
+
+# Editor dock that profiles the model with ONNX Runtime's built-in profiler and
+# shows where inference time goes, aggregated per op type and per graph node.
+
+const DEFAULT_MODEL := "res://addons/godot_openlipsync/model.onnx"
+
+var model_edit: LineEdit
+var frames_spin: SpinBox
+var runs_spin: SpinBox
+var last_frame_check: CheckBox
+var fused_conv_check: CheckBox
+var summary_label: Label
+var op_tree: Tree
+var node_tree: Tree
+
+func _init():
+	name = "LipSync Profiler"
+
+	var form = GridContainer.new()
+	form.columns = 2
+	add_child(form)
+
+	form.add_child(_label("Model"))
+	model_edit = LineEdit.new()
+	model_edit.text = DEFAULT_MODEL
+	model_edit.size_flags_horizontal = SIZE_EXPAND_FILL
+	form.add_child(model_edit)
+
+	form.add_child(_label("Context frames"))
+	frames_spin = SpinBox.new()
+	frames_spin.min_value = 1
+	frames_spin.max_value = 2000
+	frames_spin.value = 100
+	form.add_child(frames_spin)
+
+	form.add_child(_label("Runs"))
+	runs_spin = SpinBox.new()
+	runs_spin.min_value = 1
+	runs_spin.max_value = 10000
+	runs_spin.value = 200
+	form.add_child(runs_spin)
+
+	form.add_child(_label("Last frame only"))
+	last_frame_check = CheckBox.new()
+	last_frame_check.button_pressed = true
+	form.add_child(last_frame_check)
+
+	form.add_child(_label("Fused Conv1d"))
+	fused_conv_check = CheckBox.new()
+	form.add_child(fused_conv_check)
+
+	var button = Button.new()
+	button.text = "Profile"
+	button.pressed.connect(_on_profile_pressed)
+	add_child(button)
+
+	summary_label = Label.new()
+	summary_label.autowrap_mode = TextServer.AUTOWRAP_WORD_SMART
+	add_child(summary_label)
+
+	var tabs = TabContainer.new()
+	tabs.size_flags_vertical = SIZE_EXPAND_FILL
+	add_child(tabs)
+
+	op_tree = _make_tree("Op")
+	op_tree.name = "Per Op"
+	tabs.add_child(op_tree)
+
+	node_tree = _make_tree("Node")
+	node_tree.name = "Per Node"
+	tabs.add_child(node_tree)
+
+func _label(text: String) -> Label:
+	var label = Label.new()
+	label.text = text
+	return label
+
+func _make_tree(first_column: String) -> Tree:
+	var tree = Tree.new()
+	tree.columns = 5
+	tree.column_titles_visible = true
+	tree.hide_root = true
+	tree.size_flags_vertical = SIZE_EXPAND_FILL
+	var titles = [first_column, "Calls", "Total (ms)", "Avg (us)", "%"]
+	for i in range(titles.size()):
+		tree.set_column_title(i, titles[i])
+		tree.set_column_expand(i, i == 0)
+	return tree
+
+func _on_profile_pressed():
+	var model = OnnxModel.new()
+	model.set_profiling_enabled(true)
+	model.set_last_frame_only(last_frame_check.button_pressed)
+	model.set_fused_conv(fused_conv_check.button_pressed)
+	# Keep warm-up out of the trace; the first run shows up as a single outlier
+	model.set_warmup_runs(0)
+	if not model.load_model(model_edit.text):
+		summary_label.text = "Failed to load " + model_edit.text
+		return
+
+	# Per-frame normalised features look roughly standard normal
+	var input = PackedFloat32Array()
+	input.resize(int(frames_spin.value) * 80)
+	for i in range(input.size()):
+		input[i] = randfn(0.0, 1.0)
+
+	for i in range(int(runs_spin.value)):
+		model.run_inference(input)
+
+	var report: Dictionary = model.end_profiling()
+	if report.is_empty():
+		summary_label.text = "Profiling failed, see the output log."
+		return
+
+	var runs: int = max(report["runs"], 1)
+	summary_label.text = "%d runs, %.1f us of kernel time per run, %d convs fused.\nTrace: %s" % [
+		report["runs"], float(report["total_usec"]) / runs, model.get_fused_conv_count(), report["file"]]
+	_fill_tree(op_tree, report["ops"], "op")
+	_fill_tree(node_tree, report["nodes"], "node")
+
+func _fill_tree(tree: Tree, rows: Array, key: String):
+	tree.clear()
+	var root = tree.create_item()
+	for row in rows:
+		var item = tree.create_item(root)
+		item.set_text(0, row[key])
+		if key == "node":
+			item.set_tooltip_text(0, row["op"])
+		item.set_text(1, str(row["count"]))
+		item.set_text(2, "%.2f" % (float(row["total_usec"]) / 1000.0))
+		item.set_text(3, "%.1f" % row["avg_usec"])
+		item.set_text(4, "%.1f" % row["percent"])
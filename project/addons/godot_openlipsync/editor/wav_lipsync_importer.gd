@@ -0,0 +1,124 @@
+@tool
+extends EditorImportPlugin
+
+# Imports a WAV as an AudioStreamWAV and bakes its visemes at import time.
+# Pick "Audio + Lip Sync" under Import As for the voice lines that need it.
+# The track is stored as metadata on the imported stream:
+#   lipsync_visemes: PackedFloat32Array, frame-major [frames * viseme_count]
+#   lipsync_viseme_count: int
+#   lipsync_fps: float (frames per second of audio, 100 at the default hop)
+# The result is cached in .godot/imported and Godot only reimports when the
+# WAV's content or these options change, so unchanged lines are never rebaked.
+# Replacing the model in place is not detected: reimport the clips by hand.
+# The audio goes through AudioStreamWAV.load_from_buffer with the stock WAV
+# importer's options, so it matches a plain import; that needs Godot 4.4+.
+
+const DEFAULT_MODEL := "res://addons/godot_openlipsync/model.onnx"
+# Mel features per clip, so switching models doesn't redo feature extraction
+const FEATURE_CACHE_DIR := "res://.godot/openlipsync/features"
+const HOP_LENGTH := 160
+const FPS := 16000.0 / HOP_LENGTH
+
+# One baker per model and context size, so a batch reimport loads the model once
+var _bakers := {}
+
+func _get_importer_name() -> String:
+	return "openlipsync.wav"
+
+func _get_visible_name() -> String:
+	return "Audio + Lip Sync"
+
+func _get_recognized_extensions() -> PackedStringArray:
+	return PackedStringArray(["wav"])
+
+func _get_save_extension() -> String:
+	return "res"
+
+func _get_resource_type() -> String:
+	return "AudioStreamWAV"
+
+func _get_priority() -> float:
+	# Below the built-in WAV importer, so plain audio keeps its default
+	return 0.5
+
+func _get_import_order() -> int:
+	return 0
+
+func _get_preset_count() -> int:
+	return 1
+
+func _get_preset_name(_preset_index: int) -> String:
+	return "Default"
+
+func _get_import_options(_path: String, _preset_index: int) -> Array[Dictionary]:
+	return [
+		# Same names and defaults as the stock WAV importer, passed through as is.
+		# edit/trim is left out: cutting the leading silence would shift the audio
+		# against the track, which is baked from the untrimmed file.
+		{"name": "force/8_bit", "default_value": false},
+		{"name": "force/mono", "default_value": false},
+		{"name": "force/max_rate", "default_value": false},
+		{"name": "force/max_rate_hz", "default_value": 44100, "property_hint": PROPERTY_HINT_RANGE, "hint_string": "11025,192000,1,exp"},
+		{"name": "edit/normalize", "default_value": false},
+		{"name": "edit/loop_mode", "default_value": 0, "property_hint": PROPERTY_HINT_ENUM, "hint_string": "Detect From WAV,Disabled,Forward,Ping-Pong,Backward"},
+		{"name": "edit/loop_begin", "default_value": 0},
+		{"name": "edit/loop_end", "default_value": -1},
+		{"name": "compress/mode", "default_value": 2, "property_hint": PROPERTY_HINT_ENUM, "hint_string": "Disabled,RAM (Ima-ADPCM),QOA (Quite OK Audio)"},
+		{"name": "lipsync/model", "default_value": DEFAULT_MODEL, "property_hint": PROPERTY_HINT_FILE, "hint_string": "*.onnx"},
+		{"name": "lipsync/context_size", "default_value": 100, "property_hint": PROPERTY_HINT_RANGE, "hint_string": "1,1000"},
+	]
+
+func _get_option_visibility(_path: String, _option_name: StringName, _options: Dictionary) -> bool:
+	return true
+
+func _can_import_threaded() -> bool:
+	# The shared bakers are not meant to be reconfigured from several threads
+	return false
+
+func _import(source_file: String, save_path: String, options: Dictionary, _platform_variants: Array[String], _gen_files: Array[String]) -> Error:
+	var bytes := FileAccess.get_file_as_bytes(source_file)
+	if bytes.is_empty():
+		return ERR_FILE_CANT_READ
+
+	if not ClassDB.class_has_method("AudioStreamWAV", "load_from_buffer"):
+		push_error("Lip Sync import: needs Godot 4.4 or later to decode %s like the stock WAV importer" % source_file)
+		return ERR_UNAVAILABLE
+	var stream: AudioStreamWAV = ClassDB.class_call_static("AudioStreamWAV", "load_from_buffer", bytes, _stream_options(options))
+	if stream == null:
+		push_error("Lip Sync import: could not decode " + source_file)
+		return ERR_FILE_CORRUPT
+
+	var baker := _get_baker(options["lipsync/model"], options["lipsync/context_size"])
+	if baker == null:
+		return ERR_CANT_CREATE
+	var samples := LipSyncBaker.decode_wav(bytes)
+	var frames := samples.size() / HOP_LENGTH
+	var visemes: PackedFloat32Array = baker.bake_samples(samples)
+	if frames > 0 and visemes.is_empty():
+		push_error("Lip Sync import: inference failed for " + source_file)
+		return ERR_CANT_CREATE
+
+	var viseme_count := visemes.size() / frames if frames > 0 else 0
+	stream.set_meta("lipsync_visemes", visemes)
+	stream.set_meta("lipsync_viseme_count", viseme_count)
+	stream.set_meta("lipsync_fps", FPS)
+	return ResourceSaver.save(stream, "%s.%s" % [save_path, _get_save_extension()])
+
+func _get_baker(model_path: String, context_size: int) -> LipSyncBaker:
+	var key := "%s:%d" % [model_path, context_size]
+	if not _bakers.has(key):
+		var baker := LipSyncBaker.new()
+		baker.set_context_size(context_size)
+		baker.set_feature_cache_dir(FEATURE_CACHE_DIR)
+		if not baker.load_model(model_path):
+			push_error("Lip Sync import: could not load model " + model_path)
+			return null
+		_bakers[key] = baker
+	return _bakers[key]
+
+func _stream_options(options: Dictionary) -> Dictionary:
+	var stream_options := {}
+	for key in options:
+		if not String(key).begins_with("lipsync/"):
+			stream_options[key] = options[key]
+	return stream_options
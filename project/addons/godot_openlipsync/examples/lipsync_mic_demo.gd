@@ -5,6 +5,10 @@ class_name LipSyncMicController
 @export_group("Model")
 @export_file("*.onnx") var model_path: String = "res://addons/godot_openlipsync/model.onnx"
 @export var context_window_size: int = 100
+# Model per LOD tier (index = tier). Empty or missing entries fall back to model_path.
+# Tier 1 defaults to the INT8 model produced by `scons quantize`.
+@export_file("*.onnx") var lod_model_paths: Array[String] = ["", "res://addons/godot_openlipsync/model.int8.onnx"]
+@export var lod_tier: int = 0
 
 @export_group("Audio")
 @export var audio_bus_name: String = "Record" # Default for Mic
@@ -76,12 +80,13 @@ func _ready():
 		set_process(false)
 		return
 		
-	if not context.load_model(model_path):
+	# Set before loading so the warm-up inference runs at the real context size
+	context.set_context_size(context_window_size)
+	if not context.load_model(_model_path_for_tier(lod_tier)):
 		printerr("LipSyncMicController: Failed to load ONNX model.")
 		set_process(false)
 		return
 		
-	context.set_context_size(context_window_size)
 	print("LipSync: Model loaded.")
 
 	# 2. Setup Audio
@@ -89,7 +94,28 @@ func _ready():
 	
 	# Initialize current weights
 	for v_idx in viseme_mapping:
-		current_blend_weights[v_idx] = 0.0
+		current_blend_weights[viseme_mapping[v_idx]] = 0.0
+
+func _model_path_for_tier(tier: int) -> String:
+	if tier >= 0 and tier < lod_model_paths.size():
+		var path = lod_model_paths[tier]
+		if not path.is_empty():
+			if FileAccess.file_exists(path):
+				return path
+			printerr("LipSyncMicController: LOD model not found at ", path, ", using ", model_path)
+	return model_path
+
+# Switches model variant at runtime. The new session is built off the main thread
+# and swapped in between hops, so this never hitches a frame.
+func set_lod_tier(tier: int):
+	if tier == lod_tier or not context:
+		return
+	var path = _model_path_for_tier(tier)
+	if path == _model_path_for_tier(lod_tier):
+		lod_tier = tier
+		return
+	if context.load_model_async(path):
+		lod_tier = tier
 
 func _setup_audio_capture():
 	bus_index = AudioServer.get_bus_index(audio_bus_name)
@@ -158,34 +184,30 @@ func _process(delta):
 		var audio_frames = capture_effect.get_buffer(frames_available)
 		var source_rate = AudioServer.get_mix_rate()
 		
-		# Noise Gate Check
-		var max_amp = 0.0
-		for sample in audio_frames:
-			max_amp = max(max_amp, abs(sample.x), abs(sample.y))
-			
-		if max_amp < noise_gate:
-			# Signal silence to smooth towards zero
-			var silence = PackedFloat32Array()
-			silence.resize(viseme_mapping.size() + 5) # Enough for any index
-			silence.fill(0.0)
-			_apply_visemes(silence, delta)
-			return
-
 		var prediction = context.process(audio_frames, source_rate)
-		
-		if prediction.size() > 0:
-			_apply_visemes(prediction, delta)
+		if step_blend_weights(current_blend_weights, prediction, viseme_mapping, context.get_peak(), noise_gate, sensitivity, smoothing):
+			_apply_blend_weights()
+
+# One step of the noise gate and smoothing, for the prediction of one process()
+# call. Updates weights (blend shape name -> weight) in place and returns false
+# if there was nothing new to apply. Static so tools/latency_probe.gd measures
+# exactly what the demo does.
+static func step_blend_weights(weights: Dictionary, prediction: PackedFloat32Array, mapping: Dictionary, peak: float, noise_gate: float, sensitivity: float, smoothing: float) -> bool:
+	# Noise Gate Check: the context meters the audio natively while it
+	# downmixes, and keeps the history continuous through silence
+	var gated := peak < noise_gate
+	if not gated and prediction.is_empty():
+		return false
 
-func _apply_visemes(prediction: PackedFloat32Array, delta: float):
 	# 1. Aggregate weights for each unique blend shape
-	var shape_weights = {} 
-	
-	for v_idx in viseme_mapping:
-		if v_idx >= prediction.size(): continue
-		
-		var blend_name = viseme_mapping[v_idx]
-		var raw_weight = prediction[v_idx] * sensitivity
-		
+	var shape_weights = {}
+	for v_idx in mapping:
+		if not gated and v_idx >= prediction.size(): continue
+
+		var blend_name = mapping[v_idx]
+		# Gated: smooth towards zero
+		var raw_weight = 0.0 if gated else prediction[v_idx] * sensitivity
+
 		# If multiple visemes map to same shape, take the MAX weight
 		# (e.g. if 'ou' and 'u' both map to 'mouth_u', don't sum them)
 		if blend_name in shape_weights:
@@ -193,20 +215,20 @@ func _apply_visemes(prediction: PackedFloat32Array, delta: float):
 		else:
 			shape_weights[blend_name] = raw_weight
 
-	# 2. Smooth and Apply
+	# 2. Smooth
 	for blend_name in shape_weights:
 		var target_weight = shape_weights[blend_name]
-		var prev_weight = current_blend_weights.get(blend_name, 0.0)
-		
+		var prev_weight = weights.get(blend_name, 0.0)
+
 		# Frame-rate independent smoothing
 		var new_weight = lerp(prev_weight, target_weight, 1.0 - smoothing)
-		
+
 		# Clamp to avoid comic distortion
-		new_weight = clamp(new_weight, 0.0, 1.0)
-		
-		current_blend_weights[blend_name] = new_weight
-		
-		# Apply to mesh
+		weights[blend_name] = clamp(new_weight, 0.0, 1.0)
+	return true
+
+func _apply_blend_weights():
+	for blend_name in current_blend_weights:
 		var bs_idx = mesh_instance.find_blend_shape_by_name(blend_name)
 		if bs_idx != -1:
-			mesh_instance.set_blend_shape_value(bs_idx, new_weight)
+			mesh_instance.set_blend_shape_value(bs_idx, current_blend_weights[blend_name])
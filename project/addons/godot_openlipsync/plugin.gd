@@ -1,10 +1,20 @@
 @tool
 extends EditorPlugin
 
+var profiler_dock: Control
+var wav_importer: EditorImportPlugin
+
 func _enter_tree():
-    # Initialization of the plugin goes here.
-    pass
+    profiler_dock = preload("editor/profiler_dock.gd").new()
+    add_control_to_dock(DOCK_SLOT_RIGHT_UL, profiler_dock)
+    wav_importer = preload("editor/wav_lipsync_importer.gd").new()
+    add_import_plugin(wav_importer)
 
 func _exit_tree():
-    # Clean-up of the plugin goes here.
-    pass
+    if profiler_dock:
+        remove_control_from_docks(profiler_dock)
+        profiler_dock.queue_free()
+        profiler_dock = null
+    if wav_importer:
+        remove_import_plugin(wav_importer)
+        wav_importer = null
@@ -0,0 +1,79 @@
+extends SceneTree
+
+# Headless batch baker for build agents. Walks a directory, bakes a .lipsync
+# viseme track next to every .wav and skips files whose track is up to date.
+#
+#   godot --headless --path project -s res://addons/godot_openlipsync/tools/bake_cli.gd -- \
+#       <dir> [--model <path.onnx>] [--context <frames>] [--threads <n>] [--force] [--no-recursive] [--feature-cache <dir>]
+#
+# --feature-cache keeps each clip's mel features in <dir>, so re-bakes with a new
+# model or context size skip feature extraction.
+#
+# Exits with 1 if any file failed, 2 on bad arguments or a model that won't load.
+
+const DEFAULT_MODEL := "res://addons/godot_openlipsync/model.onnx"
+
+func _initialize():
+	var args := OS.get_cmdline_user_args()
+	var dir := ""
+	var model_path := DEFAULT_MODEL
+	var context := 100
+	var threads := 0
+	var force := false
+	var recursive := true
+	var feature_cache := ""
+
+	var i := 0
+	while i < args.size():
+		var arg: String = args[i]
+		match arg:
+			"--model":
+				i += 1
+				model_path = args[i] if i < args.size() else ""
+			"--context":
+				i += 1
+				context = int(args[i]) if i < args.size() else 0
+			"--threads":
+				i += 1
+				threads = int(args[i]) if i < args.size() else 0
+			"--force":
+				force = true
+			"--no-recursive":
+				recursive = false
+			"--feature-cache":
+				i += 1
+				feature_cache = args[i] if i < args.size() else ""
+			_:
+				if arg.begins_with("--"):
+					_fail("Unknown option " + arg)
+					return
+				dir = arg
+		i += 1
+
+	if dir.is_empty() or model_path.is_empty() or context < 1:
+		_fail("Usage: -- <dir> [--model <path.onnx>] [--context <frames>] [--threads <n>] [--force] [--no-recursive] [--feature-cache <dir>]")
+		return
+	if not DirAccess.dir_exists_absolute(dir):
+		_fail("No such directory: " + dir)
+		return
+
+	var baker := LipSyncBaker.new()
+	baker.set_context_size(context)
+	baker.set_threads(threads)
+	baker.set_force(force)
+	baker.set_feature_cache_dir(feature_cache)
+	if not baker.load_model(model_path):
+		_fail("Could not load model " + model_path)
+		return
+
+	print("Baking %s (model %s, context %d, receptive field %d)" % [dir, model_path, context, baker.get_receptive_field()])
+	var report: Dictionary = baker.bake_directory(dir, recursive)
+	print("%d files: %d baked (%d from cached features), %d up to date, %d failed" % [
+		report["files"], report["baked"], report["features_cached"], report["skipped"], report["failed"]])
+	print("%.1f s of audio in %.1f s: %.1fx realtime, %.1f files/s" % [
+		report["audio_seconds"], report["wall_seconds"], report["realtime_factor"], report["files_per_second"]])
+	quit(1 if report["failed"] > 0 else 0)
+
+func _fail(message: String):
+	printerr(message)
+	quit(2)
@@ -0,0 +1,136 @@
+extends SceneTree
+
+# Headless loopback check for LipSyncStreamCodec. Bakes a WAV file's visemes,
+# sends them through an encoder and a decoder in network-tick sized packets
+# and reports the bitrate and the reconstruction error.
+#
+#   godot --headless --path project -s res://addons/godot_openlipsync/tools/codec_loopback.gd -- \
+#       <file.wav> [--model <path.onnx>] [--tick <frames>] [--bits <n>] [--deadband <steps>] [--stride <frames>] [--loss <percent>]
+#
+# --tick is the frames per packet (10 = 10 packets/s). --loss drops that share of
+# packets at random, with the receiver requesting a keyframe after each gap.
+#
+# Exits with 1 if the decoded stream is short or too far off on a lossless
+# link, 2 on bad arguments or a model that won't load.
+
+const DEFAULT_MODEL := "res://addons/godot_openlipsync/model.onnx"
+const HOP_LENGTH := 160
+const FPS := 100.0
+
+func _initialize():
+	var args := OS.get_cmdline_user_args()
+	var path := ""
+	var model_path := DEFAULT_MODEL
+	var tick := 10
+	var codec := LipSyncStreamCodec.new()
+	var loss := 0.0
+
+	var i := 0
+	while i < args.size():
+		var arg: String = args[i]
+		var value: String = args[i + 1] if i + 1 < args.size() else ""
+		match arg:
+			"--model":
+				model_path = value
+				i += 1
+			"--tick":
+				tick = int(value)
+				i += 1
+			"--bits":
+				codec.set_bits(int(value))
+				i += 1
+			"--deadband":
+				codec.set_deadband(int(value))
+				i += 1
+			"--stride":
+				codec.set_stride(int(value))
+				i += 1
+			"--loss":
+				loss = float(value) / 100.0
+				i += 1
+			_:
+				if arg.begins_with("--"):
+					_fail("Unknown option " + arg)
+					return
+				path = arg
+		i += 1
+
+	if path.is_empty() or tick < 1:
+		_fail("Usage: -- <file.wav> [--model <path.onnx>] [--tick <frames>] [--bits <n>] [--deadband <steps>] [--stride <frames>] [--loss <percent>]")
+		return
+
+	var baker := LipSyncBaker.new()
+	if not baker.load_model(model_path):
+		_fail("Could not load model " + model_path)
+		return
+	var samples := LipSyncBaker.decode_wav(FileAccess.get_file_as_bytes(path))
+	var hops := samples.size() / HOP_LENGTH
+	if hops == 0:
+		_fail("No audio in " + path)
+		return
+	var visemes := baker.bake_samples(samples)
+	var count := visemes.size() / hops
+	codec.set_viseme_count(count)
+
+	var receiver := LipSyncStreamCodec.new()
+	receiver.set_viseme_count(count)
+	receiver.set_bits(codec.get_bits())
+	receiver.set_stride(codec.get_stride())
+
+	var rng := RandomNumberGenerator.new()
+	rng.seed = 1
+	var total_bytes := 0
+	var packets := 0
+	var lost := 0
+	var dropped := 0
+	var decoded := PackedFloat32Array()
+	var sent_frames := 0
+	var compared := 0
+	var error_sum := 0.0
+	var error_max := 0.0
+	for start in range(0, hops, tick):
+		var frames := mini(tick, hops - start)
+		var packet := codec.encode(visemes.slice(start * count, (start + frames) * count))
+		total_bytes += packet.size()
+		packets += 1
+		sent_frames += frames
+		if loss > 0.0 and rng.randf() < loss:
+			lost += 1
+			continue
+		var frame_values := receiver.decode(packet)
+		if receiver.needs_keyframe():
+			dropped += 1
+			codec.request_keyframe()
+			continue
+		if loss > 0.0:
+			continue
+		# On a lossless link the decoded frames line up with the sent ones
+		for v in frame_values.size():
+			var index := decoded.size() + v
+			var err: float = absf(frame_values[v] - clampf(visemes[index], 0.0, 1.0))
+			error_sum += err
+			error_max = maxf(error_max, err)
+			compared += 1
+		decoded.append_array(frame_values)
+
+	var seconds := hops / FPS
+	print("%s: %d frames in %d packets, %.1f s" % [path, hops, packets, seconds])
+	print("%d bytes: %.0f bits/s (%.1f bytes/packet) at %d bits, deadband %d, stride %d" % [
+		total_bytes, total_bytes * 8.0 / seconds, float(total_bytes) / packets, codec.get_bits(), codec.get_deadband(), codec.get_stride()])
+	if loss > 0.0:
+		print("%d packets lost, %d more dropped waiting for a keyframe" % [lost, dropped])
+		quit(0)
+		return
+
+	var mean_error := error_sum / maxi(compared, 1)
+	print("Error: mean %.4f, max %.4f" % [mean_error, error_max])
+	# Everything but the last partial stride group must arrive, within a couple of steps on average
+	var step := 1.0 / ((1 << codec.get_bits()) - 1)
+	var ok := dropped == 0 and decoded.size() / count >= sent_frames - codec.get_stride() and mean_error <= step * (codec.get_deadband() + 1)
+	if not ok:
+		printerr("Loopback FAILED")
+	quit(0 if ok else 1)
+
+func _fail(message: String):
+	printerr(message)
+	quit(2)
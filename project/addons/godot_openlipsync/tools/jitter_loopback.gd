@@ -0,0 +1,125 @@
+extends SceneTree
+
+# Headless simulated network for LipSyncJitterBuffer. Cuts a WAV file into
+# voice packets, delays them by a random jitter, drops some, and plays what
+# arrives through the buffer at a fixed frame rate. Reports how evenly the
+# inference was spread over frames and what the buffer concealed.
+#
+#   godot --headless --path project -s res://addons/godot_openlipsync/tools/jitter_loopback.gd -- \
+#       <file.wav> [--model <path.onnx>] [--packet <ms>] [--latency <ms>] [--jitter <ms>] [--loss <percent>] [--fps <n>] [--seed <n>]
+#
+# Jitter is exponential with the given mean, on top of a fixed latency, so
+# packets also arrive out of order.
+#
+# Exits with 1 if nothing was played, 2 on bad arguments or a model that won't load.
+
+const DEFAULT_MODEL := "res://addons/godot_openlipsync/model.onnx"
+
+func _initialize():
+	var args := OS.get_cmdline_user_args()
+	var path := ""
+	var model_path := DEFAULT_MODEL
+	var packet_ms := 20.0
+	var latency_ms := 30.0
+	var jitter_ms := 10.0
+	var loss := 0.05
+	var fps := 60.0
+	var rng_seed := 1
+
+	var i := 0
+	while i < args.size():
+		var arg: String = args[i]
+		var value: String = args[i + 1] if i + 1 < args.size() else ""
+		match arg:
+			"--model":
+				model_path = value
+				i += 1
+			"--packet":
+				packet_ms = float(value)
+				i += 1
+			"--latency":
+				latency_ms = float(value)
+				i += 1
+			"--jitter":
+				jitter_ms = float(value)
+				i += 1
+			"--loss":
+				loss = float(value) / 100.0
+				i += 1
+			"--fps":
+				fps = float(value)
+				i += 1
+			"--seed":
+				rng_seed = int(value)
+				i += 1
+			_:
+				if arg.begins_with("--"):
+					_fail("Unknown option " + arg)
+					return
+				path = arg
+		i += 1
+
+	if path.is_empty() or packet_ms <= 0.0 or fps <= 0.0:
+		_fail("Usage: -- <file.wav> [--model <path.onnx>] [--packet <ms>] [--latency <ms>] [--jitter <ms>] [--loss <percent>] [--fps <n>] [--seed <n>]")
+		return
+
+	var context := LipSyncContext.new()
+	if not context.load_model(model_path):
+		_fail("Could not load model " + model_path)
+		return
+	var samples := LipSyncBaker.decode_wav(FileAccess.get_file_as_bytes(path))
+	if samples.is_empty():
+		_fail("No audio in " + path)
+		return
+
+	# Packets as [arrival time, sequence, samples], in arrival order
+	var rng := RandomNumberGenerator.new()
+	rng.seed = rng_seed
+	var packet_samples := int(16000 * packet_ms / 1000.0)
+	var arrivals := []
+	var sent := 0
+	for start in range(0, samples.size() - packet_samples + 1, packet_samples):
+		var sequence := sent
+		sent += 1
+		if rng.randf() < loss:
+			continue
+		var delay := latency_ms - jitter_ms * log(1.0 - rng.randf())
+		arrivals.append([sequence * packet_ms / 1000.0 + delay / 1000.0, sequence, samples.slice(start, start + packet_samples)])
+	arrivals.sort_custom(func(a, b): return a[0] < b[0])
+
+	var buffer := LipSyncJitterBuffer.new()
+	buffer.set_context(context)
+	var frame_time := 1.0 / fps
+	var now := 0.0
+	var next := 0
+	var played := 0
+	var hops_per_frame := {}
+	var end_time: float = (arrivals[-1][0] if not arrivals.is_empty() else 0.0) + buffer.get_max_concealment() + 0.5
+	while now < end_time:
+		now += frame_time
+		while next < arrivals.size() and arrivals[next][0] <= now:
+			buffer.push_samples(arrivals[next][1], arrivals[next][2], 16000)
+			next += 1
+		buffer.update(frame_time)
+		var total: int = buffer.get_stats()["hops_played"]
+		var hops := total - played
+		played = total
+		hops_per_frame[hops] = hops_per_frame.get(hops, 0) + 1
+
+	var stats := buffer.get_stats()
+	print("%s: %d packets of %d ms, %d lost on the wire, latency %d ms + %d ms jitter, %d fps" % [
+		path, sent, int(packet_ms), sent - arrivals.size(), int(latency_ms), int(jitter_ms), int(fps)])
+	print("Received %d, late %d, concealed %d packets (%d hops), skipped %d hops" % [
+		stats["received"], stats["late"], stats["concealed_packets"], stats["concealed_hops"], stats["skipped_hops"]])
+	print("Measured jitter %.1f ms, target window %.1f ms" % [stats["jitter"] * 1000.0, stats["target_delay"] * 1000.0])
+	var keys := hops_per_frame.keys()
+	keys.sort()
+	var spread := PackedStringArray()
+	for hops in keys:
+		spread.append("%d: %d" % [hops, hops_per_frame[hops]])
+	print("Inferences per frame (hops: frames): " + ", ".join(spread))
+	quit(0 if played > 0 else 1)
+
+func _fail(message: String):
+	printerr(message)
+	quit(2)
@@ -0,0 +1,376 @@
+extends SceneTree
+
+# Headless audio-to-blend-shape latency probe. Generates a noise floor with a
+# synthetic plosive ("pa": a noise burst, then a voiced /a/) every second at
+# a random phase, and plays it through the same path as the mic demo: an
+# AudioEffectCapture that receives mixed blocks, a _process() that polls it
+# at a fixed frame rate, LipSyncContext.process() at the mix rate, and the
+# demo's own smoothing and noise gate (LipSyncMicController.step_blend_weights)
+# onto a mesh's blend shapes. Time is simulated, so no audio device or
+# microphone is needed; compute is measured for real.
+#
+#   godot --headless --path project -s res://addons/godot_openlipsync/tools/latency_probe.gd -- \
+#       [--model <path.onnx>] [--trials <n>] [--mix-rate <hz>] [--block <frames>] [--fps <n>] \
+#       [--smoothing <0..1>] [--gate <level>] [--seed <n>]
+#
+# For each plosive the probe finds the first output that moved halfway from
+# the pre-onset baseline to the response 100-200 ms later, and splits the time
+# from the onset to the blend shapes moving halfway into:
+#   capture    until the mixer has finished the block holding the onset
+#   polling    until the next _process() picks that block up
+#   window     until the 10 ms hop holding the onset, whose 25 ms analysis
+#              window ends there, is complete and inferred
+#   model      further hops until the output responds
+#   processing the wall time of the process() call that responded, split into
+#              resampling, mel features and inference (latency statistics)
+#   blend      frames of smoothing until the blend shape is halfway, plus the
+#              wall time spent applying blend shapes on that frame
+# Device input latency before the capture effect is outside what it can see.
+#
+# Exits with 1 if no plosive was detected, 2 on bad arguments or a model that won't load.
+#
+# UNVERIFIED: this script has not been run yet. It was written without a
+# Godot 4.4+ binary to hand, so neither the stage breakdown nor the shared
+# step_blend_weights() path has been checked against a real run. Treat its
+# numbers with suspicion until someone has run it headless and compared them
+# with the latency statistics (LipSyncContext.get_latency_stats()).
+
+# Preloaded rather than named, so the probe runs before the editor has
+# written the global class cache
+const MicDemo := preload("res://addons/godot_openlipsync/examples/lipsync_mic_demo.gd")
+
+const DEFAULT_MODEL := "res://addons/godot_openlipsync/model.onnx"
+const LEAD_IN := 1.5 # Seconds of noise floor so the context window is full
+const SPACING := 1.0 # Seconds between plosives
+const PLOSIVE_SECONDS := 0.25
+const NOISE_FLOOR := 0.001
+const HOP := 160.0 / 16000.0
+
+var mix_rate := 48000
+var block := 512
+var fps := 60.0
+var smoothing := 0.5
+var noise_gate := 0.05
+
+func _initialize():
+	var args := OS.get_cmdline_user_args()
+	var model_path := DEFAULT_MODEL
+	var trials := 20
+	var rng_seed := 1
+
+	var i := 0
+	while i < args.size():
+		var arg: String = args[i]
+		var value: String = args[i + 1] if i + 1 < args.size() else ""
+		match arg:
+			"--model":
+				model_path = value
+			"--trials":
+				trials = int(value)
+			"--mix-rate":
+				mix_rate = int(value)
+			"--block":
+				block = int(value)
+			"--fps":
+				fps = float(value)
+			"--smoothing":
+				smoothing = float(value)
+			"--gate":
+				noise_gate = float(value)
+			"--seed":
+				rng_seed = int(value)
+			_:
+				_fail("Unknown option " + arg)
+				return
+		i += 2
+
+	if trials < 1 or mix_rate < 8000 or block < 1 or fps <= 0.0 or smoothing < 0.0 or smoothing >= 1.0:
+		_fail("Usage: -- [--model <path.onnx>] [--trials <n>] [--mix-rate <hz>] [--block <frames>] [--fps <n>] [--smoothing <0..1>] [--gate <level>] [--seed <n>]")
+		return
+
+	var context := LipSyncContext.new()
+	if not context.load_model(model_path):
+		_fail("Could not load model " + model_path)
+		return
+	var visemes := context.get_model().get_output_channels()
+	if visemes <= 0:
+		visemes = 15
+
+	var rng := RandomNumberGenerator.new()
+	rng.seed = rng_seed
+	var onsets := PackedFloat64Array()
+	for trial in trials:
+		# A random phase against mix blocks, frames and hops
+		onsets.append(roundf((LEAD_IN + trial * SPACING + rng.randf() * 0.05) * mix_rate) / mix_rate)
+	var audio := _generate(onsets, LEAD_IN + trials * SPACING + 0.5, rng)
+
+	var mesh := _make_mesh(visemes)
+	root.add_child(mesh)
+
+	var calls := _run(context, audio, mesh, visemes)
+
+	var rows := {}
+	for stage in ["capture", "polling", "window", "model", "processing", "resample", "features", "inference", "blend", "total"]:
+		rows[stage] = PackedFloat64Array()
+	var missed := 0
+	for t0 in onsets:
+		var result := _measure(calls, t0)
+		if result.is_empty():
+			missed += 1
+			continue
+		for stage in result:
+			rows[stage].append(result[stage])
+
+	print("Latency probe: %d plosives, %d Hz mix in %d-frame blocks, %d fps, smoothing %.2f, gate %.3f, model %s" % [
+		trials, mix_rate, block, int(fps), smoothing, noise_gate, model_path])
+	if missed == trials:
+		printerr("No plosive response detected.")
+		quit(1)
+		return
+	print("%-34s %8s %8s %8s" % ["Stage (ms)", "mean", "p95", "max"])
+	var labels := {
+		"capture": "capture effect (mix block)",
+		"polling": "_process polling",
+		"window": "hop + 25 ms window",
+		"model": "model response",
+		"processing": "process() call",
+		"resample": "  resampler",
+		"features": "  mel features",
+		"inference": "  inference",
+		"blend": "blend shapes (smoothing + apply)",
+		"total": "total",
+	}
+	for stage in labels:
+		var values: PackedFloat64Array = rows[stage]
+		values.sort()
+		var mean := 0.0
+		for value in values:
+			mean += value
+		mean /= values.size()
+		print("%-34s %8.2f %8.2f %8.2f" % [labels[stage], mean, values[int(0.95 * (values.size() - 1))], values[-1]])
+	if missed > 0:
+		print("%d of %d plosives had no clear response and were left out." % [missed, trials])
+	print("The resampler's own delay is under one source sample (%.3f ms); its row is compute." % (1000.0 / mix_rate))
+	quit(0)
+
+# Noise floor plus a plosive at each onset, as stereo frames at the mix rate
+func _generate(onsets: PackedFloat64Array, seconds: float, rng: RandomNumberGenerator) -> PackedVector2Array:
+	# One voiced /a/ template: harmonics of 120 Hz shaped by its first formants
+	var length := int(PLOSIVE_SECONDS * mix_rate)
+	var vowel := PackedFloat32Array()
+	vowel.resize(length)
+	var harmonics := []
+	for h in range(1, int(4000.0 / 120.0)):
+		var f := 120.0 * h
+		var gain := 1.0 / (1.0 + pow((f - 730.0) / 90.0, 2)) + 0.5 / (1.0 + pow((f - 1090.0) / 110.0, 2)) + 0.2 / (1.0 + pow((f - 2440.0) / 160.0, 2))
+		harmonics.append([TAU * f / mix_rate, gain])
+	for n in length:
+		var t := float(n) / mix_rate
+		if t < 0.01:
+			continue
+		var envelope := minf(1.0, (t - 0.01) / 0.02) * exp(-maxf(0.0, t - 0.18) / 0.02)
+		var v := 0.0
+		for harmonic in harmonics:
+			v += harmonic[1] * sin(harmonic[0] * n)
+		vowel[n] = 0.3 * envelope * v
+
+	var frames := PackedVector2Array()
+	frames.resize(int(seconds * mix_rate))
+	for n in frames.size():
+		var s := NOISE_FLOOR * rng.randfn()
+		frames[n] = Vector2(s, s)
+	for t0 in onsets:
+		var start := int(round(t0 * mix_rate))
+		for n in length:
+			var t := float(n) / mix_rate
+			var s := vowel[n]
+			if t < 0.01:
+				s += 0.5 * rng.randfn() * exp(-t / 0.003) # The release burst
+			frames[start + n] += Vector2(s, s)
+	return frames
+
+# A mesh with one blend shape per viseme, for timing the demo's apply loop
+func _make_mesh(visemes: int) -> MeshInstance3D:
+	var mesh := ArrayMesh.new()
+	var arrays := []
+	arrays.resize(Mesh.ARRAY_MAX)
+	arrays[Mesh.ARRAY_VERTEX] = PackedVector3Array([Vector3.ZERO, Vector3.RIGHT, Vector3.UP])
+	var shapes := []
+	for v in visemes:
+		mesh.add_blend_shape("viseme_%d" % v)
+		var shape := []
+		shape.resize(Mesh.ARRAY_MAX)
+		shape[Mesh.ARRAY_VERTEX] = PackedVector3Array([Vector3.ZERO, Vector3.RIGHT, Vector3(0.0, 1.0 + 0.1 * v, 0.0)])
+		shapes.append(shape)
+	mesh.add_surface_from_arrays(Mesh.PRIMITIVE_TRIANGLES, arrays, shapes)
+	var instance := MeshInstance3D.new()
+	instance.mesh = mesh
+	return instance
+
+# Plays the audio frame by frame. One entry per frame that had audio to poll.
+func _run(context: LipSyncContext, audio: PackedVector2Array, mesh: MeshInstance3D, visemes: int) -> Array:
+	var was_tracking := LipSyncContext.is_latency_tracking()
+	LipSyncContext.set_latency_tracking(true)
+	var mapping := {}
+	var shape_indices := PackedInt32Array()
+	for v in visemes:
+		mapping[v] = "viseme_%d" % v
+		shape_indices.append(mesh.find_blend_shape_by_name(mapping[v]))
+	var blend_weights := {}
+	var weights := PackedFloat32Array()
+	weights.resize(visemes)
+
+	var calls := []
+	var consumed := 0
+	var pushed := 0.0
+	var frame := 0
+	while true:
+		frame += 1
+		var now := frame / fps
+		# Blocks the mixer has finished by now
+		var available := mini(int(now * mix_rate / block) * block, audio.size())
+		if available >= audio.size() and consumed >= audio.size():
+			break
+		if available <= consumed:
+			continue
+
+		LipSyncContext.reset_latency_stats()
+		var start := Time.get_ticks_usec()
+		var prediction := context.process(audio.slice(consumed, available), mix_rate)
+		var process_ms := (Time.get_ticks_usec() - start) / 1000.0
+		var stats := LipSyncContext.get_latency_stats()
+
+		# The demo's noise gate and smoothing, one shape per viseme
+		start = Time.get_ticks_usec()
+		if MicDemo.step_blend_weights(blend_weights, prediction, mapping, context.get_peak(), noise_gate, 1.0, smoothing):
+			for v in visemes:
+				weights[v] = blend_weights.get(mapping[v], 0.0)
+				if shape_indices[v] != -1:
+					mesh.set_blend_shape_value(shape_indices[v], weights[v])
+		var apply_ms := (Time.get_ticks_usec() - start) / 1000.0
+
+		var pushed_before := pushed
+		pushed = context.get_stream_time() + context.get_buffered_time()
+		calls.append({
+			"time": now,
+			"audio_start": float(consumed) / mix_rate,
+			"audio_end": float(available) / mix_rate,
+			"pushed_start": pushed_before,
+			"pushed_end": pushed,
+			"stream_time": context.get_stream_time(),
+			"prediction": prediction,
+			"weights": weights.duplicate(),
+			"process": process_ms,
+			"apply": apply_ms,
+			"resample": _stage_ms(stats["resample"]),
+			"features": _stage_ms(stats["features"]),
+			"inference": _stage_ms(stats["inference"]),
+		})
+		consumed = available
+	LipSyncContext.set_latency_tracking(was_tracking)
+	return calls
+
+# Time a stage took within one call; hops after the first are estimated at its median
+func _stage_ms(stage: Dictionary) -> float:
+	if stage["count"] == 0:
+		return 0.0
+	return (stage["max"] + stage["p50"] * (stage["count"] - 1)) / 1000.0
+
+# Stage times in ms for the plosive at t0, or empty if it got no clear response
+func _measure(calls: Array, t0: float) -> Dictionary:
+	# Baseline from the outputs in the 300 ms before the onset, the response 100-200 ms after
+	var baseline := _mean_output(calls, t0 - 0.3, t0, "prediction")
+	var response := _mean_output(calls, t0 + 0.1, t0 + 0.2, "prediction")
+	if baseline.is_empty() or response.is_empty():
+		return {}
+	var noise := 0.0
+	var noise_count := 0
+	for entry in calls:
+		if entry["audio_end"] >= t0 - 0.3 and entry["audio_end"] < t0 and entry["prediction"].size() > 0:
+			noise += _distance(entry["prediction"], baseline)
+			noise_count += 1
+	noise /= noise_count
+	var moved := _distance(response, baseline)
+	if moved < 2.0 * noise:
+		return {}
+	var threshold := noise + 0.5 * (moved - noise)
+
+	# First call holding the onset, and where the onset fell in the 16 kHz stream
+	var first := -1
+	for c in calls.size():
+		if calls[c]["audio_end"] > t0:
+			first = c
+			break
+	if first < 0:
+		return {}
+	var polled: Dictionary = calls[first]
+	var fraction: float = (t0 - polled["audio_start"]) / (polled["audio_end"] - polled["audio_start"])
+	var onset_stream: float = polled["pushed_start"] + fraction * (polled["pushed_end"] - polled["pushed_start"])
+	var hop_end := (floor(onset_stream / HOP) + 1.0) * HOP
+
+	var hop_call := -1
+	var responded := -1
+	for c in range(first, calls.size()):
+		if hop_call < 0 and calls[c]["stream_time"] >= hop_end - 1e-9:
+			hop_call = c
+		if hop_call >= 0 and calls[c]["prediction"].size() > 0 and _distance(calls[c]["prediction"], baseline) >= threshold:
+			responded = c
+			break
+	if responded < 0:
+		return {}
+
+	# The blend shape of the viseme that rose the most, halfway to where it settles
+	var best := 0
+	for v in response.size():
+		if response[v] - baseline[v] > response[best] - baseline[best]:
+			best = v
+	var weight_before := _mean_output(calls, t0 - 0.3, t0, "weights")
+	var weight_after := _mean_output(calls, t0 + 0.1, t0 + 0.2, "weights")
+	var blend_ms: float = calls[responded]["apply"]
+	if not weight_before.is_empty() and not weight_after.is_empty() and weight_after[best] - weight_before[best] > 0.02:
+		var halfway := 0.5 * (weight_before[best] + weight_after[best])
+		for c in range(responded, calls.size()):
+			if calls[c]["weights"][best] >= halfway:
+				blend_ms = (calls[c]["time"] - calls[responded]["time"]) * 1000.0 + calls[c]["apply"]
+				break
+
+	var block_end := (floor(round(t0 * mix_rate) / block) + 1.0) * block / mix_rate
+	var result := {
+		"capture": (block_end - t0) * 1000.0,
+		"polling": (calls[first]["time"] - block_end) * 1000.0,
+		"window": (calls[hop_call]["time"] - calls[first]["time"]) * 1000.0,
+		"model": (calls[responded]["time"] - calls[hop_call]["time"]) * 1000.0,
+		"processing": calls[responded]["process"],
+		"resample": calls[responded]["resample"],
+		"features": calls[responded]["features"],
+		"inference": calls[responded]["inference"],
+		"blend": blend_ms,
+	}
+	result["total"] = result["capture"] + result["polling"] + result["window"] + result["model"] + result["processing"] + result["blend"]
+	return result
+
+func _mean_output(calls: Array, from: float, to: float, key: String) -> PackedFloat32Array:
+	var mean := PackedFloat32Array()
+	var count := 0
+	for entry in calls:
+		var values: PackedFloat32Array = entry[key]
+		if entry["audio_end"] < from or entry["audio_end"] >= to or values.is_empty():
+			continue
+		if mean.is_empty():
+			mean.resize(values.size())
+		for v in mini(values.size(), mean.size()):
+			mean[v] += values[v]
+		count += 1
+	for v in mean.size():
+		mean[v] /= count
+	return mean
+
+func _distance(a: PackedFloat32Array, b: PackedFloat32Array) -> float:
+	var sum := 0.0
+	for v in mini(a.size(), b.size()):
+		sum += (a[v] - b[v]) * (a[v] - b[v])
+	return sqrt(sum)
+
+func _fail(message: String):
+	printerr(message)
+	quit(2)
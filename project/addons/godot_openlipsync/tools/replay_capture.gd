@@ -0,0 +1,145 @@
+extends SceneTree
+
+# Headless replay of a capture written by LipSyncContext.start_recording().
+# Re-drives the recorded calls on a fresh context, in order and with the same
+# audio blocks, and reports how long they took here against the field timings,
+# plus a digest of the outputs for comparing two builds.
+#
+#   godot --headless --path project -s res://addons/godot_openlipsync/tools/replay_capture.gd -- \
+#       <capture.olsc> [--model <path.onnx>] [--realtime] [--from-wav <file.wav>]
+#
+# Calls run back to back unless --realtime, which waits for each one's
+# recorded time. --model overrides the model named in the capture.
+# --from-wav first records a capture of that file, fed in uneven blocks as a
+# game's frame loop would, so the tool can check itself without a field log.
+#
+# Exits with 1 if a replay from --from-wav doesn't reproduce the recorded
+# outputs, 2 on bad arguments, a capture that won't open or a model that won't load.
+
+const DEFAULT_MODEL := "res://addons/godot_openlipsync/model.onnx"
+
+func _initialize():
+	var args := OS.get_cmdline_user_args()
+	var path := ""
+	var model_path := ""
+	var realtime := false
+	var wav_path := ""
+
+	var i := 0
+	while i < args.size():
+		var arg: String = args[i]
+		var value: String = args[i + 1] if i + 1 < args.size() else ""
+		match arg:
+			"--model":
+				model_path = value
+				i += 1
+			"--realtime":
+				realtime = true
+			"--from-wav":
+				wav_path = value
+				i += 1
+			_:
+				if arg.begins_with("--"):
+					_fail("Unknown option " + arg)
+					return
+				path = arg
+		i += 1
+
+	if path.is_empty():
+		_fail("Usage: -- <capture.olsc> [--model <path.onnx>] [--realtime] [--from-wav <file.wav>]")
+		return
+
+	var recorded_digest := ""
+	if not wav_path.is_empty():
+		recorded_digest = _record_wav(wav_path, path, model_path if not model_path.is_empty() else DEFAULT_MODEL)
+		if recorded_digest.is_empty():
+			return
+
+	var capture := LipSyncCapture.new()
+	if not capture.open(path):
+		_fail("Could not open capture " + path)
+		return
+	if model_path.is_empty():
+		model_path = capture.get_model_path() if not capture.get_model_path().is_empty() else DEFAULT_MODEL
+	var context := LipSyncContext.new()
+	if not context.load_model(model_path):
+		_fail("Could not load model " + model_path)
+		return
+	capture.configure(context)
+
+	var hashing := HashingContext.new()
+	hashing.start(HashingContext.HASH_SHA256)
+	var recorded := PackedFloat64Array()
+	var replayed := PackedFloat64Array()
+	var calls := 0
+	var outputs := 0
+	var last_time := 0.0
+	var start := Time.get_ticks_usec()
+	while capture.next():
+		if realtime:
+			var wait := int(capture.get_time() * 1e6) - (Time.get_ticks_usec() - start)
+			if wait > 0:
+				OS.delay_usec(wait)
+		var before := Time.get_ticks_usec()
+		var visemes := capture.replay(context)
+		if capture.get_call() != LipSyncCapture.CALL_RESET:
+			replayed.append(Time.get_ticks_usec() - before)
+			recorded.append(capture.get_recorded_usec())
+		if not visemes.is_empty():
+			hashing.update(visemes.to_byte_array())
+			outputs += 1
+		calls += 1
+		last_time = capture.get_time()
+	var wall := (Time.get_ticks_usec() - start) / 1e6
+	var digest := hashing.finish().hex_encode()
+
+	print("%s: %d calls over %.1f s, %d outputs, model %s" % [path, calls, last_time, outputs, model_path])
+	print("Replayed in %.2f s (%s)" % [wall, "real time" if realtime else "back to back"])
+	print("Per call, recorded: %s" % _percentiles(recorded))
+	print("Per call, replayed: %s" % _percentiles(replayed))
+	print("Output digest %s" % digest.substr(0, 16))
+	if not recorded_digest.is_empty() and recorded_digest != digest:
+		printerr("Replay FAILED: outputs differ from the recording (%s)" % recorded_digest.substr(0, 16))
+		quit(1)
+		return
+	quit(0)
+
+# Records the WAV file as a capture, in blocks of 5 to 40 ms, and returns the
+# digest of the outputs the recording context produced
+func _record_wav(wav_path: String, capture_path: String, model_path: String) -> String:
+	var samples := LipSyncBaker.decode_wav(FileAccess.get_file_as_bytes(wav_path))
+	if samples.is_empty():
+		_fail("No audio in " + wav_path)
+		return ""
+	var context := LipSyncContext.new()
+	if not context.load_model(model_path):
+		_fail("Could not load model " + model_path)
+		return ""
+	if not context.start_recording(capture_path):
+		_fail("Could not record to " + capture_path)
+		return ""
+	var hashing := HashingContext.new()
+	hashing.start(HashingContext.HASH_SHA256)
+	var rng := RandomNumberGenerator.new()
+	rng.seed = 1
+	var offset := 0
+	while offset < samples.size():
+		var block := mini(rng.randi_range(80, 640), samples.size() - offset)
+		var visemes := context.process_mono(samples.slice(offset, offset + block), 16000)
+		if not visemes.is_empty():
+			hashing.update(visemes.to_byte_array())
+		offset += block
+	print("Recorded %d calls from %s" % [context.get_recorded_calls(), wav_path])
+	context.stop_recording()
+	return hashing.finish().hex_encode()
+
+func _percentiles(values: PackedFloat64Array) -> String:
+	if values.is_empty():
+		return "no calls"
+	values.sort()
+	var at := func(q: float) -> float: return values[mini(int(q * values.size()), values.size() - 1)]
+	return "p50 %.0f us, p99 %.0f us, max %.0f us" % [at.call(0.5), at.call(0.99), values[-1]]
+
+func _fail(message: String):
+	printerr(message)
+	quit(2)
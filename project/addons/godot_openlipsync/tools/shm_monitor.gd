@@ -0,0 +1,110 @@
+extends SceneTree
+
+# Headless consumer for a shared-memory audio ring (see src/openlipsync_shm.h).
+# Polls it like a game would, once per frame through a LipSyncContext, and
+# reports throughput, drops and producer-to-consumer handoff time.
+#
+#   godot --headless --path project -s res://addons/godot_openlipsync/tools/shm_monitor.gd -- \
+#       <ring name> [--producer <executable>] [--seconds <n>] [--model <path.onnx>]
+#
+# --producer starts that program with the ring name as its only argument (for
+# example shm_producer/example_producer) and stops it at the end, so one
+# command runs both processes.
+#
+# Exits with 1 if no audio arrived, 2 on bad arguments, a model that won't load
+# or a ring that never appeared.
+
+const DEFAULT_MODEL := "res://addons/godot_openlipsync/model.onnx"
+
+var source := LipSyncShmSource.new()
+var producer_pid := -1
+var seconds := 5.0
+var elapsed := 0.0
+var frames := 0
+var silent_polls := 0
+var handoffs := PackedFloat64Array()
+
+func _initialize():
+	var args := OS.get_cmdline_user_args()
+	var ring := ""
+	var producer := ""
+	var model_path := DEFAULT_MODEL
+
+	var i := 0
+	while i < args.size():
+		var arg: String = args[i]
+		var value: String = args[i + 1] if i + 1 < args.size() else ""
+		match arg:
+			"--producer":
+				producer = value
+				i += 1
+			"--seconds":
+				seconds = float(value)
+				i += 1
+			"--model":
+				model_path = value
+				i += 1
+			_:
+				if arg.begins_with("--"):
+					_fail("Unknown option " + arg)
+					return
+				ring = arg
+		i += 1
+
+	if ring.is_empty() or seconds <= 0.0:
+		_fail("Usage: -- <ring name> [--producer <executable>] [--seconds <n>] [--model <path.onnx>]")
+		return
+
+	var context := LipSyncContext.new()
+	if not context.load_model(model_path):
+		_fail("Could not load model " + model_path)
+		return
+	source.set_context(context)
+
+	if not producer.is_empty():
+		producer_pid = OS.create_process(producer, [ring])
+		if producer_pid < 0:
+			_fail("Could not start " + producer)
+			return
+	# Give a just-started producer a moment to create the ring
+	var deadline := Time.get_ticks_msec() + 2000
+	while not source.open(ring):
+		if Time.get_ticks_msec() > deadline:
+			_stop_producer()
+			_fail("No ring named " + ring)
+			return
+		OS.delay_msec(50)
+	print("Reading %s: %d Hz, %d channels" % [ring, source.get_sample_rate(), source.get_channels()])
+
+func _process(delta: float) -> bool:
+	if not source.is_open():
+		return true
+	elapsed += delta
+	source.poll()
+	if source.get_frames_read() > frames:
+		handoffs.append(source.get_handoff_usec())
+	else:
+		silent_polls += 1
+	frames = source.get_frames_read()
+	if elapsed < seconds:
+		return false
+
+	handoffs.sort()
+	var median := handoffs[handoffs.size() / 2] if not handoffs.is_empty() else 0.0
+	var worst := handoffs[-1] if not handoffs.is_empty() else 0.0
+	print("%d frames in %.1f s (%.0f frames/s), %d dropped by the producer, %d polls found nothing" % [
+		frames, elapsed, frames / elapsed, source.get_dropped(), silent_polls])
+	print("Handoff: median %.0f us, max %.0f us (bounded by the poll interval, not the ring)" % [median, worst])
+	source.close()
+	_stop_producer()
+	quit(0 if frames > 0 else 1)
+	return true
+
+func _stop_producer():
+	if producer_pid >= 0:
+		OS.kill(producer_pid)
+		producer_pid = -1
+
+func _fail(message: String):
+	printerr(message)
+	quit(2)
@@ -0,0 +1,101 @@
+/*
+ * Streams audio into an OpenLipSync shared-memory ring in real time, 10 ms
+ * per write, for trying LipSyncShmSource without a voice chat client:
+ *
+ *   cc -O2 -I../src example_producer.c olsync_producer.c -o example_producer
+ *   ./example_producer /olsync_voice [raw.s16] [sample_rate]
+ *
+ * raw.s16 is headerless mono 16-bit PCM (ffmpeg -i in.wav -f s16le -ac 1 raw.s16),
+ * looped; without it a syllable-like tone pattern is generated. Runs until
+ * interrupted, then removes the ring.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "openlipsync_shm.h"
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const double PI = 3.14159265358979323846;
+
+static volatile sig_atomic_t running = 1;
+
+static void on_signal(int p_signal) {
+    (void)p_signal;
+    running = 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s /ring_name [raw.s16] [sample_rate]\n", argv[0]);
+        return 2;
+    }
+    const uint32_t rate = argc > 3 ? (uint32_t)atoi(argv[3]) : 48000;
+    int16_t *clip = NULL;
+    size_t clip_frames = 0;
+    if (argc > 2) {
+        FILE *file = fopen(argv[2], "rb");
+        if (!file) {
+            perror(argv[2]);
+            return 1;
+        }
+        fseek(file, 0, SEEK_END);
+        clip_frames = (size_t)ftell(file) / 2;
+        fseek(file, 0, SEEK_SET);
+        clip = (int16_t *)malloc(clip_frames * 2);
+        clip_frames = fread(clip, 2, clip_frames, file);
+        fclose(file);
+        if (clip_frames == 0) {
+            fprintf(stderr, "%s: no audio\n", argv[2]);
+            return 1;
+        }
+    }
+
+    /* Half a second of headroom for a consumer that skips a few frames */
+    olsync_producer *producer = olsync_producer_create(argv[1], rate, 1, rate / 2, OLSYNC_SHM_FORMAT_S16);
+    if (!producer) {
+        perror("olsync_producer_create");
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    printf("Writing %u Hz mono to %s\n", rate, argv[1]);
+    fflush(stdout);
+
+    const size_t block = rate / 100;
+    int16_t *pcm = (int16_t *)malloc(block * 2);
+    uint64_t frame = 0;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (running) {
+        for (size_t i = 0; i < block; i++, frame++) {
+            if (clip) {
+                pcm[i] = clip[frame % clip_frames];
+            } else {
+                /* Four syllables a second with a drifting pitch, then a pause */
+                const double t = (double)frame / rate;
+                const double syllable = fmod(t, 0.25) / 0.25;
+                const double envelope = fmod(t, 2.0) < 1.5 ? sin(PI * syllable) : 0.0;
+                const double pitch = 140.0 + 30.0 * sin(t * 2.0);
+                pcm[i] = (int16_t)(8000.0 * envelope * (sin(2.0 * PI * pitch * t) + 0.5 * sin(4.0 * PI * pitch * t)));
+            }
+        }
+        olsync_producer_write(producer, pcm, block);
+
+        next.tv_nsec += 10000000;
+        if (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+
+    olsync_producer_destroy(producer);
+    free(pcm);
+    free(clip);
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Producer side of the OpenLipSync shared-memory ring, see
+ * src/openlipsync_shm.h for the layout. POSIX only.
+ *
+ *   cc -O2 -c -I../src olsync_producer.c    (link with -lrt on older glibc)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "openlipsync_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+struct olsync_producer {
+    char *name;
+    olsync_shm_header *header;
+    uint8_t *data;
+    size_t size;
+    size_t frame_bytes;
+};
+
+static uint64_t olsync_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+olsync_producer *olsync_producer_create(const char *p_name, uint32_t p_sample_rate, uint32_t p_channels, uint32_t p_capacity, uint32_t p_format) {
+    if (!p_name || p_sample_rate == 0 || p_channels == 0 || p_capacity == 0 || p_capacity > (1u << 30) ||
+            (p_format != OLSYNC_SHM_FORMAT_F32 && p_format != OLSYNC_SHM_FORMAT_S16)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    uint32_t capacity = 1;
+    while (capacity < p_capacity) {
+        capacity <<= 1;
+    }
+
+    olsync_producer *producer = (olsync_producer *)calloc(1, sizeof(olsync_producer));
+    if (!producer) {
+        return NULL;
+    }
+    producer->name = strdup(p_name);
+    producer->size = olsync_shm_size(capacity, p_channels, p_format);
+    producer->frame_bytes = p_channels * olsync_shm_sample_size(p_format);
+
+    /* A stale ring from a crashed producer is replaced, not reused */
+    shm_unlink(p_name);
+    int fd = shm_open(p_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, (off_t)producer->size) != 0) {
+        int error = errno;
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(p_name);
+        }
+        free(producer->name);
+        free(producer);
+        errno = error;
+        return NULL;
+    }
+    void *memory = mmap(NULL, producer->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        int error = errno;
+        shm_unlink(p_name);
+        free(producer->name);
+        free(producer);
+        errno = error;
+        return NULL;
+    }
+
+    producer->header = (olsync_shm_header *)memory;
+    producer->data = (uint8_t *)memory + OLSYNC_SHM_DATA_OFFSET;
+    olsync_shm_header *header = producer->header;
+    header->version = OLSYNC_SHM_VERSION;
+    header->sample_rate = p_sample_rate;
+    header->channels = p_channels;
+    header->capacity = capacity;
+    header->format = p_format;
+    /* The consumer checks the magic last, so it never sees a half-written header */
+    __atomic_store_n(&header->magic, OLSYNC_SHM_MAGIC, __ATOMIC_RELEASE);
+    return producer;
+}
+
+size_t olsync_producer_write(olsync_producer *p_producer, const void *p_frames, size_t p_count) {
+    olsync_shm_header *header = p_producer->header;
+    const uint64_t capacity = header->capacity;
+    const uint64_t write_pos = header->write_pos; /* Only this side writes it */
+    const uint64_t read_pos = __atomic_load_n(&header->read_pos, __ATOMIC_ACQUIRE);
+    const uint64_t space = capacity - (write_pos - read_pos);
+    const size_t count = p_count < space ? p_count : (size_t)space;
+
+    /* Up to two copies: to the end of the ring, then from its start */
+    const uint64_t start = write_pos & (capacity - 1);
+    const size_t first = (size_t)(count < capacity - start ? count : capacity - start);
+    memcpy(p_producer->data + start * p_producer->frame_bytes, p_frames, first * p_producer->frame_bytes);
+    memcpy(p_producer->data, (const uint8_t *)p_frames + first * p_producer->frame_bytes, (count - first) * p_producer->frame_bytes);
+
+    if (count < p_count) {
+        __atomic_fetch_add(&header->dropped, (uint64_t)(p_count - count), __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&header->write_time, olsync_now_ns(), __ATOMIC_RELAXED);
+    __atomic_store_n(&header->write_pos, write_pos + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+size_t olsync_producer_pending(const olsync_producer *p_producer) {
+    const olsync_shm_header *header = p_producer->header;
+    return (size_t)(header->write_pos - __atomic_load_n(&header->read_pos, __ATOMIC_ACQUIRE));
+}
+
+void olsync_producer_destroy(olsync_producer *p_producer) {
+    if (!p_producer) {
+        return;
+    }
+    munmap(p_producer->header, p_producer->size);
+    shm_unlink(p_producer->name);
+    free(p_producer->name);
+    free(p_producer);
+}
@@ -3,8 +3,8 @@
 
 #include <godot_cpp/classes/ref_counted.hpp>
 #include <godot_cpp/variant/packed_float32_array.hpp>
+#include "mel_frontend.h"
 #include <vector>
-#include <complex>
 
 namespace godot {
 
@@ -12,40 +12,15 @@ class AudioProcessor : public RefCounted {
     GDCLASS(AudioProcessor, RefCounted)
 
 private:
-    // Config
-    int sample_rate = 16000;
-    int hop_length = 160;   // 10ms at 16kHz
-    int window_length = 400; // 25ms at 16kHz
-    int n_fft = 1024;
-    int n_mels = 80;
-    float f_min = 50.0f;
-    float f_max = 8000.0f;
+    // Config, window, FFT tables and mel filter bank
+    mel_frontend::Frontend frontend;
 
     // Buffers
-    std::vector<float> window;
     std::vector<float> window_buffer;
     std::vector<float> previous_samples;
-    std::vector<float> fft_buffer; // For FFT input/output logic if needed
-    
-    // Mel Filter Bank: flattened [n_mels * (n_fft/2 + 1)]
-    // Stored as row-major: filter_bank[mel_idx * (n_fft/2 + 1) + bin_idx]
-    std::vector<float> mel_filter_bank;
-
-    // FFT State
-    // Using std::complex for internal FFT implementation
-    std::vector<std::complex<float>> fft_input;
-    std::vector<std::complex<float>> fft_output;
-    std::vector<int> bit_reverse_table;
-    std::vector<std::complex<float>> trig_tables;
+    PackedFloat32Array band_energy; // Last frame's mel band energies (dB)
 
-    // Internal methods
-    void init_window();
-    void init_mel_filter_bank();
-    void init_fft();
-    void perform_fft(std::vector<std::complex<float>>& data);
-    
-    float hz_to_mel(float hz);
-    float mel_to_hz(float mel);
+    void _configure(const mel_frontend::Config &p_config);
 
 protected:
     static void _bind_methods();
@@ -61,11 +36,22 @@ public:
     void set_window_length(int p_length);
     void set_mel_bands(int p_bands);
     void set_frequency_range(float p_min, float p_max);
+    const mel_frontend::Config &get_config() const { return frontend.get_config(); }
     
     // Main processing
     // Takes exactly hop_length samples. 
     // Maintains internal state for overlapping windows.
     PackedFloat32Array process_frame(const PackedFloat32Array &p_samples);
+    // Mel band energies of the last process_frame() in dB, before the
+    // per-frame normalisation removes the overall level
+    PackedFloat32Array get_band_energy() const { return band_energy; }
+
+    // Offline processing of a whole clip, frame-major [frames * n_mels].
+    // Same features as calling process_frame() on every hop after a reset().
+    // Batched frames and windows all hops and runs them through a DFT-mel GEMM,
+    // which matches the FFT path to float rounding and is much faster on long
+    // clips. Does not touch the streaming state.
+    PackedFloat32Array process_clip(const PackedFloat32Array &p_samples, bool p_batched = true);
     
     // Reset internal state (overlap buffer)
     void reset();
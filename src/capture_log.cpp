@@ -0,0 +1,149 @@
+#include "capture_log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace capture_log {
+
+static const char MAGIC[] = "OLSC";
+static const uint32_t VERSION = 1;
+// The thread wakes at this much queued data, and at least every FLUSH_INTERVAL
+static const size_t FLUSH_BYTES = 256 << 10;
+static const std::chrono::milliseconds FLUSH_INTERVAL(100);
+// About three minutes of 48 kHz stereo float; a disk this far behind ends the capture
+static const size_t MAX_QUEUED_BYTES = 64 << 20;
+
+uint64_t ticks_usec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool Writer::open(const std::string &p_path, int p_context_size, int p_n_mels, uint32_t p_flags, const std::string &p_model_path) {
+    close();
+    file.open(std::filesystem::u8path(p_path), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        file.close();
+        return false;
+    }
+
+    Header header = {};
+    memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.start_unix_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    header.context_size = p_context_size;
+    header.n_mels = p_n_mels;
+    header.flags = p_flags;
+    header.model_path_bytes = (uint32_t)p_model_path.size();
+    file.write((const char *)&header, sizeof(header));
+    file.write(p_model_path.data(), (std::streamsize)p_model_path.size());
+    start_usec = ticks_usec();
+    bytes_written = sizeof(header) + p_model_path.size();
+    records = 0;
+    if (!file) {
+        close();
+        return false;
+    }
+    // Room for a wake-up's worth and then some, so the hot path doesn't reallocate
+    queue.reserve(FLUSH_BYTES * 2);
+    closing = false;
+    failed = false;
+    thread = std::thread(&Writer::_write_loop, this);
+    return true;
+}
+
+void Writer::_write_loop() {
+    std::vector<char> chunk;
+    chunk.reserve(FLUSH_BYTES * 2);
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    while (true) {
+        queue_cond.wait_for(lock, FLUSH_INTERVAL, [this]() { return closing || queue.size() >= FLUSH_BYTES; });
+        const bool last = closing;
+        chunk.swap(queue);
+        lock.unlock();
+        if (!chunk.empty() && !failed) {
+            file.write(chunk.data(), (std::streamsize)chunk.size());
+            file.flush();
+            if (!file) {
+                failed = true;
+            }
+        }
+        // Keeps its capacity, so the two buffers stop growing once warm
+        chunk.clear();
+        lock.lock();
+        if (last) {
+            return;
+        }
+    }
+}
+
+bool Writer::write(Kind p_kind, int p_channels, int p_sample_rate, const void *p_payload, size_t p_bytes,
+        uint64_t p_start_usec, uint64_t p_duration_usec) {
+    if (!file.is_open() || failed) {
+        return false;
+    }
+    RecordHeader record = {};
+    record.kind = p_kind;
+    record.channels = (uint8_t)std::clamp(p_channels, 0, 255);
+    record.sample_rate = p_sample_rate;
+    record.time_usec = p_start_usec > start_usec ? p_start_usec - start_usec : 0;
+    record.payload_bytes = (uint32_t)p_bytes;
+    record.duration_usec = (uint32_t)std::min<uint64_t>(p_duration_usec, UINT32_MAX);
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (queue.size() + sizeof(record) + p_bytes > MAX_QUEUED_BYTES) {
+            return false;
+        }
+        queue.insert(queue.end(), (const char *)&record, (const char *)&record + sizeof(record));
+        queue.insert(queue.end(), (const char *)p_payload, (const char *)p_payload + p_bytes);
+        wake = queue.size() >= FLUSH_BYTES;
+    }
+    if (wake) {
+        queue_cond.notify_one();
+    }
+    bytes_written += sizeof(record) + p_bytes;
+    records++;
+    return true;
+}
+
+void Writer::close() {
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            closing = true;
+        }
+        queue_cond.notify_one();
+        thread.join();
+    }
+    queue.clear();
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+}
+
+bool Reader::open(const std::string &p_path) {
+    close();
+    file.clear();
+    file.open(std::filesystem::u8path(p_path), std::ios::binary);
+    if (!file.read((char *)&header, sizeof(header)) || memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION) {
+        close();
+        return false;
+    }
+    model_path.resize(header.model_path_bytes);
+    if (!file.read(&model_path[0], (std::streamsize)model_path.size())) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool Reader::next(RecordHeader &r_record, std::vector<uint8_t> &r_payload) {
+    if (!file.is_open() || !file.read((char *)&r_record, sizeof(r_record)) || r_record.kind > KIND_RESET) {
+        return false;
+    }
+    r_payload.resize(r_record.payload_bytes);
+    return r_payload.empty() || (bool)file.read((char *)r_payload.data(), (std::streamsize)r_payload.size());
+}
+
+} // namespace capture_log
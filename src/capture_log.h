@@ -0,0 +1,126 @@
+#ifndef CAPTURE_LOG_H
+#define CAPTURE_LOG_H
+
+// Binary log of the calls made on a LipSyncContext, for replaying a field
+// session call for call: every process call's audio block exactly as it was
+// passed in, its source sample rate and when it happened.
+// Has no Godot dependencies.
+//
+// File layout (little endian):
+//   header (32 bytes): "OLSC", u32 version, u64 start_unix_usec,
+//     i32 context_size, i32 n_mels, u32 flags (FLAG_*), u32 model_path_bytes
+//   model_path (UTF-8, model_path_bytes, no terminator)
+//   records until the end of the file, each a 24-byte RecordHeader then
+//   payload_bytes of payload:
+//     KIND_FRAMES  stereo float32 pairs, as process() got them
+//     KIND_MONO    float32 samples (process_mono)
+//     KIND_PCM16   interleaved int16, channels wide (process_pcm16)
+//     KIND_RESET   no payload
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace capture_log {
+
+enum Kind : uint8_t {
+    KIND_FRAMES = 0,
+    KIND_MONO = 1,
+    KIND_PCM16 = 2,
+    KIND_RESET = 3,
+};
+
+enum Flags : uint32_t {
+    FLAG_HALF_HISTORY = 1,
+};
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t start_unix_usec; // Wall clock at the start, to line up with other logs
+    int32_t context_size;
+    int32_t n_mels;
+    uint32_t flags;
+    uint32_t model_path_bytes;
+};
+static_assert(sizeof(Header) == 32, "capture log header layout");
+
+struct RecordHeader {
+    uint8_t kind;
+    uint8_t channels;
+    uint16_t reserved;
+    int32_t sample_rate;
+    uint64_t time_usec; // Since the recording started, on a monotonic clock
+    uint32_t payload_bytes;
+    uint32_t duration_usec; // Time the call took, for comparing against a replay
+};
+static_assert(sizeof(RecordHeader) == 24, "capture log record layout");
+
+// Records are queued in memory and written by a thread of its own, so the
+// calling (game or audio) thread never waits on the disk.
+class Writer {
+    std::ofstream file;
+    uint64_t start_usec = 0;
+    uint64_t bytes_written = 0;
+    uint64_t records = 0;
+
+    // Filled by write(), swapped out and written by the thread
+    std::vector<char> queue;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cond;
+    bool closing = false;
+    std::atomic<bool> failed{false};
+    std::thread thread;
+
+    void _write_loop();
+
+public:
+    Writer() {}
+    ~Writer() { close(); }
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    // Creates (or truncates) the log and writes its header
+    bool open(const std::string &p_path, int p_context_size, int p_n_mels, uint32_t p_flags, const std::string &p_model_path);
+    // Queues one call that started at p_start_usec (ticks_usec()) and took
+    // p_duration_usec; only copies it. False once the file can't be written or
+    // the disk has fallen MAX_QUEUED_BYTES behind.
+    bool write(Kind p_kind, int p_channels, int p_sample_rate, const void *p_payload, size_t p_bytes,
+            uint64_t p_start_usec, uint64_t p_duration_usec);
+    // Writes what is queued and closes the file
+    void close();
+
+    bool is_open() const { return file.is_open(); }
+    uint64_t get_bytes_written() const { return bytes_written; }
+    uint64_t get_records() const { return records; }
+};
+
+class Reader {
+    std::ifstream file;
+    Header header = {};
+    std::string model_path;
+
+public:
+    // False if the file is missing or not a capture log of this version
+    bool open(const std::string &p_path);
+    void close() { file.close(); }
+
+    const Header &get_header() const { return header; }
+    const std::string &get_model_path() const { return model_path; }
+    // Reads the next record; false at the end of the file or on a truncated
+    // record (a capture cut off by a crash ends at its last whole record)
+    bool next(RecordHeader &r_record, std::vector<uint8_t> &r_payload);
+};
+
+// Microseconds on the monotonic clock the records are stamped with
+uint64_t ticks_usec();
+
+} // namespace capture_log
+
+#endif
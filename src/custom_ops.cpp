@@ -0,0 +1,452 @@
+#include "custom_ops.h"
+#include "mel_frontend.h"
+#include "onnx_graph.h"
+#include <onnxruntime_lite_custom_op.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// Compiled for AVX2 + FMA and AVX-512 regardless of the build flags, picked at runtime
+#define CUSTOM_OPS_AVX2 1
+#define CUSTOM_OPS_AVX2_TARGET __attribute__((target("avx2,fma")))
+#define CUSTOM_OPS_AVX512 1
+#define CUSTOM_OPS_AVX512_TARGET __attribute__((target("avx512f")))
+#elif defined(__AVX2__)
+// MSVC only emits AVX2 when the whole build allows it (/arch:AVX2)
+#define CUSTOM_OPS_AVX2 1
+#define CUSTOM_OPS_AVX2_TARGET
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CUSTOM_OPS_NEON 1
+#endif
+
+namespace custom_ops {
+
+// Register tile: TILE_CO output channels x TILE_T frames of accumulators.
+// Weights are packed in panels of TILE_CO output channels so the inner loop
+// reads them sequentially.
+#if defined(CUSTOM_OPS_AVX2)
+static const int64_t TILE_CO = 12;
+static const int64_t TILE_T = 16; // Two passes of 6 x 2 ymm accumulators
+static const int64_t WIDE_TILE_T = 32; // 12 x 2 zmm accumulators, same weight panels
+#elif defined(CUSTOM_OPS_NEON)
+static const int64_t TILE_CO = 8;
+static const int64_t TILE_T = 8; // 8 x 2 q accumulators
+#else
+static const int64_t TILE_CO = 4;
+static const int64_t TILE_T = 8;
+#endif
+#if !defined(CUSTOM_OPS_AVX2)
+static const int64_t WIDE_TILE_T = TILE_T;
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+// Fully unrolled so the accumulator arrays live in registers
+#define CUSTOM_OPS_UNROLL _Pragma("GCC unroll 16")
+#else
+#define CUSTOM_OPS_UNROLL
+#endif
+
+struct ConvArgs {
+    const float *xs; // One shifted copy of each input row per tap, see causal_conv1d()
+    int64_t xs_stride;
+    int64_t depth; // C_in * K rows in xs
+    const float *w; // Packed panels
+    const float *bias;
+    const float *residual;
+    int64_t residual_stride;
+    float *y;
+    int64_t out_channels;
+    int64_t frames;
+    bool relu;
+};
+
+// Adds bias and residual, applies the activation and writes the valid part of
+// a tile. Shared by every path, it is a small fraction of the tile's work.
+static void _store_tile(const ConvArgs &p_args, const float *p_acc, int64_t p_width, int64_t p_co0, int64_t p_t0) {
+    int64_t co_count = std::min(TILE_CO, p_args.out_channels - p_co0);
+    int64_t t_count = std::min(p_width, p_args.frames - p_t0);
+    const float floor = p_args.relu ? 0.0f : -std::numeric_limits<float>::infinity();
+    for (int64_t r = 0; r < co_count; r++) {
+        int64_t co = p_co0 + r;
+        float bias = p_args.bias[co];
+        float *y = p_args.y + co * p_args.frames + p_t0;
+        const float *acc = p_acc + r * p_width;
+        // Relu as a max against a floor, so it compiles to maxps instead of a
+        // compare-and-branch that mispredicts on every other activation
+        if (p_args.residual) {
+            const float *residual = p_args.residual + co * p_args.residual_stride + p_t0;
+            for (int64_t j = 0; j < t_count; j++) {
+                y[j] = std::max(acc[j] + bias + residual[j], floor);
+            }
+        } else {
+            for (int64_t j = 0; j < t_count; j++) {
+                y[j] = std::max(acc[j] + bias, floor);
+            }
+        }
+    }
+}
+
+static void _tile_scalar(const ConvArgs &p_args, int64_t p_co0, int64_t p_t0) {
+    float acc[TILE_CO][TILE_T] = {};
+    const float *w = p_args.w + p_co0 * p_args.depth;
+    const float *x = p_args.xs + p_t0;
+    for (int64_t i = 0; i < p_args.depth; i++, x += p_args.xs_stride, w += TILE_CO) {
+        for (int64_t r = 0; r < TILE_CO; r++) {
+            for (int64_t j = 0; j < TILE_T; j++) {
+                acc[r][j] += w[r] * x[j];
+            }
+        }
+    }
+    _store_tile(p_args, acc[0], TILE_T, p_co0, p_t0);
+}
+
+#if defined(CUSTOM_OPS_AVX2)
+CUSTOM_OPS_AVX2_TARGET static void _tile_avx2(const ConvArgs &p_args, int64_t p_co0, int64_t p_t0) {
+    // 16 ymm registers only fit half a panel: 6 rows x 16 frames at a time
+    const int HALF = TILE_CO / 2;
+    alignas(32) float out[TILE_CO][TILE_T];
+    for (int half = 0; half < 2; half++) {
+        __m256 acc[HALF][2];
+        CUSTOM_OPS_UNROLL
+        for (int r = 0; r < HALF; r++) {
+            acc[r][0] = _mm256_setzero_ps();
+            acc[r][1] = _mm256_setzero_ps();
+        }
+        const float *w = p_args.w + p_co0 * p_args.depth + half * HALF;
+        const float *x = p_args.xs + p_t0;
+        for (int64_t i = 0; i < p_args.depth; i++, x += p_args.xs_stride, w += TILE_CO) {
+            __m256 x0 = _mm256_load_ps(x);
+            __m256 x1 = _mm256_load_ps(x + 8);
+            CUSTOM_OPS_UNROLL
+            for (int r = 0; r < HALF; r++) {
+                __m256 wv = _mm256_broadcast_ss(w + r);
+                acc[r][0] = _mm256_fmadd_ps(wv, x0, acc[r][0]);
+                acc[r][1] = _mm256_fmadd_ps(wv, x1, acc[r][1]);
+            }
+        }
+        CUSTOM_OPS_UNROLL
+        for (int r = 0; r < HALF; r++) {
+            _mm256_store_ps(out[half * HALF + r], acc[r][0]);
+            _mm256_store_ps(out[half * HALF + r] + 8, acc[r][1]);
+        }
+    }
+    _store_tile(p_args, out[0], TILE_T, p_co0, p_t0);
+}
+
+static bool _has_avx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+#else
+    return true;
+#endif
+}
+#endif
+
+#if defined(CUSTOM_OPS_AVX512)
+// Same panel over 32 frames, for the hosts where ORT's own kernels use AVX-512
+CUSTOM_OPS_AVX512_TARGET static void _tile_avx512(const ConvArgs &p_args, int64_t p_co0, int64_t p_t0) {
+    __m512 acc[TILE_CO][2];
+    CUSTOM_OPS_UNROLL
+    for (int r = 0; r < TILE_CO; r++) {
+        acc[r][0] = _mm512_setzero_ps();
+        acc[r][1] = _mm512_setzero_ps();
+    }
+    const float *w = p_args.w + p_co0 * p_args.depth;
+    const float *x = p_args.xs + p_t0;
+    for (int64_t i = 0; i < p_args.depth; i++, x += p_args.xs_stride, w += TILE_CO) {
+        __m512 x0 = _mm512_load_ps(x);
+        __m512 x1 = _mm512_load_ps(x + 16);
+        CUSTOM_OPS_UNROLL
+        for (int r = 0; r < TILE_CO; r++) {
+            __m512 wv = _mm512_set1_ps(w[r]);
+            acc[r][0] = _mm512_fmadd_ps(wv, x0, acc[r][0]);
+            acc[r][1] = _mm512_fmadd_ps(wv, x1, acc[r][1]);
+        }
+    }
+
+    alignas(64) float out[TILE_CO][WIDE_TILE_T];
+    CUSTOM_OPS_UNROLL
+    for (int r = 0; r < TILE_CO; r++) {
+        _mm512_store_ps(out[r], acc[r][0]);
+        _mm512_store_ps(out[r] + 16, acc[r][1]);
+    }
+    _store_tile(p_args, out[0], WIDE_TILE_T, p_co0, p_t0);
+}
+
+static bool _has_avx512() {
+    static const bool supported = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+}
+#endif
+
+#if defined(CUSTOM_OPS_NEON)
+static void _tile_neon(const ConvArgs &p_args, int64_t p_co0, int64_t p_t0) {
+    float32x4_t acc[TILE_CO][2];
+    CUSTOM_OPS_UNROLL
+    for (int r = 0; r < TILE_CO; r++) {
+        acc[r][0] = vdupq_n_f32(0.0f);
+        acc[r][1] = vdupq_n_f32(0.0f);
+    }
+    const float *w = p_args.w + p_co0 * p_args.depth;
+    const float *x = p_args.xs + p_t0;
+    for (int64_t i = 0; i < p_args.depth; i++, x += p_args.xs_stride, w += TILE_CO) {
+        float32x4_t x0 = vld1q_f32(x);
+        float32x4_t x1 = vld1q_f32(x + 4);
+        float32x4_t w0 = vld1q_f32(w);
+        float32x4_t w1 = vld1q_f32(w + 4);
+        acc[0][0] = vfmaq_laneq_f32(acc[0][0], x0, w0, 0);
+        acc[0][1] = vfmaq_laneq_f32(acc[0][1], x1, w0, 0);
+        acc[1][0] = vfmaq_laneq_f32(acc[1][0], x0, w0, 1);
+        acc[1][1] = vfmaq_laneq_f32(acc[1][1], x1, w0, 1);
+        acc[2][0] = vfmaq_laneq_f32(acc[2][0], x0, w0, 2);
+        acc[2][1] = vfmaq_laneq_f32(acc[2][1], x1, w0, 2);
+        acc[3][0] = vfmaq_laneq_f32(acc[3][0], x0, w0, 3);
+        acc[3][1] = vfmaq_laneq_f32(acc[3][1], x1, w0, 3);
+        acc[4][0] = vfmaq_laneq_f32(acc[4][0], x0, w1, 0);
+        acc[4][1] = vfmaq_laneq_f32(acc[4][1], x1, w1, 0);
+        acc[5][0] = vfmaq_laneq_f32(acc[5][0], x0, w1, 1);
+        acc[5][1] = vfmaq_laneq_f32(acc[5][1], x1, w1, 1);
+        acc[6][0] = vfmaq_laneq_f32(acc[6][0], x0, w1, 2);
+        acc[6][1] = vfmaq_laneq_f32(acc[6][1], x1, w1, 2);
+        acc[7][0] = vfmaq_laneq_f32(acc[7][0], x0, w1, 3);
+        acc[7][1] = vfmaq_laneq_f32(acc[7][1], x1, w1, 3);
+    }
+
+    float out[TILE_CO][TILE_T];
+    CUSTOM_OPS_UNROLL
+    for (int r = 0; r < TILE_CO; r++) {
+        vst1q_f32(out[r], acc[r][0]);
+        vst1q_f32(out[r] + 4, acc[r][1]);
+    }
+    _store_tile(p_args, out[0], TILE_T, p_co0, p_t0);
+}
+#endif
+
+const char *simd_path() {
+#if defined(CUSTOM_OPS_AVX512)
+    if (_has_avx512()) {
+        return "avx512";
+    }
+#endif
+#if defined(CUSTOM_OPS_AVX2)
+    if (_has_avx2()) {
+        return "avx2";
+    }
+#elif defined(CUSTOM_OPS_NEON)
+    return "neon";
+#endif
+    return "scalar";
+}
+
+std::vector<float> pack_conv_weights(const float *p_w, int64_t p_out_channels, int64_t p_in_channels, int64_t p_kernel) {
+    // [C_out, C_in, K] -> [C_out / TILE_CO][C_in][K][TILE_CO], the last panel zero filled
+    const int64_t panels = (p_out_channels + TILE_CO - 1) / TILE_CO;
+    const int64_t depth = p_in_channels * p_kernel;
+    std::vector<float> packed((size_t)(panels * depth * TILE_CO), 0.0f);
+    for (int64_t co = 0; co < p_out_channels; co++) {
+        float *panel = packed.data() + (co / TILE_CO) * depth * TILE_CO + co % TILE_CO;
+        for (int64_t i = 0; i < depth; i++) {
+            panel[i * TILE_CO] = p_w[co * depth + i];
+        }
+    }
+    return packed;
+}
+
+void causal_conv1d(const float *p_x, const float *p_packed_w, const float *p_bias, const float *p_residual, int64_t p_residual_stride,
+        float *p_y, int64_t p_in_channels, int64_t p_out_channels, int64_t p_kernel, int64_t p_dilation, int64_t p_frames, bool p_relu) {
+    if (p_frames <= 0) {
+        return;
+    }
+    // Every tap k reads the input shifted right by (K-1-k)*dilation. Writing one
+    // zero-filled, shifted copy of each row per tap keeps the causal padding
+    // out of the tiles and lets them use aligned loads: with the dilation
+    // offsets applied in the tile, most vector loads would straddle a cache
+    // line. Rows are rounded up to whole wide tiles.
+    const int64_t stride = (p_frames + WIDE_TILE_T - 1) / WIDE_TILE_T * WIDE_TILE_T;
+    const int64_t depth = p_in_channels * p_kernel;
+    thread_local std::vector<float> scratch;
+    scratch.resize((size_t)(depth * stride + 16));
+    float *xs = (float *)(((uintptr_t)scratch.data() + 63) & ~(uintptr_t)63);
+    for (int64_t ci = 0; ci < p_in_channels; ci++) {
+        for (int64_t k = 0; k < p_kernel; k++) {
+            float *row = xs + (ci * p_kernel + k) * stride;
+            int64_t shift = std::min((p_kernel - 1 - k) * p_dilation, p_frames);
+            std::fill(row, row + shift, 0.0f);
+            memcpy(row + shift, p_x + ci * p_frames, (size_t)(p_frames - shift) * sizeof(float));
+            std::fill(row + p_frames, row + stride, 0.0f);
+        }
+    }
+
+    ConvArgs args;
+    args.xs = xs;
+    args.xs_stride = stride;
+    args.depth = depth;
+    args.w = p_packed_w;
+    args.bias = p_bias;
+    args.residual = p_residual;
+    args.residual_stride = p_residual_stride;
+    args.y = p_y;
+    args.out_channels = p_out_channels;
+    args.frames = p_frames;
+    args.relu = p_relu;
+
+#if defined(CUSTOM_OPS_AVX2)
+    void (*tile)(const ConvArgs &, int64_t, int64_t) = _has_avx2() ? _tile_avx2 : _tile_scalar;
+#elif defined(CUSTOM_OPS_NEON)
+    void (*tile)(const ConvArgs &, int64_t, int64_t) = _tile_neon;
+#else
+    void (*tile)(const ConvArgs &, int64_t, int64_t) = _tile_scalar;
+#endif
+    void (*wide_tile)(const ConvArgs &, int64_t, int64_t) = nullptr;
+#if defined(CUSTOM_OPS_AVX512)
+    if (_has_avx512()) {
+        wide_tile = _tile_avx512;
+    }
+#endif
+    // One weight panel stays in L1 while it sweeps over time. Wide tiles cover
+    // all but a short tail, which goes through the narrow one.
+    for (int64_t co = 0; co < p_out_channels; co += TILE_CO) {
+        int64_t t = 0;
+        if (wide_tile) {
+            for (; p_frames - t > TILE_T; t += WIDE_TILE_T) {
+                wide_tile(args, co, t);
+            }
+        }
+        for (; t < p_frames; t += TILE_T) {
+            tile(args, co, t);
+        }
+    }
+}
+
+// --- FusedCausalConv1d ---
+
+// Inputs: X [B, C_in, T], W [C_out, C_in, K], B [C_out], optional Residual [B, C_out, T'] with T' >= T.
+// Attributes: dilation, activation (0 = none, 1 = relu). Output: Y [B, C_out, T].
+struct FusedCausalConv1d {
+    int64_t dilation = 1;
+    bool relu = false;
+
+    // W is an initializer, so it is packed on the first run and reused
+    std::mutex pack_mutex;
+    const float *packed_source = nullptr;
+    std::vector<float> packed;
+
+    FusedCausalConv1d(const OrtApi *, const OrtKernelInfo *p_info) {
+        Ort::ConstKernelInfo info(p_info);
+        dilation = info.GetAttribute<int64_t>("dilation");
+        relu = info.GetAttribute<int64_t>("activation") == 1;
+    }
+
+    void Compute(const Ort::Custom::Tensor<float> &p_x, const Ort::Custom::Tensor<float> &p_w, const Ort::Custom::Tensor<float> &p_bias,
+            std::optional<const Ort::Custom::Tensor<float> *> p_residual, Ort::Custom::Tensor<float> *r_y) {
+        const std::vector<int64_t> &x_shape = p_x.Shape();
+        const std::vector<int64_t> &w_shape = p_w.Shape();
+        if (x_shape.size() != 3 || w_shape.size() != 3 || w_shape[1] != x_shape[1] || p_bias.NumberOfElement() != w_shape[0]) {
+            throw Ort::Exception("FusedCausalConv1d: input shapes do not match", ORT_INVALID_ARGUMENT);
+        }
+        const int64_t batch = x_shape[0];
+        const int64_t in_channels = x_shape[1];
+        const int64_t frames = x_shape[2];
+        const int64_t out_channels = w_shape[0];
+
+        const float *residual = nullptr;
+        int64_t residual_stride = 0;
+        if (p_residual.has_value() && *p_residual) {
+            const std::vector<int64_t> &r_shape = (*p_residual)->Shape();
+            if (r_shape.size() != 3 || r_shape[0] != batch || r_shape[1] != out_channels || r_shape[2] < frames) {
+                throw Ort::Exception("FusedCausalConv1d: residual shape does not match the output", ORT_INVALID_ARGUMENT);
+            }
+            residual = (*p_residual)->Data();
+            residual_stride = r_shape[2];
+        }
+
+        const float *packed_w;
+        {
+            std::lock_guard<std::mutex> lock(pack_mutex);
+            if (packed_source != p_w.Data()) {
+                packed = pack_conv_weights(p_w.Data(), out_channels, in_channels, w_shape[2]);
+                packed_source = p_w.Data();
+            }
+            packed_w = packed.data();
+        }
+
+        float *y = r_y->Allocate({ batch, out_channels, frames });
+        for (int64_t b = 0; b < batch; b++) {
+            causal_conv1d(p_x.Data() + b * in_channels * frames, packed_w, p_bias.Data(),
+                    residual ? residual + b * out_channels * residual_stride : nullptr, residual_stride,
+                    y + b * out_channels * frames, in_channels, out_channels, w_shape[2], dilation, frames, relu);
+        }
+    }
+};
+
+// --- LogMelFeatures ---
+
+// Input: PCM [B, N] (or [N]). Attributes: the mel_frontend::Config fields.
+// Output: [B, N / hop_length, n_mels], the features AudioProcessor would
+// produce for the same samples streamed hop by hop after a reset.
+struct LogMelFeatures {
+    mel_frontend::Frontend frontend;
+
+    LogMelFeatures(const OrtApi *, const OrtKernelInfo *p_info) {
+        Ort::ConstKernelInfo info(p_info);
+        mel_frontend::Config config;
+        config.sample_rate = (int)info.GetAttribute<int64_t>("sample_rate");
+        config.hop_length = (int)info.GetAttribute<int64_t>("hop_length");
+        config.window_length = (int)info.GetAttribute<int64_t>("window_length");
+        config.n_fft = (int)info.GetAttribute<int64_t>("n_fft");
+        config.n_mels = (int)info.GetAttribute<int64_t>("n_mels");
+        config.f_min = info.GetAttribute<float>("f_min");
+        config.f_max = info.GetAttribute<float>("f_max");
+        if (config.hop_length <= 0 || config.window_length <= 1 || config.n_mels <= 0 || config.n_fft < config.window_length ||
+                (config.n_fft & (config.n_fft - 1)) != 0) {
+            throw Ort::Exception("LogMelFeatures: invalid frontend configuration", ORT_INVALID_ARGUMENT);
+        }
+        frontend.configure(config);
+    }
+
+    void Compute(const Ort::Custom::Tensor<float> &p_pcm, Ort::Custom::Tensor<float> *r_features) {
+        const std::vector<int64_t> &shape = p_pcm.Shape();
+        if (shape.empty() || shape.size() > 2) {
+            throw Ort::Exception("LogMelFeatures: PCM must be [batch, samples] or [samples]", ORT_INVALID_ARGUMENT);
+        }
+        const int64_t batch = shape.size() == 2 ? shape[0] : 1;
+        const int64_t samples = shape.back();
+        const int64_t frames = frontend.frame_count(samples);
+        const int64_t n_mels = frontend.get_config().n_mels;
+
+        float *features = r_features->Allocate({ batch, frames, n_mels });
+        for (int64_t b = 0; b < batch; b++) {
+            frontend.compute_clip(p_pcm.Data() + b * samples, samples, features + b * frames * n_mels);
+        }
+    }
+};
+
+void add_to_session_options(Ort::SessionOptions &p_options) {
+    // Function-local static, so concurrent first loads (async loading) are safe
+    struct Domain {
+        Ort::CustomOpDomain domain{ onnx_graph::CUSTOM_OP_DOMAIN };
+        std::unique_ptr<Ort::Custom::OrtLiteCustomOp> fused_conv{ Ort::Custom::CreateLiteCustomOp<FusedCausalConv1d>("FusedCausalConv1d", "CPUExecutionProvider") };
+        std::unique_ptr<Ort::Custom::OrtLiteCustomOp> log_mel{ Ort::Custom::CreateLiteCustomOp<LogMelFeatures>("LogMelFeatures", "CPUExecutionProvider") };
+
+        Domain() {
+            domain.Add(fused_conv.get());
+            domain.Add(log_mel.get());
+        }
+    };
+    static Domain instance;
+    p_options.Add(instance.domain);
+}
+
+} // namespace custom_ops
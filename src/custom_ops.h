@@ -0,0 +1,31 @@
+#ifndef CUSTOM_OPS_H
+#define CUSTOM_OPS_H
+
+// ONNX Runtime custom ops for the graph rewrites in onnx_graph.h, registered
+// through the lite custom-op API: FusedCausalConv1d and LogMelFeatures.
+// Has no Godot dependencies.
+
+#include <onnxruntime_cxx_api.h>
+#include <vector>
+
+namespace custom_ops {
+
+// Adds the "ai.openlipsync" domain to the options. The domain is created once
+// and lives for the whole process, as ORT requires it to outlive every session.
+void add_to_session_options(Ort::SessionOptions &p_options);
+
+// FusedCausalConv1d, exposed for benchmarks:
+//   y[co, t] = act(bias[co] + sum_{ci, k} w[co, ci, k] * x[ci, t - (K-1-k) * dilation] + residual[co, t])
+// x is [C_in, T], w is [C_out, C_in, K], residual is [C_out, residual_stride] or null
+// (only its first T frames are read), y is [C_out, T]. Frames before t=0 are zero.
+// The weights must first be repacked with pack_conv_weights().
+std::vector<float> pack_conv_weights(const float *p_w, int64_t p_out_channels, int64_t p_in_channels, int64_t p_kernel);
+void causal_conv1d(const float *p_x, const float *p_packed_w, const float *p_bias, const float *p_residual, int64_t p_residual_stride,
+        float *p_y, int64_t p_in_channels, int64_t p_out_channels, int64_t p_kernel, int64_t p_dilation, int64_t p_frames, bool p_relu);
+
+// Name of the SIMD path picked for this CPU ("avx512", "avx2", "neon" or "scalar")
+const char *simd_path();
+
+} // namespace custom_ops
+
+#endif
@@ -0,0 +1,176 @@
+#include "daemon_client.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__ANDROID__)
+#define DAEMON_CLIENT_SUPPORTED 1
+#include "daemon_protocol.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+DaemonClient::~DaemonClient() {
+    close();
+}
+
+bool DaemonClient::connect(const std::string &p_socket_path, uint32_t p_max_frames, uint32_t p_n_mels, std::string &r_error) {
+    close();
+#ifdef DAEMON_CLIENT_SUPPORTED
+    using namespace daemon_protocol;
+    if (p_max_frames == 0 || p_max_frames > MAX_FRAMES || p_n_mels == 0) {
+        r_error = "Window size out of range";
+        return false;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (p_socket_path.size() >= sizeof(address.sun_path)) {
+        r_error = "Socket path too long";
+        return false;
+    }
+    std::memcpy(address.sun_path, p_socket_path.c_str(), p_socket_path.size() + 1);
+    socket_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_fd < 0 || ::connect(socket_fd, (const sockaddr *)&address, sizeof(address)) != 0) {
+        r_error = "No daemon listening on " + p_socket_path;
+        close();
+        return false;
+    }
+    // A stalled daemon must not hang the caller, usually the game thread
+    timeval timeout = {};
+    timeout.tv_sec = timeout_msec / 1000;
+    timeout.tv_usec = (timeout_msec % 1000) * 1000;
+    if (timeout_msec > 0 && (setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+                                    setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0)) {
+        r_error = "Could not set the socket timeout";
+        close();
+        return false;
+    }
+
+    // Name unique to this process and connection; unlinked as soon as the daemon has it mapped
+    static std::atomic<uint32_t> counter(0);
+    char name[64];
+    std::snprintf(name, sizeof(name), "/olsync_client_%d_%u", (int)getpid(), counter.fetch_add(1));
+    const size_t size = buffer_size(p_max_frames, p_n_mels);
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        r_error = "Could not create the shared window buffer";
+        close();
+        return false;
+    }
+    void *memory = ftruncate(fd, (off_t)size) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name);
+        r_error = "Could not map the shared window buffer";
+        close();
+        return false;
+    }
+    buffer = memory;
+    buffer_bytes = size;
+
+    Hello hello = {};
+    hello.magic = MAGIC;
+    hello.version = VERSION;
+    hello.max_frames = p_max_frames;
+    hello.n_mels = p_n_mels;
+    std::memcpy(hello.buffer_name, name, std::strlen(name) + 1);
+    HelloReply reply = {};
+    const bool exchanged = send_all(socket_fd, &hello, sizeof(hello)) && recv_all(socket_fd, &reply, sizeof(reply));
+    shm_unlink(name);
+    if (!exchanged || reply.magic != MAGIC) {
+        r_error = !exchanged && (errno == EAGAIN || errno == EWOULDBLOCK) ? "The daemon did not answer the handshake in time"
+                                                                            : "The daemon closed the connection during the handshake";
+        close();
+        return false;
+    }
+    if (reply.status != STATUS_OK || reply.viseme_count == 0 || reply.viseme_count > MAX_VISEMES) {
+        r_error = reply.status == STATUS_BUFFER_FAILED ? "The daemon could not map the window buffer" : "The daemon refused the connection";
+        close();
+        return false;
+    }
+    frames_capacity = p_max_frames;
+    mels = p_n_mels;
+    visemes = reply.viseme_count;
+    daemon_receptive_field = reply.receptive_field;
+    daemon_max_batch = reply.max_batch;
+    batch_size = 0;
+    sequence = 0;
+    return true;
+#else
+    (void)p_socket_path;
+    (void)p_max_frames;
+    (void)p_n_mels;
+    r_error = "The lip-sync daemon is not supported on this platform";
+    return false;
+#endif
+}
+
+void DaemonClient::close() {
+#ifdef DAEMON_CLIENT_SUPPORTED
+    if (socket_fd >= 0) {
+        ::close(socket_fd);
+    }
+    if (buffer) {
+        munmap(buffer, buffer_bytes);
+    }
+#endif
+    socket_fd = -1;
+    buffer = nullptr;
+    buffer_bytes = 0;
+    frames_capacity = 0;
+    mels = 0;
+    visemes = 0;
+}
+
+bool DaemonClient::infer(const float *p_window, uint32_t p_frames, float *r_visemes, std::string &r_error) {
+    if (!is_connected()) {
+        r_error = "Not connected";
+        return false;
+    }
+    if (p_frames == 0 || p_frames > frames_capacity) {
+        r_error = "Window larger than the buffer";
+        return false;
+    }
+    std::memcpy(buffer, p_window, (size_t)p_frames * mels * sizeof(float));
+    return infer_in_place(p_frames, r_visemes, r_error);
+}
+
+bool DaemonClient::infer_in_place(uint32_t p_frames, float *r_visemes, std::string &r_error) {
+#ifdef DAEMON_CLIENT_SUPPORTED
+    using namespace daemon_protocol;
+    if (!is_connected()) {
+        r_error = "Not connected";
+        return false;
+    }
+    if (p_frames == 0 || p_frames > frames_capacity) {
+        r_error = "Window larger than the buffer";
+        return false;
+    }
+    // The socket round trip orders the buffer writes before the daemon's reads and back
+    Request request = { p_frames, ++sequence };
+    Reply reply = {};
+    if (!send_all(socket_fd, &request, sizeof(request)) || !recv_all(socket_fd, &reply, sizeof(reply)) || reply.sequence != request.sequence) {
+        r_error = errno == EAGAIN || errno == EWOULDBLOCK ? "The daemon did not reply in time" : "Lost the connection to the daemon";
+        close();
+        return false;
+    }
+    if (reply.status != STATUS_OK) {
+        r_error = "The daemon failed to run the window";
+        return false;
+    }
+    batch_size = reply.batch_size;
+    std::memcpy(r_visemes, (const char *)buffer + output_offset(frames_capacity, mels), (size_t)visemes * sizeof(float));
+    return true;
+#else
+    (void)p_frames;
+    (void)r_visemes;
+    r_error = "Not connected";
+    return false;
+#endif
+}
@@ -0,0 +1,60 @@
+#ifndef DAEMON_CLIENT_H
+#define DAEMON_CLIENT_H
+
+// Client side of the lip-sync daemon protocol (daemon_protocol.h): one
+// connection with its own shared-memory window buffer, and a blocking
+// request/reply per inference, bounded by a timeout after which the
+// connection is closed. Has no Godot dependencies; POSIX only, and every call
+// fails cleanly elsewhere.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class DaemonClient {
+public:
+    DaemonClient() = default;
+    ~DaemonClient();
+    DaemonClient(const DaemonClient &) = delete;
+    DaemonClient &operator=(const DaemonClient &) = delete;
+
+    // Creates the buffer for windows of up to p_max_frames x p_n_mels and
+    // hands it to the daemon listening on p_socket_path
+    bool connect(const std::string &p_socket_path, uint32_t p_max_frames, uint32_t p_n_mels, std::string &r_error);
+    void close();
+    bool is_connected() const { return socket_fd >= 0; }
+    // Longest a send or reply may take; applies to the next connect()
+    void set_timeout_msec(uint32_t p_msec) { timeout_msec = p_msec; }
+
+    // Runs one [1, p_frames, n_mels] window through the daemon's session and
+    // copies the last frame's visemes to r_visemes (viseme_count() floats).
+    // A failure, including a daemon that doesn't reply within the timeout,
+    // closes the connection.
+    bool infer(const float *p_window, uint32_t p_frames, float *r_visemes, std::string &r_error);
+
+    // Where to write the window directly, skipping infer()'s copy
+    float *window_buffer() const { return (float *)buffer; }
+    bool infer_in_place(uint32_t p_frames, float *r_visemes, std::string &r_error);
+
+    uint32_t viseme_count() const { return visemes; }
+    uint32_t receptive_field() const { return daemon_receptive_field; }
+    uint32_t max_batch() const { return daemon_max_batch; }
+    uint32_t max_frames() const { return frames_capacity; }
+    // Requests that shared the daemon's last run with ours
+    uint32_t last_batch_size() const { return batch_size; }
+
+private:
+    int socket_fd = -1;
+    void *buffer = nullptr;
+    size_t buffer_bytes = 0;
+    uint32_t frames_capacity = 0;
+    uint32_t mels = 0;
+    uint32_t visemes = 0;
+    uint32_t daemon_receptive_field = 0;
+    uint32_t daemon_max_batch = 1;
+    uint32_t batch_size = 0;
+    uint32_t sequence = 0;
+    uint32_t timeout_msec = 500; // 0 waits forever
+};
+
+#endif
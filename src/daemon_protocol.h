@@ -0,0 +1,120 @@
+#ifndef DAEMON_PROTOCOL_H
+#define DAEMON_PROTOCOL_H
+
+// Wire protocol between the lip-sync daemon (daemon/lipsync_daemon.cpp) and
+// its clients (daemon_client.h). Has no Godot dependencies; POSIX only.
+//
+// The daemon owns one ORT session for every game process on the machine and
+// batches their requests. A client connects to the daemon's UNIX stream
+// socket and keeps its feature window in a shared-memory buffer of its own,
+// so the socket only carries small fixed-size messages:
+//
+//   client                                daemon
+//   shm_open + ftruncate buffer_size()
+//   Hello {buffer name, max_frames}  -->  maps the buffer
+//                                    <--  HelloReply {status, viseme_count, ...}
+//   shm_unlink (the mappings live on)
+//   writes frames * n_mels floats at
+//   offset 0 of the buffer
+//   Request {frames, sequence}       -->  gathers requests for up to the batch
+//                                         window, runs one [B, frames, n_mels]
+//                                         call per frame count, writes each
+//                                         client's visemes at output_offset()
+//                                    <--  Reply {sequence, status, ...}
+//
+// Messages are native-endian (same machine) and read whole.
+
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace daemon_protocol {
+
+static const uint32_t MAGIC = 0x44534C4F; // "OLSD"
+static const uint32_t VERSION = 1;
+static const char DEFAULT_SOCKET[] = "/tmp/openlipsync.sock";
+static const uint32_t MAX_VISEMES = 64;
+static const uint32_t MAX_FRAMES = 4096;
+
+enum Status : int32_t {
+    STATUS_OK = 0,
+    STATUS_BAD_REQUEST = 1,      // Wrong magic or version, or frames out of range
+    STATUS_BUFFER_FAILED = 2,    // The daemon could not map the client's buffer
+    STATUS_INFERENCE_FAILED = 3,
+};
+
+struct Hello {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t max_frames; // Largest window the client will send
+    uint32_t n_mels;     // Features per frame it computes
+    char buffer_name[64]; // shm_open name of its buffer, NUL terminated
+};
+
+struct HelloReply {
+    uint32_t magic;
+    int32_t status;
+    uint32_t viseme_count;
+    uint32_t receptive_field; // 0 if unknown
+    uint32_t max_batch;       // 1 if the model can't batch
+    uint32_t reserved;
+};
+
+struct Request {
+    uint32_t frames;
+    uint32_t sequence;
+};
+
+struct Reply {
+    uint32_t sequence;
+    int32_t status;
+    uint32_t viseme_count;
+    uint32_t batch_size; // Requests that shared this run, for statistics
+};
+
+inline size_t output_offset(uint32_t p_max_frames, uint32_t p_n_mels) {
+    return (size_t)p_max_frames * p_n_mels * sizeof(float);
+}
+
+inline size_t buffer_size(uint32_t p_max_frames, uint32_t p_n_mels) {
+    return output_offset(p_max_frames, p_n_mels) + MAX_VISEMES * sizeof(float);
+}
+
+// Whole-message socket I/O, retrying on signals and short transfers
+inline bool send_all(int p_fd, const void *p_data, size_t p_size) {
+    const char *data = (const char *)p_data;
+    while (p_size > 0) {
+        ssize_t sent = ::send(p_fd, data, p_size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        p_size -= (size_t)sent;
+    }
+    return true;
+}
+
+inline bool recv_all(int p_fd, void *r_data, size_t p_size) {
+    char *data = (char *)r_data;
+    while (p_size > 0) {
+        ssize_t got = ::recv(p_fd, data, p_size, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        p_size -= (size_t)got;
+    }
+    return true;
+}
+
+} // namespace daemon_protocol
+
+#endif
@@ -0,0 +1,194 @@
+#include "feature_cache.h"
+#include "half_float.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace feature_cache {
+
+static const char MAGIC[] = "OLMF";
+static const uint32_t VERSION = 1;
+static const size_t HEADER_SIZE = 128;
+static const size_t HASH_OFFSET = 48;
+static const size_t HASH_SIZE = 64;
+
+// Header fields, in file order, without the hash
+struct Header {
+    char magic[4];
+    uint32_t version;
+    int32_t sample_rate;
+    int32_t hop_length;
+    int32_t window_length;
+    int32_t n_fft;
+    int32_t n_mels;
+    float f_min;
+    float f_max;
+    uint32_t reserved;
+    uint64_t frames;
+};
+static_assert(sizeof(Header) == 48, "feature cache header layout");
+
+static Header _make_header(const mel_frontend::Config &p_config, int64_t p_frames) {
+    Header header = {};
+    memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.sample_rate = p_config.sample_rate;
+    header.hop_length = p_config.hop_length;
+    header.window_length = p_config.window_length;
+    header.n_fft = p_config.n_fft;
+    header.n_mels = p_config.n_mels;
+    header.f_min = p_config.f_min;
+    header.f_max = p_config.f_max;
+    header.frames = (uint64_t)p_frames;
+    return header;
+}
+
+std::string file_name(const std::string &p_audio_hash, const mel_frontend::Config &p_config) {
+    char suffix[160];
+    snprintf(suffix, sizeof(suffix), "_sr%d_fft%d_win%d_hop%d_mel%d_%g-%g.olmf", p_config.sample_rate, p_config.n_fft,
+            p_config.window_length, p_config.hop_length, p_config.n_mels, p_config.f_min, p_config.f_max);
+    return p_audio_hash + suffix;
+}
+
+bool store(const std::string &p_path, const std::string &p_audio_hash, const mel_frontend::Config &p_config,
+        const float *p_features, int64_t p_frames) {
+    if (p_audio_hash.size() > HASH_SIZE || p_frames < 0) {
+        return false;
+    }
+    std::vector<uint8_t> header(HEADER_SIZE, 0);
+    const Header fields = _make_header(p_config, p_frames);
+    memcpy(header.data(), &fields, sizeof(fields));
+    memcpy(header.data() + HASH_OFFSET, p_audio_hash.data(), p_audio_hash.size());
+
+    std::vector<uint16_t> halves((size_t)(p_frames * p_config.n_mels));
+    half_float::encode(p_features, halves.data(), (int64_t)halves.size());
+
+    static std::atomic<uint32_t> counter{0};
+    const std::filesystem::path path = std::filesystem::u8path(p_path);
+    std::filesystem::path temp = path;
+    temp += ".tmp" + std::to_string(std::random_device()()) + "_" + std::to_string(counter++);
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.write((const char *)header.data(), (std::streamsize)header.size());
+        file.write((const char *)halves.data(), (std::streamsize)(halves.size() * sizeof(uint16_t)));
+        if (!file) {
+            file.close();
+            std::error_code ignored;
+            std::filesystem::remove(temp, ignored);
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    return true;
+}
+
+bool View::open(const std::string &p_path, const std::string &p_audio_hash, const mel_frontend::Config &p_config) {
+    close();
+#ifdef _WIN32
+    std::wstring wide = std::filesystem::u8path(p_path).wstring();
+    HANDLE file = CreateFileW(wide.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)HEADER_SIZE) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE map = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *view = map ? MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (map) {
+            CloseHandle(map);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    file_handle = file;
+    map_handle = map;
+    mapping = view;
+    mapped_size = (size_t)size.QuadPart;
+#else
+    int fd = ::open(p_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)HEADER_SIZE) {
+        ::close(fd);
+        return false;
+    }
+    void *view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    mapping = view;
+    mapped_size = (size_t)info.st_size;
+#endif
+
+    Header header;
+    memcpy(&header, mapping, sizeof(header));
+    const Header expected = _make_header(p_config, (int64_t)header.frames);
+    char hash[HASH_SIZE] = {};
+    memcpy(hash, p_audio_hash.data(), std::min(p_audio_hash.size(), HASH_SIZE));
+    const uint64_t data_size = header.frames * (uint64_t)p_config.n_mels * sizeof(uint16_t);
+    if (memcmp(&header, &expected, sizeof(header)) != 0 || p_audio_hash.size() > HASH_SIZE ||
+            memcmp((const uint8_t *)mapping + HASH_OFFSET, hash, HASH_SIZE) != 0 || mapped_size != HEADER_SIZE + data_size) {
+        close();
+        return false;
+    }
+    frames = (int64_t)header.frames;
+    n_mels = p_config.n_mels;
+    data = (const uint16_t *)((const uint8_t *)mapping + HEADER_SIZE);
+    return true;
+}
+
+void View::close() {
+    if (mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+        CloseHandle((HANDLE)map_handle);
+        CloseHandle((HANDLE)file_handle);
+        map_handle = nullptr;
+        file_handle = nullptr;
+#else
+        munmap(mapping, mapped_size);
+#endif
+    }
+    mapping = nullptr;
+    mapped_size = 0;
+    frames = 0;
+    n_mels = 0;
+    data = nullptr;
+}
+
+void View::decode(float *r_features) const {
+    half_float::decode(data, r_features, frames * n_mels);
+}
+
+} // namespace feature_cache
@@ -0,0 +1,61 @@
+#ifndef FEATURE_CACHE_H
+#define FEATURE_CACHE_H
+
+// On-disk cache of log-mel feature matrices, so re-baking a voice library with
+// a new model skips feature extraction. One file per clip and frontend config,
+// named after the key (audio hash, sample_rate, n_fft, window, hop, n_mels,
+// f_min, f_max). Files are read back through a memory map.
+// Has no Godot dependencies.
+//
+// File layout (little endian, 128-byte header so the data is aligned):
+//   "OLMF", u32 version, i32 sample_rate, i32 hop_length, i32 window_length,
+//   i32 n_fft, i32 n_mels, f32 f_min, f32 f_max, u32 reserved, u64 frames,
+//   char audio_hash[64] (zero padded), padding,
+//   f16 features[frames * n_mels] (frame-major)
+
+#include "mel_frontend.h"
+#include <cstdint>
+#include <string>
+
+namespace feature_cache {
+
+// File name for a clip's features under the given config
+std::string file_name(const std::string &p_audio_hash, const mel_frontend::Config &p_config);
+
+// Writes the features as half floats. Goes through a temporary file and a
+// rename, so concurrent bakes never expose a partial file.
+bool store(const std::string &p_path, const std::string &p_audio_hash, const mel_frontend::Config &p_config,
+        const float *p_features, int64_t p_frames);
+
+// Read-only memory map of a cache file
+class View {
+    void *mapping = nullptr;
+    size_t mapped_size = 0;
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *map_handle = nullptr;
+#endif
+    int64_t frames = 0;
+    int n_mels = 0;
+    const uint16_t *data = nullptr;
+
+public:
+    View() {}
+    ~View() { close(); }
+    View(const View &) = delete;
+    View &operator=(const View &) = delete;
+
+    // False if the file is missing, truncated or was written for another key
+    bool open(const std::string &p_path, const std::string &p_audio_hash, const mel_frontend::Config &p_config);
+    void close();
+
+    int64_t get_frames() const { return frames; }
+    int get_n_mels() const { return n_mels; }
+    const uint16_t *get_data() const { return data; }
+    // Expands the half floats into r_features [frames * n_mels]
+    void decode(float *r_features) const;
+};
+
+} // namespace feature_cache
+
+#endif
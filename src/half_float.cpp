@@ -0,0 +1,92 @@
+#include "half_float.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// Compiled for F16C regardless of the build flags, picked at runtime
+#define HALF_FLOAT_F16C 1
+#define HALF_FLOAT_F16C_TARGET __attribute__((target("avx,f16c")))
+#elif defined(__AVX2__)
+// MSVC only emits F16C when the whole build allows it (/arch:AVX2)
+#define HALF_FLOAT_F16C 1
+#define HALF_FLOAT_F16C_TARGET
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HALF_FLOAT_NEON 1
+#endif
+
+namespace half_float {
+
+#if defined(HALF_FLOAT_F16C)
+static bool _has_f16c() {
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool supported = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    return supported;
+#else
+    return true;
+#endif
+}
+
+HALF_FLOAT_F16C_TARGET static int64_t _encode_f16c(const float *p_src, uint16_t *r_dst, int64_t p_count) {
+    int64_t i = 0;
+    for (; i + 8 <= p_count; i += 8) {
+        __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(p_src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128((__m128i *)(r_dst + i), half);
+    }
+    return i;
+}
+
+HALF_FLOAT_F16C_TARGET static int64_t _decode_f16c(const uint16_t *p_src, float *r_dst, int64_t p_count) {
+    int64_t i = 0;
+    for (; i + 8 <= p_count; i += 8) {
+        _mm256_storeu_ps(r_dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(p_src + i))));
+    }
+    return i;
+}
+#endif
+
+void encode(const float *p_src, uint16_t *r_dst, int64_t p_count) {
+    int64_t i = 0;
+#if defined(HALF_FLOAT_F16C)
+    if (_has_f16c()) {
+        i = _encode_f16c(p_src, r_dst, p_count);
+    }
+#elif defined(HALF_FLOAT_NEON)
+    for (; i + 4 <= p_count; i += 4) {
+        vst1_u16(r_dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(p_src + i))));
+    }
+#endif
+    for (; i < p_count; i++) {
+        r_dst[i] = from_float(p_src[i]);
+    }
+}
+
+void decode(const uint16_t *p_src, float *r_dst, int64_t p_count) {
+    int64_t i = 0;
+#if defined(HALF_FLOAT_F16C)
+    if (_has_f16c()) {
+        i = _decode_f16c(p_src, r_dst, p_count);
+    }
+#elif defined(HALF_FLOAT_NEON)
+    for (; i + 4 <= p_count; i += 4) {
+        vst1q_f32(r_dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(p_src + i))));
+    }
+#endif
+    for (; i < p_count; i++) {
+        r_dst[i] = to_float(p_src[i]);
+    }
+}
+
+const char *simd_path() {
+#if defined(HALF_FLOAT_F16C)
+    if (_has_f16c()) {
+        return "f16c";
+    }
+#elif defined(HALF_FLOAT_NEON)
+    return "neon";
+#endif
+    return "scalar";
+}
+
+} // namespace half_float
@@ -0,0 +1,37 @@
+#ifndef HALF_FLOAT_H
+#define HALF_FLOAT_H
+
+// IEEE 754 binary16 conversion for compact feature storage. Normalised log-mel
+// features sit within a few units of zero, where half keeps about three
+// significant digits. Scalar conversion comes from ONNX Runtime's float16
+// header; the array versions use F16C or NEON when the CPU has them.
+// Has no Godot dependencies.
+
+#include <onnxruntime_float16.h>
+#include <cstdint>
+
+namespace half_float {
+
+struct Half : onnxruntime_float16::Float16Impl<Half> {
+    static uint16_t from_float(float p_value) { return ToUint16Impl(p_value); }
+    static float to_float(uint16_t p_bits) {
+        Half half;
+        half.val = p_bits;
+        return half.ToFloatImpl();
+    }
+};
+
+// Round to nearest even; overflow goes to infinity, NaN stays NaN
+inline uint16_t from_float(float p_value) { return Half::from_float(p_value); }
+inline float to_float(uint16_t p_half) { return Half::to_float(p_half); }
+
+// Same rounding as the scalar versions
+void encode(const float *p_src, uint16_t *r_dst, int64_t p_count);
+void decode(const uint16_t *p_src, float *r_dst, int64_t p_count);
+
+// Name of the path picked for this CPU ("f16c", "neon" or "scalar")
+const char *simd_path();
+
+} // namespace half_float
+
+#endif
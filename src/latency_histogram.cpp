@@ -0,0 +1,164 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+namespace latency_histogram {
+
+std::atomic<bool> enabled{ false };
+
+// One thread's counters; only that thread stores to them
+struct Block {
+    std::atomic<uint64_t> counts[MAX_STAGES][BUCKET_COUNT];
+    std::atomic<uint64_t> max[MAX_STAGES];
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<Block *> live;
+    // Blocks of threads that have exited, folded in
+    std::vector<uint64_t> retired = std::vector<uint64_t>((size_t)MAX_STAGES * BUCKET_COUNT, 0);
+    uint64_t retired_max[MAX_STAGES] = {};
+    std::vector<Snapshot> baseline = std::vector<Snapshot>(MAX_STAGES);
+};
+
+// Leaked on purpose: threads may still exit after static destruction starts
+static Registry &_registry() {
+    static Registry *registry = new Registry();
+    return *registry;
+}
+
+// Registers the thread's block on first use and retires it on thread exit
+struct ThreadSlot {
+    Block *block = nullptr;
+
+    Block *get() {
+        if (!block) {
+            block = new Block();
+            Registry &registry = _registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.live.push_back(block);
+        }
+        return block;
+    }
+
+    ~ThreadSlot() {
+        if (!block) {
+            return;
+        }
+        Registry &registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (int stage = 0; stage < MAX_STAGES; stage++) {
+            for (int i = 0; i < BUCKET_COUNT; i++) {
+                registry.retired[(size_t)stage * BUCKET_COUNT + i] += block->counts[stage][i].load(std::memory_order_relaxed);
+            }
+            registry.retired_max[stage] = std::max(registry.retired_max[stage], block->max[stage].load(std::memory_order_relaxed));
+        }
+        registry.live.erase(std::find(registry.live.begin(), registry.live.end(), block));
+        delete block;
+    }
+};
+
+static thread_local ThreadSlot thread_slot;
+
+void set_enabled(bool p_enabled) {
+    enabled.store(p_enabled, std::memory_order_relaxed);
+}
+
+void record(int p_stage, uint64_t p_ns) {
+    Block *block = thread_slot.get();
+    std::atomic<uint64_t> &count = block->counts[p_stage][bucket_index(p_ns)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic<uint64_t> &max = block->max[p_stage];
+    if (p_ns > max.load(std::memory_order_relaxed)) {
+        max.store(p_ns, std::memory_order_relaxed);
+    }
+}
+
+uint64_t bucket_low(int p_index) {
+    if (p_index < SUB_BUCKETS) {
+        return (uint64_t)p_index;
+    }
+    const int shift = (p_index - SUB_BUCKETS) / SUB_BUCKETS;
+    const uint64_t mantissa = (uint64_t)SUB_BUCKETS + (p_index - SUB_BUCKETS) % SUB_BUCKETS;
+    return mantissa << shift;
+}
+
+uint64_t bucket_high(int p_index) {
+    if (p_index < SUB_BUCKETS) {
+        return (uint64_t)p_index;
+    }
+    const int shift = (p_index - SUB_BUCKETS) / SUB_BUCKETS;
+    return bucket_low(p_index) + ((uint64_t)1 << shift) - 1;
+}
+
+uint64_t Snapshot::percentile(double p_q) const {
+    if (total == 0) {
+        return 0;
+    }
+    // Rank of the value at p_q, 1-based, so p_q = 1 is the last value
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::min<double>((double)total, p_q * total + 0.999999));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // Nothing recorded exceeds max, which matters for the top buckets
+            return std::min(max, bucket_low(i) + (bucket_high(i) - bucket_low(i)) / 2);
+        }
+    }
+    return max;
+}
+
+uint64_t Snapshot::largest() const {
+    for (int i = BUCKET_COUNT - 1; i >= 0; i--) {
+        if (counts[i] > 0) {
+            return max >= bucket_low(i) && (max <= bucket_high(i) || i == BUCKET_COUNT - 1) ? max : bucket_high(i);
+        }
+    }
+    return 0;
+}
+
+Snapshot Snapshot::since(const Snapshot &p_older) const {
+    Snapshot delta = *this;
+    if (p_older.counts.size() == counts.size()) {
+        delta.total = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            delta.counts[i] -= std::min(delta.counts[i], p_older.counts[i]);
+            delta.total += delta.counts[i];
+        }
+    }
+    return delta;
+}
+
+static Snapshot _merged(Registry &p_registry, int p_stage) {
+    Snapshot merged;
+    merged.counts.assign(p_registry.retired.begin() + (size_t)p_stage * BUCKET_COUNT,
+            p_registry.retired.begin() + (size_t)(p_stage + 1) * BUCKET_COUNT);
+    merged.max = p_registry.retired_max[p_stage];
+    for (Block *block : p_registry.live) {
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            merged.counts[i] += block->counts[p_stage][i].load(std::memory_order_relaxed);
+        }
+        merged.max = std::max(merged.max, block->max[p_stage].load(std::memory_order_relaxed));
+    }
+    for (uint64_t count : merged.counts) {
+        merged.total += count;
+    }
+    return merged;
+}
+
+Snapshot snapshot(int p_stage) {
+    Registry &registry = _registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return _merged(registry, p_stage).since(registry.baseline[p_stage]);
+}
+
+void reset() {
+    Registry &registry = _registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (int stage = 0; stage < MAX_STAGES; stage++) {
+        registry.baseline[stage] = _merged(registry, stage);
+    }
+}
+
+} // namespace latency_histogram
@@ -0,0 +1,111 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+// Fixed-memory latency histograms for the streaming pipeline stages, in the
+// style of HdrHistogram: log-linear buckets with SUB_BUCKETS per power of two,
+// so any recorded value is known to within 1/SUB_BUCKETS (about 3%) from 1 ns
+// up to about 36 minutes. Has no Godot dependencies.
+//
+// Every recording thread gets its own block of counters on first use, and
+// only that thread writes it (plain relaxed load and store, no atomic
+// read-modify-write), so recording never takes a lock or contends on a cache
+// line. Readers merge all blocks on demand under a registry mutex. A block is
+// folded into the retired totals when its thread exits.
+//
+// Counters are never cleared while threads may write them; reset() records a
+// baseline that later snapshots are taken against instead.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace latency_histogram {
+
+static const int MAX_STAGES = 8;
+static const int SUB_BUCKET_BITS = 5;
+static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+static const int MAX_OCTAVE = 41; // Values at or above 2^MAX_OCTAVE ns land in the last bucket
+static const int BUCKET_COUNT = SUB_BUCKETS + (MAX_OCTAVE - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+inline int highest_bit(uint64_t p_value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, p_value);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(p_value);
+#endif
+}
+
+inline int bucket_index(uint64_t p_ns) {
+    if (p_ns < (uint64_t)SUB_BUCKETS) {
+        return (int)p_ns;
+    }
+    const int octave = highest_bit(p_ns);
+    if (octave >= MAX_OCTAVE) {
+        return BUCKET_COUNT - 1;
+    }
+    const int shift = octave - SUB_BUCKET_BITS;
+    return SUB_BUCKETS + shift * SUB_BUCKETS + (int)((p_ns >> shift) - SUB_BUCKETS);
+}
+
+// Lowest and highest value a bucket holds
+uint64_t bucket_low(int p_index);
+uint64_t bucket_high(int p_index);
+
+struct Snapshot {
+    std::vector<uint64_t> counts; // BUCKET_COUNT
+    uint64_t total = 0;
+    uint64_t max = 0; // Exact largest value recorded, whenever it was
+
+    // Value at quantile p_q (0..1), the middle of its bucket; 0 when empty
+    uint64_t percentile(double p_q) const;
+    // Largest value in this snapshot: exact if the all-time max falls in its
+    // highest bucket, else that bucket's upper bound
+    uint64_t largest() const;
+    // What was recorded between p_older and this snapshot
+    Snapshot since(const Snapshot &p_older) const;
+};
+
+// Recording is off until enabled; a disabled Scope costs one relaxed load
+extern std::atomic<bool> enabled;
+void set_enabled(bool p_enabled);
+inline bool is_enabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+// Adds one value to p_stage (0..MAX_STAGES-1) from the calling thread
+void record(int p_stage, uint64_t p_ns);
+
+// Everything recorded since the last reset(), merged across threads
+Snapshot snapshot(int p_stage);
+void reset();
+
+inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Times its own lifetime into a stage when recording is enabled
+class Scope {
+    int stage;
+    uint64_t start;
+
+public:
+    explicit Scope(int p_stage) :
+            stage(p_stage), start(is_enabled() ? now_ns() : 0) {}
+    ~Scope() {
+        if (start) {
+            record(stage, now_ns() - start);
+        }
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+};
+
+} // namespace latency_histogram
+
+#endif
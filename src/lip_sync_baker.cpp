@@ -0,0 +1,465 @@
+#include "lip_sync_baker.h"
+#include "feature_cache.h"
+#include "half_float.h"
+#include "onnx_graph.h"
+#include "pcm_convert.h"
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/hashing_context.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace godot;
+
+static const char TRACK_MAGIC[] = "OLSY";
+static const uint32_t TRACK_VERSION = 1;
+static const int TARGET_SAMPLE_RATE = 16000;
+static const int HOP_LENGTH = 160; // AudioProcessor default, 100 frames per second
+
+static uint64_t _ticks_usec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- WAV decoding ---
+
+static uint32_t _read_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t _read_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// One sample of the given format, scaled to [-1, 1]
+static float _read_sample(const uint8_t *p, int p_bits, bool p_float) {
+    if (p_float) {
+        if (p_bits == 32) {
+            float v;
+            memcpy(&v, p, 4);
+            return v;
+        }
+        double v;
+        memcpy(&v, p, 8);
+        return (float)v;
+    }
+    switch (p_bits) {
+        case 8:
+            return ((int)p[0] - 128) / 128.0f;
+        case 16:
+            return (int16_t)_read_u16(p) / 32768.0f;
+        case 24: {
+            int32_t v = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+            return v / 8388608.0f;
+        }
+        default:
+            return (int32_t)_read_u32(p) / 2147483648.0f;
+    }
+}
+
+PackedFloat32Array LipSyncBaker::decode_wav(const PackedByteArray &p_bytes) {
+    const uint8_t *data = p_bytes.ptr();
+    const int64_t size = p_bytes.size();
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+        return PackedFloat32Array();
+    }
+
+    int format = 0;
+    int channels = 0;
+    int sample_rate = 0;
+    int bits = 0;
+    const uint8_t *pcm = nullptr;
+    int64_t pcm_size = 0;
+    int64_t offset = 12;
+    while (offset + 8 <= size) {
+        const uint8_t *chunk = data + offset;
+        int64_t chunk_size = _read_u32(chunk + 4);
+        int64_t available = std::min(chunk_size, size - offset - 8);
+        if (memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+            format = _read_u16(chunk + 8);
+            channels = _read_u16(chunk + 10);
+            sample_rate = (int)_read_u32(chunk + 12);
+            bits = _read_u16(chunk + 22);
+            if (format == 0xFFFE && available >= 26) {
+                // WAVE_FORMAT_EXTENSIBLE: the real format leads the sub-format GUID
+                format = _read_u16(chunk + 32);
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            // Truncated files are decoded up to where the data ends
+            pcm = chunk + 8;
+            pcm_size = available;
+        }
+        // Chunks are padded to an even size
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    bool is_float = format == 3;
+    bool supported = (format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) || (is_float && (bits == 32 || bits == 64));
+    if (!pcm || !supported || channels <= 0 || sample_rate <= 0) {
+        return PackedFloat32Array();
+    }
+
+    // Downmix to mono
+    const int frame_bytes = channels * bits / 8;
+    const int64_t frames = pcm_size / frame_bytes;
+    std::vector<float> mono((size_t)frames);
+    if (bits == 16 && !is_float) {
+        // The common case, vectorised; same values as the generic loop
+        pcm_convert::int16_to_mono(pcm, frames, channels, mono.data());
+    } else {
+        for (int64_t i = 0; i < frames; i++) {
+            const uint8_t *frame = pcm + i * frame_bytes;
+            float sum = 0.0f;
+            for (int c = 0; c < channels; c++) {
+                sum += _read_sample(frame + c * (bits / 8), bits, is_float);
+            }
+            mono[i] = sum / channels;
+        }
+    }
+
+    // Linear interpolation to 16 kHz, like LipSyncContext's streaming resampler
+    std::vector<float> resampled = pcm_convert::resample_linear(mono.data(), frames, sample_rate, TARGET_SAMPLE_RATE);
+    PackedFloat32Array result;
+    result.resize((int64_t)resampled.size());
+    if (!resampled.empty()) {
+        memcpy(result.ptrw(), resampled.data(), resampled.size() * sizeof(float));
+    }
+    return result;
+}
+
+// --- Baking ---
+
+bool LipSyncBaker::load_model(const String &p_path) {
+    PackedByteArray bytes = FileAccess::get_file_as_bytes(p_path);
+    if (bytes.is_empty()) {
+        UtilityFunctions::printerr("LipSyncBaker: Could not read model ", p_path);
+        return false;
+    }
+    // The receptive field picks the graph, so read it off the parsed file
+    // instead of building a session just to ask
+    onnx_graph::Model graph;
+    std::string error;
+    const int64_t field = graph.load(bytes.ptr(), (size_t)bytes.size(), error) ? onnx_graph::receptive_field(graph) : 0;
+
+    Ref<OnnxModel> new_model;
+    new_model.instantiate();
+    new_model->set_warmup_runs(0);
+    // The chunked offline path needs every output frame
+    new_model->set_last_frame_only(field <= 0 || field > context_size);
+    if (!new_model->load_model(p_path)) {
+        return false;
+    }
+    model = new_model;
+    model_hash = _hash_bytes(bytes);
+    return true;
+}
+
+int LipSyncBaker::get_receptive_field() const {
+    return model.is_valid() ? model->get_receptive_field() : 0;
+}
+
+void LipSyncBaker::set_context_size(int p_frames) {
+    context_size = p_frames < 1 ? 1 : p_frames;
+}
+
+void LipSyncBaker::set_feature_cache_dir(const String &p_dir) {
+    feature_cache_dir = p_dir.is_empty() ? String() : ProjectSettings::get_singleton()->globalize_path(p_dir);
+    if (!feature_cache_dir.is_empty() && DirAccess::make_dir_recursive_absolute(feature_cache_dir) != OK) {
+        UtilityFunctions::printerr("LipSyncBaker: Could not create feature cache ", feature_cache_dir);
+    }
+}
+
+String LipSyncBaker::_hash_bytes(const PackedByteArray &p_bytes) {
+    Ref<HashingContext> hashing;
+    hashing.instantiate();
+    hashing->start(HashingContext::HASH_SHA256);
+    hashing->update(p_bytes);
+    return hashing->finish().hex_encode();
+}
+
+String LipSyncBaker::_track_key(const String &p_audio_hash, const mel_frontend::Config &p_config) const {
+    // Features are rounded through half floats only with a cache, so the
+    // precision is part of the key along with the frontend that made them
+    char frontend[128];
+    snprintf(frontend, sizeof(frontend), "%s:sr%d_fft%d_win%d_hop%d_mel%d_%g-%g", feature_cache_dir.is_empty() ? "f32" : "f16",
+            p_config.sample_rate, p_config.n_fft, p_config.window_length, p_config.hop_length, p_config.n_mels, p_config.f_min, p_config.f_max);
+    return p_audio_hash + ":" + model_hash + ":" + String::num_int64(context_size) + ":" + frontend;
+}
+
+PackedFloat32Array LipSyncBaker::_extract_features(const PackedFloat32Array &p_samples, const String &p_audio_hash, Ref<AudioProcessor> p_processor, bool &r_cached) {
+    r_cached = false;
+    if (feature_cache_dir.is_empty()) {
+        return p_processor->process_clip(p_samples);
+    }
+    const mel_frontend::Config &config = p_processor->get_config();
+    const std::string hash = p_audio_hash.utf8().get_data();
+    const std::string path = feature_cache_dir.path_join(feature_cache::file_name(hash, config).c_str()).utf8().get_data();
+
+    PackedFloat32Array features;
+    feature_cache::View view;
+    if (view.open(path, hash, config)) {
+        features.resize(view.get_frames() * view.get_n_mels());
+        view.decode(features.ptrw());
+        r_cached = true;
+        return features;
+    }
+
+    features = p_processor->process_clip(p_samples);
+    const int64_t frames = features.size() / config.n_mels;
+    if (!feature_cache::store(path, hash, config, features.ptr(), frames)) {
+        UtilityFunctions::printerr("LipSyncBaker: Could not write feature cache ", path.c_str());
+    }
+    float *data = features.ptrw();
+    for (int64_t i = 0; i < features.size(); i++) {
+        data[i] = half_float::to_float(half_float::from_float(data[i]));
+    }
+    return features;
+}
+
+String LipSyncBaker::get_track_path(const String &p_audio_path) {
+    return p_audio_path.get_basename() + ".lipsync";
+}
+
+// Reads a track header, false if the file is not a track of this version
+static bool _read_track_header(Ref<FileAccess> p_file, uint32_t &r_visemes, uint32_t &r_frames, float &r_fps, String &r_key) {
+    PackedByteArray magic = p_file->get_buffer(4);
+    if (magic.size() != 4 || memcmp(magic.ptr(), TRACK_MAGIC, 4) != 0 || p_file->get_32() != TRACK_VERSION) {
+        return false;
+    }
+    r_visemes = p_file->get_32();
+    r_frames = p_file->get_32();
+    r_fps = p_file->get_float();
+    r_key = p_file->get_pascal_string();
+    return true;
+}
+
+Dictionary LipSyncBaker::load_track(const String &p_path) {
+    Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ);
+    if (file.is_null()) {
+        return Dictionary();
+    }
+    uint32_t visemes;
+    uint32_t frames;
+    float fps;
+    String key;
+    if (!_read_track_header(file, visemes, frames, fps, key)) {
+        return Dictionary();
+    }
+    PackedByteArray bytes = file->get_buffer((int64_t)visemes * frames * sizeof(float));
+    if (bytes.size() != (int64_t)visemes * frames * (int64_t)sizeof(float)) {
+        return Dictionary();
+    }
+    Dictionary track;
+    track["visemes"] = bytes.to_float32_array();
+    track["viseme_count"] = (int64_t)visemes;
+    track["frames"] = (int64_t)frames;
+    track["fps"] = fps;
+    track["key"] = key;
+    return track;
+}
+
+PackedFloat32Array LipSyncBaker::bake_samples(const PackedFloat32Array &p_samples) {
+    if (model.is_null()) {
+        UtilityFunctions::printerr("LipSyncBaker: Model not loaded.");
+        return PackedFloat32Array();
+    }
+    Ref<AudioProcessor> processor;
+    processor.instantiate();
+    // Hashing is only worth it when there is a cache to look up
+    const String audio_hash = feature_cache_dir.is_empty() ? String() : _hash_bytes(p_samples.to_byte_array());
+    bool cached;
+    return model->run_offline(_extract_features(p_samples, audio_hash, processor, cached), context_size, threads);
+}
+
+bool LipSyncBaker::_bake_file(const String &p_path, Ref<AudioProcessor> p_processor, int p_threads, bool &r_skipped, bool &r_cached, double &r_audio_seconds) {
+    r_skipped = false;
+    r_cached = false;
+    r_audio_seconds = 0.0;
+    PackedByteArray bytes = FileAccess::get_file_as_bytes(p_path);
+    if (bytes.is_empty()) {
+        UtilityFunctions::printerr("LipSyncBaker: Could not read ", p_path);
+        return false;
+    }
+
+    const String track_path = get_track_path(p_path);
+    const String audio_hash = _hash_bytes(bytes);
+    const String key = _track_key(audio_hash, p_processor->get_config());
+    if (!force) {
+        Ref<FileAccess> existing = FileAccess::open(track_path, FileAccess::READ);
+        uint32_t visemes;
+        uint32_t frames;
+        float fps;
+        String existing_key;
+        // A bake cut short leaves a truncated body behind a valid header
+        if (existing.is_valid() && _read_track_header(existing, visemes, frames, fps, existing_key) && existing_key == key &&
+                existing->get_length() == existing->get_position() + (uint64_t)visemes * frames * sizeof(float)) {
+            r_skipped = true;
+            return true;
+        }
+    }
+
+    PackedFloat32Array samples = decode_wav(bytes);
+    bytes = PackedByteArray(); // Only the decoded clip is needed from here on
+    if (samples.is_empty()) {
+        UtilityFunctions::printerr("LipSyncBaker: Unsupported or empty WAV ", p_path);
+        return false;
+    }
+    r_audio_seconds = (double)samples.size() / TARGET_SAMPLE_RATE;
+
+    PackedFloat32Array visemes = model->run_offline(_extract_features(samples, audio_hash, p_processor, r_cached), context_size, p_threads);
+    const int64_t viseme_count = model->get_output_channels();
+    if (viseme_count <= 0 || (visemes.is_empty() && samples.size() >= HOP_LENGTH)) {
+        UtilityFunctions::printerr("LipSyncBaker: Inference failed for ", p_path);
+        return false;
+    }
+
+    // Written aside and renamed over the track, so an interrupted bake never
+    // leaves a half-written track that the next run would skip
+    const String temp_path = track_path + ".tmp";
+    Ref<FileAccess> file = FileAccess::open(temp_path, FileAccess::WRITE);
+    if (file.is_null()) {
+        UtilityFunctions::printerr("LipSyncBaker: Could not write ", temp_path);
+        return false;
+    }
+    PackedByteArray magic;
+    magic.resize(4);
+    memcpy(magic.ptrw(), TRACK_MAGIC, 4);
+    file->store_buffer(magic);
+    file->store_32(TRACK_VERSION);
+    file->store_32((uint32_t)viseme_count);
+    file->store_32((uint32_t)(visemes.size() / viseme_count));
+    file->store_float((float)TARGET_SAMPLE_RATE / HOP_LENGTH);
+    file->store_pascal_string(key);
+    file->store_buffer(visemes.to_byte_array());
+    const bool written = file->get_error() == OK;
+    file->close();
+    if (!written || DirAccess::rename_absolute(temp_path, track_path) != OK) {
+        UtilityFunctions::printerr("LipSyncBaker: Could not write ", track_path);
+        DirAccess::remove_absolute(temp_path);
+        return false;
+    }
+    return true;
+}
+
+Error LipSyncBaker::bake_file(const String &p_path) {
+    if (model.is_null()) {
+        UtilityFunctions::printerr("LipSyncBaker: Model not loaded.");
+        return ERR_UNCONFIGURED;
+    }
+    Ref<AudioProcessor> processor;
+    processor.instantiate();
+    bool skipped;
+    bool cached;
+    double audio_seconds;
+    return _bake_file(p_path, processor, threads, skipped, cached, audio_seconds) ? OK : FAILED;
+}
+
+static void _collect_wavs(const String &p_dir, bool p_recursive, std::vector<String> &r_files) {
+    PackedStringArray files = DirAccess::get_files_at(p_dir);
+    for (int64_t i = 0; i < files.size(); i++) {
+        if (files[i].get_extension().to_lower() == "wav") {
+            r_files.push_back(p_dir.path_join(files[i]));
+        }
+    }
+    if (p_recursive) {
+        PackedStringArray dirs = DirAccess::get_directories_at(p_dir);
+        for (int64_t i = 0; i < dirs.size(); i++) {
+            _collect_wavs(p_dir.path_join(dirs[i]), p_recursive, r_files);
+        }
+    }
+}
+
+Dictionary LipSyncBaker::bake_directory(const String &p_dir, bool p_recursive) {
+    Dictionary report;
+    if (model.is_null()) {
+        UtilityFunctions::printerr("LipSyncBaker: Model not loaded.");
+        return report;
+    }
+    uint64_t start = _ticks_usec();
+
+    // Plain vector: the workers index it concurrently
+    std::vector<String> files;
+    _collect_wavs(p_dir, p_recursive, files);
+
+    // Files are spread over the workers. With fewer files than cores, each file
+    // also splits its inference so a lone cutscene still uses every core.
+    const int total_threads = threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    const int workers = (int)std::max<int64_t>(1, std::min<int64_t>(total_threads, (int64_t)files.size()));
+    const int threads_per_file = std::max(1, total_threads / workers);
+
+    std::atomic<int64_t> next_file{0};
+    std::atomic<int64_t> baked{0};
+    std::atomic<int64_t> skipped{0};
+    std::atomic<int64_t> failed{0};
+    std::atomic<int64_t> features_cached{0};
+    std::mutex seconds_mutex;
+    double audio_seconds = 0.0;
+    auto worker = [&]() {
+        // AudioProcessor's batched path keeps per-instance tables
+        Ref<AudioProcessor> processor;
+        processor.instantiate();
+        for (int64_t i = next_file++; i < (int64_t)files.size(); i = next_file++) {
+            bool was_skipped;
+            bool was_cached;
+            double seconds;
+            if (!_bake_file(files[i], processor, threads_per_file, was_skipped, was_cached, seconds)) {
+                failed++;
+            } else if (was_skipped) {
+                skipped++;
+            } else {
+                baked++;
+                features_cached += was_cached ? 1 : 0;
+                std::lock_guard<std::mutex> lock(seconds_mutex);
+                audio_seconds += seconds;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 1; i < workers; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+
+    double wall_seconds = (_ticks_usec() - start) / 1000000.0;
+    report["files"] = (int64_t)files.size();
+    report["baked"] = baked.load();
+    report["skipped"] = skipped.load();
+    report["failed"] = failed.load();
+    report["features_cached"] = features_cached.load();
+    report["audio_seconds"] = audio_seconds;
+    report["wall_seconds"] = wall_seconds;
+    report["realtime_factor"] = wall_seconds > 0.0 ? audio_seconds / wall_seconds : 0.0;
+    report["files_per_second"] = wall_seconds > 0.0 ? (double)(baked.load() + skipped.load()) / wall_seconds : 0.0;
+    return report;
+}
+
+void LipSyncBaker::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("load_model", "path"), &LipSyncBaker::load_model);
+    ClassDB::bind_method(D_METHOD("get_receptive_field"), &LipSyncBaker::get_receptive_field);
+    ClassDB::bind_method(D_METHOD("set_context_size", "frames"), &LipSyncBaker::set_context_size);
+    ClassDB::bind_method(D_METHOD("get_context_size"), &LipSyncBaker::get_context_size);
+    ClassDB::bind_method(D_METHOD("set_threads", "threads"), &LipSyncBaker::set_threads);
+    ClassDB::bind_method(D_METHOD("get_threads"), &LipSyncBaker::get_threads);
+    ClassDB::bind_method(D_METHOD("set_force", "force"), &LipSyncBaker::set_force);
+    ClassDB::bind_method(D_METHOD("is_force"), &LipSyncBaker::is_force);
+    ClassDB::bind_method(D_METHOD("set_feature_cache_dir", "dir"), &LipSyncBaker::set_feature_cache_dir);
+    ClassDB::bind_method(D_METHOD("get_feature_cache_dir"), &LipSyncBaker::get_feature_cache_dir);
+
+    ClassDB::bind_static_method("LipSyncBaker", D_METHOD("decode_wav", "bytes"), &LipSyncBaker::decode_wav);
+    ClassDB::bind_method(D_METHOD("bake_samples", "samples"), &LipSyncBaker::bake_samples);
+    ClassDB::bind_method(D_METHOD("bake_file", "path"), &LipSyncBaker::bake_file);
+    ClassDB::bind_method(D_METHOD("bake_directory", "dir", "recursive"), &LipSyncBaker::bake_directory, DEFVAL(true));
+    ClassDB::bind_static_method("LipSyncBaker", D_METHOD("get_track_path", "audio_path"), &LipSyncBaker::get_track_path);
+    ClassDB::bind_static_method("LipSyncBaker", D_METHOD("load_track", "path"), &LipSyncBaker::load_track);
+}
@@ -0,0 +1,87 @@
+#ifndef LIP_SYNC_BAKER_H
+#define LIP_SYNC_BAKER_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include "audio_processor.h"
+#include "onnx_model.h"
+
+namespace godot {
+
+// Offline baking of viseme tracks for WAV files, for build pipelines and
+// import plugins. Each track is written next to its audio with the same base
+// name and a .lipsync extension. Its header records a key made of the audio's
+// content hash, the model's hash, the context size, the feature precision
+// (half floats with a feature cache) and the mel frontend config, so unchanged
+// files are skipped on the next run.
+//
+// Track layout (little endian):
+//   "OLSY", u32 version, u32 visemes, u32 frames, f32 frames per second,
+//   pascal string key, f32 visemes[frames * visemes] (frame-major)
+class LipSyncBaker : public RefCounted {
+    GDCLASS(LipSyncBaker, RefCounted)
+
+private:
+    Ref<OnnxModel> model;
+    String model_hash;
+    int context_size = 100; // Must match the LipSyncContext the track replaces
+    int threads = 0;        // 0 = all cores
+    bool force = false;     // Rebake even when the key matches
+    String feature_cache_dir; // Empty = no feature cache
+
+    static String _hash_bytes(const PackedByteArray &p_bytes);
+    String _track_key(const String &p_audio_hash, const mel_frontend::Config &p_config) const;
+    // Log-mel features of a clip, from the feature cache when it has them.
+    // With a cache, fresh features are rounded through half floats as well, so
+    // a bake gives the same result whether or not its features were already
+    // cached. Without one they stay float32; the track key tells the two apart.
+    PackedFloat32Array _extract_features(const PackedFloat32Array &p_samples, const String &p_audio_hash, Ref<AudioProcessor> p_processor, bool &r_cached);
+    // Decodes, bakes and writes one file. r_audio_seconds is the clip length.
+    bool _bake_file(const String &p_path, Ref<AudioProcessor> p_processor, int p_threads, bool &r_skipped, bool &r_cached, double &r_audio_seconds);
+
+protected:
+    static void _bind_methods();
+
+public:
+    // Picks the full-output graph when the receptive field fits in the context
+    // (chunked offline path), the last-frame graph otherwise. Set the context
+    // size first.
+    bool load_model(const String &p_path);
+    // Of the loaded model, in frames; 0 if unknown or nothing is loaded
+    int get_receptive_field() const;
+
+    void set_context_size(int p_frames);
+    int get_context_size() const { return context_size; }
+    void set_threads(int p_threads) { threads = p_threads < 0 ? 0 : p_threads; }
+    int get_threads() const { return threads; }
+    void set_force(bool p_force) { force = p_force; }
+    bool is_force() const { return force; }
+    // Keeps every clip's features in p_dir (see feature_cache.h), keyed by the
+    // audio's hash and the frontend config, so re-bakes with another model or
+    // context size skip extraction. Features are stored as half floats.
+    void set_feature_cache_dir(const String &p_dir);
+    String get_feature_cache_dir() const { return feature_cache_dir; }
+
+    // RIFF WAVE (PCM 8/16/24/32-bit or float 32/64-bit) to 16 kHz mono.
+    // Empty on unsupported or malformed data.
+    static PackedFloat32Array decode_wav(const PackedByteArray &p_bytes);
+
+    // Visemes for every hop of a 16 kHz mono clip [hops * visemes]
+    PackedFloat32Array bake_samples(const PackedFloat32Array &p_samples);
+    // Bakes one WAV file unless its track is up to date
+    Error bake_file(const String &p_path);
+    // Bakes every .wav under p_dir, files in parallel. Returns counts and
+    // throughput: files, baked, skipped, failed, features_cached, audio_seconds,
+    // wall_seconds, realtime_factor, files_per_second.
+    Dictionary bake_directory(const String &p_dir, bool p_recursive = true);
+
+    static String get_track_path(const String &p_audio_path);
+    // Returns visemes, frames, fps and key, or an empty Dictionary on error
+    static Dictionary load_track(const String &p_path);
+};
+
+} // namespace godot
+
+#endif
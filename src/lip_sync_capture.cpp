@@ -0,0 +1,103 @@
+#include "lip_sync_capture.h"
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_vector2_array.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <cstring>
+
+using namespace godot;
+
+bool LipSyncCapture::open(const String &p_path) {
+    close();
+    const String path = ProjectSettings::get_singleton()->globalize_path(p_path);
+    if (!reader.open(path.utf8().get_data())) {
+        UtilityFunctions::printerr("LipSyncCapture: ", p_path, " is not a readable capture.");
+        return false;
+    }
+    is_open = true;
+    return true;
+}
+
+void LipSyncCapture::close() {
+    reader.close();
+    record = {};
+    payload.clear();
+    has_record = false;
+    is_open = false;
+}
+
+void LipSyncCapture::configure(const Ref<LipSyncContext> &p_context) const {
+    if (p_context.is_null() || !is_open) {
+        return;
+    }
+    p_context->set_context_size(get_context_size());
+    p_context->set_half_history(is_half_history());
+}
+
+bool LipSyncCapture::next() {
+    has_record = is_open && reader.next(record, payload);
+    if (!has_record) {
+        record = {};
+        payload.clear();
+    }
+    return has_record;
+}
+
+PackedFloat32Array LipSyncCapture::replay(const Ref<LipSyncContext> &p_context) const {
+    if (p_context.is_null() || !has_record) {
+        return PackedFloat32Array();
+    }
+    switch (record.kind) {
+        case capture_log::KIND_FRAMES: {
+            // Float pairs in the log, whatever the build's Vector2 precision
+            const int64_t count = payload.size() / (2 * sizeof(float));
+            const float *pairs = (const float *)payload.data();
+            PackedVector2Array frames;
+            frames.resize(count);
+            Vector2 *dst = frames.ptrw();
+            for (int64_t i = 0; i < count; i++) {
+                dst[i] = Vector2(pairs[i * 2], pairs[i * 2 + 1]);
+            }
+            return p_context->process(frames, record.sample_rate);
+        }
+        case capture_log::KIND_MONO: {
+            PackedFloat32Array samples;
+            samples.resize(payload.size() / sizeof(float));
+            memcpy(samples.ptrw(), payload.data(), samples.size() * sizeof(float));
+            return p_context->process_mono(samples, record.sample_rate);
+        }
+        case capture_log::KIND_PCM16: {
+            PackedByteArray pcm;
+            pcm.resize(payload.size());
+            memcpy(pcm.ptrw(), payload.data(), payload.size());
+            return p_context->process_pcm16(pcm, record.channels, record.sample_rate);
+        }
+        case capture_log::KIND_RESET:
+            p_context->reset();
+            break;
+    }
+    return PackedFloat32Array();
+}
+
+void LipSyncCapture::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("open", "path"), &LipSyncCapture::open);
+    ClassDB::bind_method(D_METHOD("close"), &LipSyncCapture::close);
+    ClassDB::bind_method(D_METHOD("get_context_size"), &LipSyncCapture::get_context_size);
+    ClassDB::bind_method(D_METHOD("is_half_history"), &LipSyncCapture::is_half_history);
+    ClassDB::bind_method(D_METHOD("get_model_path"), &LipSyncCapture::get_model_path);
+    ClassDB::bind_method(D_METHOD("get_start_unix_usec"), &LipSyncCapture::get_start_unix_usec);
+    ClassDB::bind_method(D_METHOD("configure", "context"), &LipSyncCapture::configure);
+    ClassDB::bind_method(D_METHOD("next"), &LipSyncCapture::next);
+    ClassDB::bind_method(D_METHOD("get_call"), &LipSyncCapture::get_call);
+    ClassDB::bind_method(D_METHOD("get_time"), &LipSyncCapture::get_time);
+    ClassDB::bind_method(D_METHOD("get_sample_rate"), &LipSyncCapture::get_sample_rate);
+    ClassDB::bind_method(D_METHOD("get_channels"), &LipSyncCapture::get_channels);
+    ClassDB::bind_method(D_METHOD("get_recorded_usec"), &LipSyncCapture::get_recorded_usec);
+    ClassDB::bind_method(D_METHOD("replay", "context"), &LipSyncCapture::replay);
+
+    BIND_ENUM_CONSTANT(CALL_PROCESS);
+    BIND_ENUM_CONSTANT(CALL_PROCESS_MONO);
+    BIND_ENUM_CONSTANT(CALL_PROCESS_PCM16);
+    BIND_ENUM_CONSTANT(CALL_RESET);
+}
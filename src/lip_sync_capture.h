@@ -0,0 +1,65 @@
+#ifndef LIP_SYNC_CAPTURE_H
+#define LIP_SYNC_CAPTURE_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include "capture_log.h"
+#include "lip_sync_context.h"
+
+namespace godot {
+
+// Reads a capture written by LipSyncContext.start_recording() and replays it
+// call for call on another context: the same entry point, audio block and
+// source rate, in the recorded order. Pacing is up to the caller; get_time()
+// is when the call happened in the field, get_recorded_usec() how long it
+// took there. See tools/replay_capture.gd.
+class LipSyncCapture : public RefCounted {
+    GDCLASS(LipSyncCapture, RefCounted)
+
+public:
+    enum Call {
+        CALL_PROCESS,
+        CALL_PROCESS_MONO,
+        CALL_PROCESS_PCM16,
+        CALL_RESET,
+    };
+
+private:
+    capture_log::Reader reader;
+    capture_log::RecordHeader record = {};
+    std::vector<uint8_t> payload;
+    bool has_record = false;
+    bool is_open = false;
+
+protected:
+    static void _bind_methods();
+
+public:
+    bool open(const String &p_path);
+    void close();
+
+    // Context settings and model at the time of recording
+    int get_context_size() const { return reader.get_header().context_size; }
+    bool is_half_history() const { return (reader.get_header().flags & capture_log::FLAG_HALF_HISTORY) != 0; }
+    String get_model_path() const { return String::utf8(reader.get_model_path().c_str()); }
+    int64_t get_start_unix_usec() const { return (int64_t)reader.get_header().start_unix_usec; }
+    // Applies the recorded context settings
+    void configure(const Ref<LipSyncContext> &p_context) const;
+
+    // Advances to the next call; false at the end of the capture
+    bool next();
+    Call get_call() const { return (Call)record.kind; }
+    double get_time() const { return record.time_usec / 1e6; }
+    int get_sample_rate() const { return record.sample_rate; }
+    int get_channels() const { return record.channels; }
+    int64_t get_recorded_usec() const { return record.duration_usec; }
+
+    // Makes the current call on p_context and returns what it returned
+    PackedFloat32Array replay(const Ref<LipSyncContext> &p_context) const;
+};
+
+} // namespace godot
+
+VARIANT_ENUM_CAST(LipSyncCapture::Call);
+
+#endif
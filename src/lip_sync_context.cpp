@@ -1,7 +1,12 @@
 #include "lip_sync_context.h"
+#include "half_float.h"
+#include "pcm_convert.h"
 #include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 using namespace godot;
 
@@ -12,33 +17,175 @@ LipSyncContext::LipSyncContext() {
     processor->set_hop_length(160); // 10ms
     processor->set_window_length(400); // 25ms
     processor->set_mel_bands(80);
-}
-
-LipSyncContext::~LipSyncContext() {
+    n_mels = processor->get_config().n_mels;
+    _resize_history(context_size, half_history);
 }
 
 bool LipSyncContext::load_model(const String &p_path) {
+    // A synchronous load supersedes any async one still in flight
+    model_load.reset();
+
     if (model.is_null()) {
         model.instantiate();
     }
+    // Only the newest frame is used, so let the model compute just that one
+    model->set_last_frame_only(true);
+    // Warm up at the size real calls will reach once the history is full
+    model->set_warmup_frames(context_size);
     bool success = model->load_model(p_path);
     if (success) {
+        model_path = p_path;
+        offline_model.unref();
         reset();
     }
     return success;
 }
 
+bool LipSyncContext::load_model_async(const String &p_path) {
+    if (is_loading()) {
+        UtilityFunctions::printerr("LipSyncContext: A model is already loading.");
+        return false;
+    }
+
+    // Configure on the calling thread, then hand the new model to the worker
+    Ref<OnnxModel> new_model;
+    new_model.instantiate();
+    new_model->set_last_frame_only(true);
+    new_model->set_warmup_frames(context_size);
+    if (model.is_valid()) {
+        // Carry over the user's opt-ins, so a hot swap keeps the same graph
+        // rewrites and profiling as the model it replaces
+        new_model->set_fused_conv(model->is_fused_conv());
+        new_model->set_profiling_enabled(model->is_profiling_enabled());
+        new_model->set_profile_prefix(model->get_profile_prefix());
+        new_model->set_warmup_runs(model->get_warmup_runs());
+    }
+    // Already off the main thread, so warm up inline before the swap
+    new_model->set_warmup_on_worker(false);
+
+    std::shared_ptr<ModelLoad> load = std::make_shared<ModelLoad>();
+    load->id = ++model_load_count;
+    load->path = p_path;
+    model_load = load;
+    // The deferred call goes through the context's instance ID, so it is
+    // dropped rather than run on a freed context
+    std::thread(&LipSyncContext::_load_model_worker, load, new_model, Callable(this, "_emit_model_loaded")).detach();
+    return true;
+}
+
+void LipSyncContext::_load_model_worker(std::shared_ptr<ModelLoad> p_load, Ref<OnnxModel> p_model, Callable p_done) {
+    bool success = p_model->load_model(p_load->path);
+    if (success) {
+        std::lock_guard<std::mutex> lock(p_load->mutex);
+        p_load->model = p_model;
+        p_load->ready.store(true, std::memory_order_release);
+    }
+    p_load->loading = false;
+    p_done.call_deferred(p_load->id, p_load->path, success);
+}
+
+void LipSyncContext::_swap_pending_model() {
+    std::lock_guard<std::mutex> lock(model_load->mutex);
+    if (model_load->model.is_valid()) {
+        model = model_load->model;
+        model_load->model.unref();
+        model_path = model_load->path;
+        offline_model.unref();
+    }
+    model_load->ready = false;
+}
+
+void LipSyncContext::_emit_model_loaded(int64_t p_id, const String &p_path, bool p_success) {
+    // A synchronous load_model drops the block, so its model is never swapped in
+    const bool current = model_load && model_load->id == p_id;
+    emit_signal("model_loaded", p_path, p_success && current);
+}
+
 void LipSyncContext::set_context_size(int p_frames) {
+    p_frames = std::max(1, p_frames);
+    _resize_history(p_frames, half_history);
     context_size = p_frames;
-    // Trim buffer if needed
-    while (feature_buffer.size() > context_size) {
-        feature_buffer.pop_front();
+    // The daemon's view of the window buffer is sized at connect time
+    if (is_using_daemon() && (uint32_t)p_frames > daemon->max_frames()) {
+        connect_daemon(daemon_socket_path);
     }
 }
 
+void LipSyncContext::set_half_history(bool p_enabled) {
+    if (p_enabled != half_history) {
+        _resize_history(context_size, p_enabled);
+    }
+}
+
+int64_t LipSyncContext::get_history_bytes() const {
+    return (int64_t)(feature_history.capacity() * sizeof(float) + feature_history_half.capacity() * sizeof(uint16_t));
+}
+
+void LipSyncContext::_resize_history(int p_frames, bool p_half) {
+    // Newest frames in order, as float32
+    const int capacity = context_size;
+    const int keep = std::min(history_frames, p_frames);
+    std::vector<float> kept((size_t)keep * n_mels);
+    for (int i = 0; i < keep; i++) {
+        const size_t slot = (size_t)((history_start + history_frames - keep + i) % capacity) * n_mels;
+        if (half_history) {
+            half_float::decode(feature_history_half.data() + slot, kept.data() + (size_t)i * n_mels, n_mels);
+        } else {
+            memcpy(kept.data() + (size_t)i * n_mels, feature_history.data() + slot, n_mels * sizeof(float));
+        }
+    }
+
+    // Swapped out rather than cleared, so the old precision's memory is freed
+    std::vector<float>().swap(feature_history);
+    std::vector<uint16_t>().swap(feature_history_half);
+    if (p_half) {
+        feature_history_half.resize((size_t)p_frames * n_mels);
+        half_float::encode(kept.data(), feature_history_half.data(), (int64_t)kept.size());
+    } else {
+        feature_history.resize((size_t)p_frames * n_mels);
+        std::copy(kept.begin(), kept.end(), feature_history.begin());
+    }
+    half_history = p_half;
+    history_start = 0;
+    history_frames = keep;
+}
+
+void LipSyncContext::_push_features(const float *p_features) {
+    int slot;
+    if (history_frames < context_size) {
+        slot = (history_start + history_frames) % context_size;
+        history_frames++;
+    } else {
+        // Full: overwrite the oldest frame
+        slot = history_start;
+        history_start = (history_start + 1) % context_size;
+    }
+    if (half_history) {
+        half_float::encode(p_features, feature_history_half.data() + (size_t)slot * n_mels, n_mels);
+    } else {
+        memcpy(feature_history.data() + (size_t)slot * n_mels, p_features, n_mels * sizeof(float));
+    }
+}
+
+// Copies the ring's frames oldest first into r_dst
+template <typename T>
+static void _unroll_history(const std::vector<T> &p_ring, int p_start, int p_frames, int p_capacity, int p_n_mels, T *r_dst) {
+    const int head = std::min(p_frames, p_capacity - p_start);
+    memcpy(r_dst, p_ring.data() + (size_t)p_start * p_n_mels, (size_t)head * p_n_mels * sizeof(T));
+    memcpy(r_dst + (size_t)head * p_n_mels, p_ring.data(), (size_t)(p_frames - head) * p_n_mels * sizeof(T));
+}
+
 void LipSyncContext::reset() {
+    if (capture) {
+        _capture_call(capture_log::KIND_RESET, 0, 0, nullptr, 0, capture_log::ticks_usec());
+    }
     audio_buffer.clear();
-    feature_buffer.clear();
+    output_history.clear();
+    stream_hops = 0;
+    peak_level = 0.0f;
+    rms_level = 0.0f;
+    history_start = 0;
+    history_frames = 0;
     if (processor.is_valid()) {
         processor->reset();
     }
@@ -49,6 +196,7 @@ void LipSyncContext::_resample_and_push(const float* input, int count, int sourc
     if (count == 0) return;
 
     if (source_rate != target_sample_rate) {
+        latency_histogram::Scope timer(LATENCY_RESAMPLE);
         // Simple Linear Interpolation Resampling
         float ratio = (float)source_rate / (float)target_sample_rate;
         
@@ -97,9 +245,96 @@ void LipSyncContext::_resample_and_push(const float* input, int count, int sourc
     }
 }
 
-PackedFloat32Array LipSyncContext::process(const PackedVector2Array &p_audio_data, int p_source_sample_rate) {
-    if (model.is_null()) {
+bool LipSyncContext::_begin_process() {
+    // Swap in an async-loaded model between hops; history is kept as is
+    if (model_load && model_load->ready.load(std::memory_order_acquire)) {
+        _swap_pending_model();
+    }
+
+    if (model.is_null() && !is_using_daemon()) {
         // UtilityFunctions::printerr("LipSyncContext: Model not loaded.");
+        return false;
+    }
+    return true;
+}
+
+PackedFloat32Array LipSyncContext::process(const PackedVector2Array &p_audio_data, int p_source_sample_rate) {
+    if (!capture && !latency_histogram::is_enabled()) {
+        return _process_frames(p_audio_data, p_source_sample_rate);
+    }
+    const uint64_t start_ns = latency_histogram::now_ns();
+    PackedFloat32Array result = _process_frames(p_audio_data, p_source_sample_rate);
+    _record_process_latency(start_ns);
+    if (!capture) {
+        return result;
+    }
+    const uint64_t start = start_ns / 1000;
+    if (sizeof(Vector2) == 2 * sizeof(float)) {
+        _capture_call(capture_log::KIND_FRAMES, 2, p_source_sample_rate, p_audio_data.ptr(), p_audio_data.size() * sizeof(Vector2), start);
+    } else {
+        // Double-precision builds: the log always holds float pairs
+        thread_local std::vector<float> pairs;
+        pairs.resize((size_t)p_audio_data.size() * 2);
+        for (int64_t i = 0; i < p_audio_data.size(); i++) {
+            pairs[i * 2] = (float)p_audio_data[i].x;
+            pairs[i * 2 + 1] = (float)p_audio_data[i].y;
+        }
+        _capture_call(capture_log::KIND_FRAMES, 2, p_source_sample_rate, pairs.data(), pairs.size() * sizeof(float), start);
+    }
+    return result;
+}
+
+PackedFloat32Array LipSyncContext::process_mono(const PackedFloat32Array &p_samples, int p_source_sample_rate) {
+    if (!capture && !latency_histogram::is_enabled()) {
+        return _process_mono(p_samples, p_source_sample_rate);
+    }
+    const uint64_t start_ns = latency_histogram::now_ns();
+    PackedFloat32Array result = _process_mono(p_samples, p_source_sample_rate);
+    _record_process_latency(start_ns);
+    if (capture) {
+        _capture_call(capture_log::KIND_MONO, 1, p_source_sample_rate, p_samples.ptr(), p_samples.size() * sizeof(float), start_ns / 1000);
+    }
+    return result;
+}
+
+PackedFloat32Array LipSyncContext::process_pcm16(const PackedByteArray &p_pcm, int p_channels, int p_source_sample_rate) {
+    if (!capture && !latency_histogram::is_enabled()) {
+        return _process_pcm16(p_pcm, p_channels, p_source_sample_rate);
+    }
+    const uint64_t start_ns = latency_histogram::now_ns();
+    PackedFloat32Array result = _process_pcm16(p_pcm, p_channels, p_source_sample_rate);
+    _record_process_latency(start_ns);
+    if (capture) {
+        _capture_call(capture_log::KIND_PCM16, p_channels, p_source_sample_rate, p_pcm.ptr(), p_pcm.size(), start_ns / 1000);
+    }
+    return result;
+}
+
+void LipSyncContext::_capture_call(capture_log::Kind p_kind, int p_channels, int p_sample_rate, const void *p_payload, size_t p_bytes, uint64_t p_start_usec) {
+    if (!capture->write(p_kind, p_channels, p_sample_rate, p_payload, p_bytes, p_start_usec, capture_log::ticks_usec() - p_start_usec)) {
+        UtilityFunctions::printerr("LipSyncContext: Stopped recording, the capture file could not be written.");
+        capture.reset();
+    }
+}
+
+bool LipSyncContext::start_recording(const String &p_path) {
+    stop_recording();
+    const String path = ProjectSettings::get_singleton()->globalize_path(p_path);
+    std::unique_ptr<capture_log::Writer> writer(new capture_log::Writer());
+    if (!writer->open(path.utf8().get_data(), context_size, n_mels, half_history ? capture_log::FLAG_HALF_HISTORY : 0, model_path.utf8().get_data())) {
+        UtilityFunctions::printerr("LipSyncContext: Could not create capture file ", p_path);
+        return false;
+    }
+    capture = std::move(writer);
+    return true;
+}
+
+void LipSyncContext::stop_recording() {
+    capture.reset();
+}
+
+PackedFloat32Array LipSyncContext::_process_frames(const PackedVector2Array &p_audio_data, int p_source_sample_rate) {
+    if (!_begin_process()) {
         return PackedFloat32Array();
     }
 
@@ -113,13 +348,92 @@ PackedFloat32Array LipSyncContext::process(const PackedVector2Array &p_audio_dat
     // Use stack or temporary vector
     std::vector<float> mono_input(sample_count);
     const Vector2* ptr = p_audio_data.ptr();
+    // Metering rides along with the downmix
+    float peak = 0.0f;
+    double sum_sq = 0.0;
     for (int i = 0; i < sample_count; i++) {
-        mono_input[i] = (ptr[i].x + ptr[i].y) * 0.5f;
+        float mono = (ptr[i].x + ptr[i].y) * 0.5f;
+        mono_input[i] = mono;
+        peak = std::max(peak, std::fabs(mono));
+        sum_sq += (double)mono * mono;
     }
+    peak_level = peak;
+    rms_level = (float)std::sqrt(sum_sq / sample_count);
 
     // 2. Resample and Buffer
     _resample_and_push(mono_input.data(), sample_count, p_source_sample_rate);
 
+    return _process_hops();
+}
+
+PackedFloat32Array LipSyncContext::_process_mono(const PackedFloat32Array &p_samples, int p_source_sample_rate) {
+    if (!_begin_process() || p_samples.is_empty()) {
+        return PackedFloat32Array();
+    }
+    // Already mono floats: straight into the resampler
+    _measure_levels(p_samples.ptr(), p_samples.size());
+    _resample_and_push(p_samples.ptr(), p_samples.size(), p_source_sample_rate);
+    return _process_hops();
+}
+
+PackedFloat32Array LipSyncContext::_process_pcm16(const PackedByteArray &p_pcm, int p_channels, int p_source_sample_rate) {
+    if (p_channels < 1) {
+        UtilityFunctions::printerr("LipSyncContext: process_pcm16 needs at least one channel.");
+        return PackedFloat32Array();
+    }
+    if (!_begin_process()) {
+        return PackedFloat32Array();
+    }
+    // A trailing partial frame is dropped
+    const int frame_count = (int)(p_pcm.size() / (2 * p_channels));
+    if (frame_count == 0) {
+        return PackedFloat32Array();
+    }
+
+    if (p_source_sample_rate == target_sample_rate) {
+        // No resampling: convert and downmix straight into the audio buffer
+        size_t offset = audio_buffer.size();
+        audio_buffer.resize(offset + frame_count);
+        pcm_convert::int16_to_mono(p_pcm.ptr(), frame_count, p_channels, audio_buffer.data() + offset);
+        _measure_levels(audio_buffer.data() + offset, frame_count);
+    } else {
+        thread_local std::vector<float> mono_input;
+        mono_input.resize(frame_count);
+        pcm_convert::int16_to_mono(p_pcm.ptr(), frame_count, p_channels, mono_input.data());
+        _measure_levels(mono_input.data(), frame_count);
+        _resample_and_push(mono_input.data(), frame_count, p_source_sample_rate);
+    }
+    return _process_hops();
+}
+
+void LipSyncContext::_measure_levels(const float *p_mono, int p_count) {
+    float peak = 0.0f;
+    double sum_sq = 0.0;
+    for (int i = 0; i < p_count; i++) {
+        peak = std::max(peak, std::fabs(p_mono[i]));
+        sum_sq += (double)p_mono[i] * p_mono[i];
+    }
+    peak_level = peak;
+    rms_level = p_count > 0 ? (float)std::sqrt(sum_sq / p_count) : 0.0f;
+}
+
+PackedFloat32Array LipSyncContext::get_band_energy() const {
+    return processor.is_valid() ? processor->get_band_energy() : PackedFloat32Array();
+}
+
+float LipSyncContext::get_mel_energy() const {
+    PackedFloat32Array bands = get_band_energy();
+    if (bands.is_empty()) {
+        return -100.0f; // The 1e-10 power floor
+    }
+    float sum = 0.0f;
+    for (int64_t i = 0; i < bands.size(); i++) {
+        sum += bands[i];
+    }
+    return sum / bands.size();
+}
+
+PackedFloat32Array LipSyncContext::_process_hops() {
     // 3. Process Hops
     bool new_features_added = false;
     int hop_length = 160; // Hardcoded default for now, should get from processor
@@ -138,60 +452,77 @@ PackedFloat32Array LipSyncContext::process(const PackedVector2Array &p_audio_dat
         }
         
         // Process
-        PackedFloat32Array features = processor->process_frame(chunk);
+        PackedFloat32Array features;
+        {
+            latency_histogram::Scope timer(LATENCY_FEATURES);
+            features = processor->process_frame(chunk);
+        }
         
-        // Append to feature buffer
-        // features is a flat array of 80 floats
-        if (features.size() > 0) {
-             std::vector<float> f_vec(features.size());
-             const float* f_ptr = features.ptr();
-             for(int i=0; i<features.size(); i++) f_vec[i] = f_ptr[i];
-             
-             feature_buffer.push_back(f_vec);
-             new_features_added = true;
+        // Append to the history; features is a flat array of n_mels floats
+        if (features.size() == n_mels) {
+            _push_features(features.ptr());
+            new_features_added = true;
         }
+        stream_hops++;
         
         // Remove processed samples from audio buffer
         // Note: This is inefficient (erase from beginning of vector). 
         // Use deque or index offset for production, but vector::erase is fine for small chunks (160 floats).
         audio_buffer.erase(audio_buffer.begin(), audio_buffer.begin() + hop_length);
-        
-        // Enforce max context size
-        if (feature_buffer.size() > context_size) {
-            feature_buffer.pop_front();
-        }
     }
     
     // 4. Run Inference (if we have new data)
-    if (new_features_added && !feature_buffer.empty()) {
+    if (new_features_added && history_frames > 0) {
         // Prepare flat input for ONNX
-        // Model expects (Batch, Time, Channels) -> (1, T, 80)
-        // Flattened: [Frame0(80), Frame1(80)...]
-        
-        int n_frames = feature_buffer.size();
-        int n_mels = 80; // Should get from processor
-        
-        PackedFloat32Array flat_input;
-        flat_input.resize(n_frames * n_mels);
-        float* dest = flat_input.ptrw();
-        
-        for (int i = 0; i < n_frames; i++) {
-            const std::vector<float>& frame = feature_buffer[i];
-            for (int j = 0; j < n_mels; j++) {
-                dest[i * n_mels + j] = frame[j];
+        // Model expects (Batch, Time, Channels) -> (1, T, n_mels)
+        // Flattened: [Frame0(n_mels), Frame1(n_mels)...], oldest first
+        int n_frames = history_frames;
+        const size_t count = (size_t)n_frames * n_mels;
+
+        if (is_using_daemon()) {
+            PackedFloat32Array visemes;
+            {
+                latency_histogram::Scope timer(LATENCY_INFERENCE);
+                visemes = _infer_on_daemon(n_frames);
+            }
+            if (!visemes.is_empty() || model.is_null()) {
+                if (!visemes.is_empty()) {
+                    _record_output(visemes);
+                }
+                return visemes;
+            }
+        }
+
+        // Shared by every context on this thread, so only the ring is per character
+        thread_local std::vector<float> input_scratch;
+        thread_local std::vector<uint16_t> half_input_scratch;
+        PackedFloat32Array output;
+        {
+            latency_histogram::Scope timer(LATENCY_INFERENCE);
+            if (half_history) {
+                half_input_scratch.resize(count);
+                _unroll_history(feature_history_half, history_start, n_frames, context_size, n_mels, half_input_scratch.data());
+                output = model->run_inference_raw(half_input_scratch.data(), true, count);
+            } else {
+                input_scratch.resize(count);
+                _unroll_history(feature_history, history_start, n_frames, context_size, n_mels, input_scratch.data());
+                output = model->run_inference_raw(input_scratch.data(), false, count);
             }
         }
         
-        // Run inference
-        PackedFloat32Array output = model->run_inference(flat_input);
-        
-        // Output shape: (1, T, Visemes) flattened
-        // We want the LAST frame's prediction
-        // output size = T * num_visemes
-        // num_visemes = output.size() / T
-        
+        // Output shape: (1, T, Visemes) flattened, or (1, 1, Visemes) when the
+        // model was rewritten to emit only the last step
         if (output.size() > 0) {
-            int num_visemes = output.size() / n_frames;
+            if (model->has_last_frame_output()) {
+                _record_output(output);
+                return output;
+            }
+
+            // We want the LAST frame's prediction
+            int num_visemes = model->get_output_channels();
+            if (num_visemes <= 0) {
+                num_visemes = output.size() / n_frames;
+            }
             
             // Extract last frame
             PackedFloat32Array result;
@@ -199,11 +530,12 @@ PackedFloat32Array LipSyncContext::process(const PackedVector2Array &p_audio_dat
             float* res_ptr = result.ptrw();
             const float* out_ptr = output.ptr();
             
-            int start_idx = (n_frames - 1) * num_visemes;
+            int start_idx = output.size() - num_visemes;
             for (int i = 0; i < num_visemes; i++) {
                 res_ptr[i] = out_ptr[start_idx + i];
             }
             
+            _record_output(result);
             return result;
         }
     }
@@ -211,9 +543,297 @@ PackedFloat32Array LipSyncContext::process(const PackedVector2Array &p_audio_dat
     return PackedFloat32Array(); // No new prediction
 }
 
+PackedFloat32Array LipSyncContext::_infer_on_daemon(int p_frames) {
+    // The window is unrolled straight into the buffer the daemon reads
+    float *window = daemon->window_buffer();
+    if (half_history) {
+        thread_local std::vector<uint16_t> half_window;
+        half_window.resize((size_t)p_frames * n_mels);
+        _unroll_history(feature_history_half, history_start, p_frames, context_size, n_mels, half_window.data());
+        half_float::decode(half_window.data(), window, (int64_t)half_window.size());
+    } else {
+        _unroll_history(feature_history, history_start, p_frames, context_size, n_mels, window);
+    }
+
+    PackedFloat32Array visemes;
+    visemes.resize(daemon->viseme_count());
+    std::string error;
+    if (!daemon->infer_in_place((uint32_t)p_frames, visemes.ptrw(), error)) {
+        UtilityFunctions::printerr("LipSyncContext: Daemon inference failed: ", error.c_str(),
+                model.is_valid() ? ". Using the local model." : ".");
+        return PackedFloat32Array();
+    }
+    return visemes;
+}
+
+bool LipSyncContext::connect_daemon(const String &p_socket_path) {
+    if (!daemon) {
+        daemon.reset(new DaemonClient());
+    }
+    std::string error;
+    if (!daemon->connect(p_socket_path.utf8().get_data(), (uint32_t)context_size, (uint32_t)n_mels, error)) {
+        UtilityFunctions::printerr("LipSyncContext: Could not connect to the lip-sync daemon: ", error.c_str());
+        return false;
+    }
+    daemon_socket_path = p_socket_path;
+    return true;
+}
+
+void LipSyncContext::disconnect_daemon() {
+    if (daemon) {
+        daemon->close();
+    }
+}
+
+void LipSyncContext::_record_output(const PackedFloat32Array &p_visemes) {
+    output_history.push_back({ get_stream_time(), p_visemes });
+    while ((int)output_history.size() > output_history_size) {
+        output_history.pop_front();
+    }
+}
+
+void LipSyncContext::set_output_history_size(int p_entries) {
+    output_history_size = std::max(2, p_entries);
+    while ((int)output_history.size() > output_history_size) {
+        output_history.pop_front();
+    }
+}
+
+double LipSyncContext::get_stream_time() const {
+    return (double)stream_hops * 160 / target_sample_rate;
+}
+
+double LipSyncContext::get_buffered_time() const {
+    return (double)audio_buffer.size() / target_sample_rate;
+}
+
+PackedFloat32Array LipSyncContext::sample(double p_time, Interpolation p_interpolation) const {
+    if (output_history.empty()) {
+        return PackedFloat32Array();
+    }
+    if (p_time <= output_history.front().time) {
+        return output_history.front().visemes;
+    }
+    if (p_time >= output_history.back().time) {
+        return output_history.back().visemes;
+    }
+
+    // Segment [k, k + 1] that contains p_time
+    auto next = std::upper_bound(output_history.begin(), output_history.end(), p_time,
+            [](double p_t, const TimedVisemes &p_entry) { return p_t < p_entry.time; });
+    const size_t k = (size_t)(next - output_history.begin()) - 1;
+    const TimedVisemes &a = output_history[k];
+    const TimedVisemes &b = output_history[k + 1];
+    if (a.visemes.size() != b.visemes.size()) {
+        // The model changed between the two; no meaningful blend
+        return p_time - a.time < b.time - p_time ? a.visemes : b.visemes;
+    }
+    const double span = b.time - a.time;
+    const float u = (float)((p_time - a.time) / span);
+    const int64_t count = a.visemes.size();
+    PackedFloat32Array result;
+    result.resize(count);
+    float *out = result.ptrw();
+    const float *p1 = a.visemes.ptr();
+    const float *p2 = b.visemes.ptr();
+
+    if (p_interpolation == INTERPOLATION_LINEAR) {
+        for (int64_t i = 0; i < count; i++) {
+            out[i] = p1[i] + (p2[i] - p1[i]) * u;
+        }
+        return result;
+    }
+
+    // Hermite with Catmull-Rom tangents over the uneven spacing, the ends
+    // falling back to the segment's own slope
+    const TimedVisemes &prev = k > 0 ? output_history[k - 1] : a;
+    const TimedVisemes &after = k + 2 < output_history.size() ? output_history[k + 2] : b;
+    const bool has_prev = &prev != &a && prev.visemes.size() == count;
+    const bool has_after = &after != &b && after.visemes.size() == count;
+    const float scale1 = (float)(span / (has_prev ? b.time - prev.time : span));
+    const float scale2 = (float)(span / (has_after ? after.time - a.time : span));
+    const float *p0 = has_prev ? prev.visemes.ptr() : p1;
+    const float *p3 = has_after ? after.visemes.ptr() : p2;
+    const float u2 = u * u;
+    const float u3 = u2 * u;
+    const float h00 = 2.0f * u3 - 3.0f * u2 + 1.0f;
+    const float h10 = u3 - 2.0f * u2 + u;
+    const float h01 = -2.0f * u3 + 3.0f * u2;
+    const float h11 = u3 - u2;
+    for (int64_t i = 0; i < count; i++) {
+        const float m1 = (p2[i] - p0[i]) * scale1;
+        const float m2 = (p3[i] - p1[i]) * scale2;
+        out[i] = h00 * p1[i] + h10 * m1 + h01 * p2[i] + h11 * m2;
+    }
+    return result;
+}
+
+PackedFloat32Array LipSyncContext::bake(const PackedFloat32Array &p_samples, int p_threads) {
+    if (model_load && model_load->ready.load(std::memory_order_acquire)) {
+        _swap_pending_model();
+    }
+    if (model.is_null()) {
+        UtilityFunctions::printerr("LipSyncContext: Model not loaded.");
+        return PackedFloat32Array();
+    }
+
+    // Same features process() computes hop by hop, as GEMMs over the whole clip
+    PackedFloat32Array features = processor->process_clip(p_samples);
+
+    // The streaming model only emits the last frame, which suits the one-window-
+    // per-hop path. When the receptive field fits in the context window, a
+    // full-output model can run the clip in long overlapping chunks instead.
+    Ref<OnnxModel> runner = model;
+    if (model->get_receptive_field() > 0 && model->get_receptive_field() <= context_size && !model_path.is_empty()) {
+        if (offline_model.is_null()) {
+            Ref<OnnxModel> full;
+            full.instantiate();
+            full->set_last_frame_only(false);
+            full->set_fused_conv(model->is_fused_conv());
+            full->set_warmup_runs(0);
+            if (full->load_model(model_path)) {
+                offline_model = full;
+            }
+        }
+        if (offline_model.is_valid()) {
+            runner = offline_model;
+        }
+    }
+    return runner->run_offline(features, context_size, p_threads);
+}
+
+static_assert(LipSyncContext::LATENCY_STAGE_COUNT <= latency_histogram::MAX_STAGES, "latency stages");
+static const char *LATENCY_STAGE_NAMES[LipSyncContext::LATENCY_STAGE_COUNT] = { "resample", "features", "inference", "process" };
+
+// Periodic summary: interval and next due time in steady-clock ns (interval 0
+// = off), and the histograms as of the previous line
+static std::atomic<uint64_t> latency_log_interval_ns{ 0 };
+static std::atomic<uint64_t> latency_log_due_ns{ 0 };
+static std::mutex latency_log_mutex;
+static std::vector<latency_histogram::Snapshot> latency_log_baseline(LipSyncContext::LATENCY_STAGE_COUNT);
+
+static double _usec(uint64_t p_ns) {
+    return p_ns / 1000.0;
+}
+
+void LipSyncContext::_record_process_latency(uint64_t p_start_ns) {
+    if (!latency_histogram::is_enabled()) {
+        return;
+    }
+    const uint64_t now = latency_histogram::now_ns();
+    latency_histogram::record(LATENCY_PROCESS, now - p_start_ns);
+
+    const uint64_t interval = latency_log_interval_ns.load(std::memory_order_relaxed);
+    uint64_t due = latency_log_due_ns.load(std::memory_order_relaxed);
+    // Only the call that moves the due time forward prints
+    if (interval == 0 || now < due || !latency_log_due_ns.compare_exchange_strong(due, now + interval, std::memory_order_relaxed)) {
+        return;
+    }
+    String line = "LipSyncContext: latency (us) over the last " + String::num(_usec(interval) / 1e6, 1) + " s:";
+    std::lock_guard<std::mutex> lock(latency_log_mutex);
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        latency_histogram::Snapshot current = latency_histogram::snapshot(stage);
+        latency_histogram::Snapshot delta = current.since(latency_log_baseline[stage]);
+        latency_log_baseline[stage] = std::move(current);
+        if (delta.total == 0) {
+            continue;
+        }
+        line += String(" ") + LATENCY_STAGE_NAMES[stage] + " n=" + String::num_int64((int64_t)delta.total) +
+                " p50=" + String::num(_usec(delta.percentile(0.5)), 1) +
+                " p99=" + String::num(_usec(delta.percentile(0.99)), 1) +
+                " max=" + String::num(_usec(delta.largest()), 1) + ";";
+    }
+    UtilityFunctions::print(line);
+}
+
+void LipSyncContext::set_latency_tracking(bool p_enabled) {
+    latency_histogram::set_enabled(p_enabled);
+}
+
+bool LipSyncContext::is_latency_tracking() {
+    return latency_histogram::is_enabled();
+}
+
+Dictionary LipSyncContext::get_latency_stats() {
+    Dictionary stats;
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        const latency_histogram::Snapshot snapshot = latency_histogram::snapshot(stage);
+        Dictionary entry;
+        entry["count"] = (int64_t)snapshot.total;
+        entry["p50"] = _usec(snapshot.percentile(0.5));
+        entry["p90"] = _usec(snapshot.percentile(0.9));
+        entry["p99"] = _usec(snapshot.percentile(0.99));
+        entry["p99_9"] = _usec(snapshot.percentile(0.999));
+        entry["max"] = _usec(snapshot.largest());
+        stats[LATENCY_STAGE_NAMES[stage]] = entry;
+    }
+    return stats;
+}
+
+void LipSyncContext::reset_latency_stats() {
+    latency_histogram::reset();
+    std::lock_guard<std::mutex> lock(latency_log_mutex);
+    for (latency_histogram::Snapshot &baseline : latency_log_baseline) {
+        baseline = latency_histogram::Snapshot();
+    }
+}
+
+void LipSyncContext::set_latency_log_interval(double p_seconds) {
+    const uint64_t interval = p_seconds > 0.0 ? (uint64_t)(p_seconds * 1e9) : 0;
+    latency_log_due_ns.store(latency_histogram::now_ns() + interval, std::memory_order_relaxed);
+    latency_log_interval_ns.store(interval, std::memory_order_relaxed);
+}
+
+double LipSyncContext::get_latency_log_interval() {
+    return latency_log_interval_ns.load(std::memory_order_relaxed) / 1e9;
+}
+
 void LipSyncContext::_bind_methods() {
     ClassDB::bind_method(D_METHOD("load_model", "path"), &LipSyncContext::load_model);
+    ClassDB::bind_method(D_METHOD("load_model_async", "path"), &LipSyncContext::load_model_async);
+    ClassDB::bind_method(D_METHOD("is_loading"), &LipSyncContext::is_loading);
+    ClassDB::bind_method(D_METHOD("_emit_model_loaded", "id", "path", "success"), &LipSyncContext::_emit_model_loaded);
     ClassDB::bind_method(D_METHOD("set_context_size", "frames"), &LipSyncContext::set_context_size);
+    ClassDB::bind_method(D_METHOD("get_context_size"), &LipSyncContext::get_context_size);
+    ClassDB::bind_method(D_METHOD("set_half_history", "enabled"), &LipSyncContext::set_half_history);
+    ClassDB::bind_method(D_METHOD("is_half_history"), &LipSyncContext::is_half_history);
+    ClassDB::bind_method(D_METHOD("get_history_bytes"), &LipSyncContext::get_history_bytes);
     ClassDB::bind_method(D_METHOD("process", "audio_data", "sample_rate"), &LipSyncContext::process);
+    ClassDB::bind_method(D_METHOD("process_mono", "samples", "sample_rate"), &LipSyncContext::process_mono);
+    ClassDB::bind_method(D_METHOD("process_pcm16", "pcm", "channels", "sample_rate"), &LipSyncContext::process_pcm16);
+    ClassDB::bind_method(D_METHOD("bake", "samples", "threads"), &LipSyncContext::bake, DEFVAL(0));
+    ClassDB::bind_method(D_METHOD("set_output_history_size", "entries"), &LipSyncContext::set_output_history_size);
+    ClassDB::bind_method(D_METHOD("get_output_history_size"), &LipSyncContext::get_output_history_size);
+    ClassDB::bind_method(D_METHOD("get_stream_time"), &LipSyncContext::get_stream_time);
+    ClassDB::bind_method(D_METHOD("get_buffered_time"), &LipSyncContext::get_buffered_time);
+    ClassDB::bind_method(D_METHOD("sample", "time", "interpolation"), &LipSyncContext::sample, DEFVAL(INTERPOLATION_LINEAR));
+    ClassDB::bind_method(D_METHOD("get_peak"), &LipSyncContext::get_peak);
+    ClassDB::bind_method(D_METHOD("get_rms"), &LipSyncContext::get_rms);
+    ClassDB::bind_method(D_METHOD("get_band_energy"), &LipSyncContext::get_band_energy);
+    ClassDB::bind_method(D_METHOD("get_mel_energy"), &LipSyncContext::get_mel_energy);
+    ClassDB::bind_method(D_METHOD("start_recording", "path"), &LipSyncContext::start_recording);
+    ClassDB::bind_method(D_METHOD("stop_recording"), &LipSyncContext::stop_recording);
+    ClassDB::bind_method(D_METHOD("is_recording"), &LipSyncContext::is_recording);
+    ClassDB::bind_method(D_METHOD("get_recorded_calls"), &LipSyncContext::get_recorded_calls);
+    ClassDB::bind_method(D_METHOD("connect_daemon", "socket_path"), &LipSyncContext::connect_daemon, DEFVAL("/tmp/openlipsync.sock"));
+    ClassDB::bind_method(D_METHOD("disconnect_daemon"), &LipSyncContext::disconnect_daemon);
+    ClassDB::bind_method(D_METHOD("is_using_daemon"), &LipSyncContext::is_using_daemon);
+    ClassDB::bind_method(D_METHOD("get_daemon_batch_size"), &LipSyncContext::get_daemon_batch_size);
+    ClassDB::bind_static_method("LipSyncContext", D_METHOD("set_latency_tracking", "enabled"), &LipSyncContext::set_latency_tracking);
+    ClassDB::bind_static_method("LipSyncContext", D_METHOD("is_latency_tracking"), &LipSyncContext::is_latency_tracking);
+    ClassDB::bind_static_method("LipSyncContext", D_METHOD("get_latency_stats"), &LipSyncContext::get_latency_stats);
+    ClassDB::bind_static_method("LipSyncContext", D_METHOD("reset_latency_stats"), &LipSyncContext::reset_latency_stats);
+    ClassDB::bind_static_method("LipSyncContext", D_METHOD("set_latency_log_interval", "seconds"), &LipSyncContext::set_latency_log_interval);
+    ClassDB::bind_static_method("LipSyncContext", D_METHOD("get_latency_log_interval"), &LipSyncContext::get_latency_log_interval);
     ClassDB::bind_method(D_METHOD("reset"), &LipSyncContext::reset);
+    ClassDB::bind_method(D_METHOD("get_model"), &LipSyncContext::get_model);
+
+    BIND_ENUM_CONSTANT(INTERPOLATION_LINEAR);
+    BIND_ENUM_CONSTANT(INTERPOLATION_HERMITE);
+    BIND_ENUM_CONSTANT(LATENCY_RESAMPLE);
+    BIND_ENUM_CONSTANT(LATENCY_FEATURES);
+    BIND_ENUM_CONSTANT(LATENCY_INFERENCE);
+    BIND_ENUM_CONSTANT(LATENCY_PROCESS);
+
+    ADD_SIGNAL(MethodInfo("model_loaded", PropertyInfo(Variant::STRING, "path"), PropertyInfo(Variant::BOOL, "success")));
 }
@@ -2,18 +2,42 @@
 #define LIP_SYNC_CONTEXT_H
 
 #include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
 #include <godot_cpp/variant/packed_vector2_array.hpp>
 #include <godot_cpp/variant/packed_float32_array.hpp>
 #include "audio_processor.h"
+#include "capture_log.h"
+#include "daemon_client.h"
+#include "latency_histogram.h"
 #include "onnx_model.h"
 #include <vector>
 #include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 namespace godot {
 
 class LipSyncContext : public RefCounted {
     GDCLASS(LipSyncContext, RefCounted)
 
+public:
+    enum Interpolation {
+        INTERPOLATION_LINEAR,
+        INTERPOLATION_HERMITE, // Catmull-Rom through the neighbouring outputs; may overshoot slightly
+    };
+
+    // Pipeline stages with latency histograms (see latency_histogram.h)
+    enum LatencyStage {
+        LATENCY_RESAMPLE, // Source rate to 16 kHz, per process call that needs it
+        LATENCY_FEATURES, // One hop of mel features
+        LATENCY_INFERENCE, // One model run, local or on the daemon
+        LATENCY_PROCESS, // A whole process(), process_mono() or process_pcm16() call
+        LATENCY_STAGE_COUNT,
+    };
+
 private:
     Ref<AudioProcessor> processor;
     Ref<OnnxModel> model;
@@ -21,11 +45,17 @@ private:
     // Audio buffering
     std::vector<float> audio_buffer; // Accumulates mono samples at target rate (16kHz)
     
-    // Feature buffering (Sliding window for model input)
-    // Stored as flat floats. Size = context_size * n_mels
-    // We use a deque of "frames" (vectors of floats) for easier management
-    std::deque<std::vector<float>> feature_buffer;
-    
+    // Feature history (sliding window for model input): a ring buffer of the
+    // last context_size frames of n_mels features. Kept as float32 or, with
+    // half_history, as float16 bits at half the memory; either way it is
+    // unrolled into a per-thread scratch buffer only when the tensor is built.
+    std::vector<float> feature_history;
+    std::vector<uint16_t> feature_history_half;
+    int history_start = 0;  // Oldest frame
+    int history_frames = 0; // Frames stored, up to context_size
+    int n_mels = 80;
+    bool half_history = false;
+
     int context_size = 100; // Number of frames to keep for model context (e.g. 1s at 100fps)
     int target_sample_rate = 16000;
     
@@ -35,26 +65,171 @@ private:
 
     void _resample_and_push(const float* input, int count, int source_rate);
 
+    // Timestamped outputs for render-time sampling: the newest predictions,
+    // each stamped with the stream time at the end of its hop
+    struct TimedVisemes {
+        double time;
+        PackedFloat32Array visemes;
+    };
+    std::deque<TimedVisemes> output_history;
+    int output_history_size = 16;
+    int64_t stream_hops = 0; // Hops processed since the last reset
+    void _record_output(const PackedFloat32Array &p_visemes);
+
+    // Levels of the mono audio handed to the last process call
+    float peak_level = 0.0f;
+    float rms_level = 0.0f;
+    void _measure_levels(const float *p_mono, int p_count);
+    // Shared by the process entry points: swaps in a pending model, then
+    // false if there is none to run
+    bool _begin_process();
+    // Turns whole hops of the audio buffer into features and runs the model
+    PackedFloat32Array _process_hops();
+    void _push_features(const float *p_features);
+    // Reallocates the ring for the current size and precision, keeping the newest frames
+    void _resize_history(int p_frames, bool p_half);
+
+    // Offline baking: full-output copy of the model for the chunked path,
+    // loaded from model_path on first use
+    String model_path;
+    Ref<OnnxModel> offline_model;
+
+    // Async model loading: the new session is built on a detached worker and
+    // swapped in at the next hop boundary, keeping the feature history intact.
+    // The worker only shares this block with the context, so freeing the
+    // context mid-load neither waits for the worker nor leaves it a dangling this.
+    struct ModelLoad {
+        int64_t id = 0; // Matches the signal to the load that is still current
+        String path;
+        std::mutex mutex;
+        Ref<OnnxModel> model; // Set once loaded, until the swap takes it
+        std::atomic<bool> loading{true};
+        std::atomic<bool> ready{false};
+    };
+    std::shared_ptr<ModelLoad> model_load; // Newest async load, null if none
+    int64_t model_load_count = 0;
+
+    static void _load_model_worker(std::shared_ptr<ModelLoad> p_load, Ref<OnnxModel> p_model, Callable p_done);
+    void _swap_pending_model();
+    // Reports success only while load p_id is still the current one
+    void _emit_model_loaded(int64_t p_id, const String &p_path, bool p_success);
+
+    // Call capture for offline repro (see capture_log.h). The public process
+    // entry points time and log the internal ones while a capture is open.
+    std::unique_ptr<capture_log::Writer> capture;
+    void _capture_call(capture_log::Kind p_kind, int p_channels, int p_sample_rate, const void *p_payload, size_t p_bytes, uint64_t p_start_usec);
+    PackedFloat32Array _process_frames(const PackedVector2Array &p_audio_data, int p_source_sample_rate);
+    PackedFloat32Array _process_mono(const PackedFloat32Array &p_samples, int p_source_sample_rate);
+    PackedFloat32Array _process_pcm16(const PackedByteArray &p_pcm, int p_channels, int p_source_sample_rate);
+
+    // Out-of-process backend: windows go to the shared session of a lip-sync
+    // daemon instead of the local model (see daemon/lipsync_daemon.cpp)
+    std::unique_ptr<DaemonClient> daemon;
+    String daemon_socket_path;
+    PackedFloat32Array _infer_on_daemon(int p_frames);
+
+    // Records a public process call and prints the periodic summary when due
+    static void _record_process_latency(uint64_t p_start_ns);
+
 protected:
     static void _bind_methods();
 
 public:
     LipSyncContext();
-    ~LipSyncContext();
 
     // Setup
     bool load_model(const String &p_path);
+    // Builds the session on a worker thread; emits model_loaded when done,
+    // with success false if a later load_model replaced it in the meantime
+    bool load_model_async(const String &p_path);
+    bool is_loading() const { return model_load && model_load->loading.load(); }
     void set_context_size(int p_frames);
+    int get_context_size() const { return context_size; }
+    // Stores the feature history as float16. A float16 model consumes it as is;
+    // a float32 model gets it converted when the input tensor is built.
+    void set_half_history(bool p_enabled);
+    bool is_half_history() const { return half_history; }
+    // Bytes held by the feature history
+    int64_t get_history_bytes() const;
     
     // Main loop
     // Consumes audio, returns the latest viseme prediction (or empty if no new prediction)
     PackedFloat32Array process(const PackedVector2Array &p_audio_data, int p_source_sample_rate);
+    // Same, from mono float samples
+    PackedFloat32Array process_mono(const PackedFloat32Array &p_samples, int p_source_sample_rate);
+    // Same, from interleaved little-endian 16-bit PCM (AudioStreamWAV.data,
+    // voice packets). Conversion and downmix happen in one SIMD pass, written
+    // straight into the audio buffer when no resampling is needed.
+    PackedFloat32Array process_pcm16(const PackedByteArray &p_pcm, int p_channels, int p_source_sample_rate);
     
+    // Offline: visemes for every hop of a whole 16 kHz mono clip [hops * visemes],
+    // matching what process() returns when fed one hop per call after a reset
+    // within float rounding (~1e-5): the clip's features come from batched
+    // GEMMs, not the per-hop FFT, so don't compare the two with ==.
+    // Runs in parallel on p_threads cores (0 = all).
+    PackedFloat32Array bake(const PackedFloat32Array &p_samples, int p_threads = 0);
+
+    // Render-time sampling. Outputs arrive on the hop clock (100 Hz at most,
+    // once per process call); sample() interpolates the recorded ones at any
+    // stream time, clamping outside the recorded range. Stream time counts the
+    // audio processed since the last reset, so get_stream_time() minus a hop
+    // or two gives smooth motion at any frame rate without extra inference.
+    void set_output_history_size(int p_entries);
+    int get_output_history_size() const { return output_history_size; }
+    double get_stream_time() const;
+    // 16 kHz audio received but not yet a whole hop, so not in the stream time
+    double get_buffered_time() const;
+    PackedFloat32Array sample(double p_time, Interpolation p_interpolation = INTERPOLATION_LINEAR) const;
+
+    // Metering, so scripts never touch raw samples. Peak and RMS cover the mono
+    // downmix of the audio passed to the last process call (process() measures
+    // it during the downmix). Band energy is the last hop's mel band energies
+    // in dB before normalisation; mel energy is their mean.
+    float get_peak() const { return peak_level; }
+    float get_rms() const { return rms_level; }
+    PackedFloat32Array get_band_energy() const;
+    float get_mel_energy() const;
+
+    // Recording. Logs every process call's audio block, source rate and timing,
+    // plus resets, until stopped; LipSyncCapture reads the log back and
+    // replays it on another context.
+    bool start_recording(const String &p_path);
+    void stop_recording();
+    bool is_recording() const { return capture && capture->is_open(); }
+    int64_t get_recorded_calls() const { return capture ? (int64_t)capture->get_records() : 0; }
+
+    // Daemon backend. While connected, inference runs in the daemon's shared,
+    // batched session and no local model is needed; if one is loaded it takes
+    // over when the connection is lost.
+    bool connect_daemon(const String &p_socket_path = "/tmp/openlipsync.sock");
+    void disconnect_daemon();
+    bool is_using_daemon() const { return daemon && daemon->is_connected(); }
+    // Requests that shared the daemon's last run with this context's
+    int get_daemon_batch_size() const { return is_using_daemon() ? (int)daemon->last_batch_size() : 0; }
+
+    // Latency statistics, shared by all contexts. Off by default; when on,
+    // each stage above is timed on whatever thread runs it and kept in a
+    // lock-free per-thread histogram, merged only when read.
+    static void set_latency_tracking(bool p_enabled);
+    static bool is_latency_tracking();
+    // { stage name: { count, p50, p90, p99, p99_9, max } }, times in microseconds,
+    // covering everything since tracking started or the last reset
+    static Dictionary get_latency_stats();
+    static void reset_latency_stats();
+    // Prints one line of stage percentiles every p_seconds while tracking,
+    // covering the calls since the previous line; 0 turns it off
+    static void set_latency_log_interval(double p_seconds);
+    static double get_latency_log_interval();
+
     // Helpers
     Ref<AudioProcessor> get_processor() const { return processor; }
+    Ref<OnnxModel> get_model() const { return model; }
     void reset();
 };
 
 } // namespace godot
 
+VARIANT_ENUM_CAST(LipSyncContext::Interpolation);
+VARIANT_ENUM_CAST(LipSyncContext::LatencyStage);
+
 #endif
@@ -0,0 +1,265 @@
+#include "lip_sync_jitter_buffer.h"
+#include "pcm_convert.h"
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace godot;
+
+static const int TARGET_SAMPLE_RATE = 16000;
+static const int HOP_LENGTH = 160; // LipSyncContext's hop
+
+void LipSyncJitterBuffer::set_context(const Ref<LipSyncContext> &p_context) {
+    context = p_context;
+    reset();
+}
+
+void LipSyncJitterBuffer::set_min_delay(double p_seconds) {
+    min_delay = std::max(0.0, p_seconds);
+    max_delay = std::max(max_delay, min_delay);
+}
+
+void LipSyncJitterBuffer::set_max_delay(double p_seconds) {
+    max_delay = std::max(0.0, p_seconds);
+    min_delay = std::min(min_delay, max_delay);
+}
+
+void LipSyncJitterBuffer::push_pcm16(int64_t p_sequence, const PackedByteArray &p_pcm, int p_channels, int p_sample_rate) {
+    if (p_channels < 1 || p_sample_rate <= 0) {
+        UtilityFunctions::printerr("LipSyncJitterBuffer: Invalid channel count or sample rate.");
+        return;
+    }
+    const int64_t frames = p_pcm.size() / (2 * p_channels);
+    std::vector<float> mono((size_t)frames);
+    pcm_convert::int16_to_mono(p_pcm.ptr(), frames, p_channels, mono.data());
+    _push(p_sequence, pcm_convert::resample_linear(mono.data(), frames, p_sample_rate, TARGET_SAMPLE_RATE));
+}
+
+void LipSyncJitterBuffer::push_samples(int64_t p_sequence, const PackedFloat32Array &p_mono, int p_sample_rate) {
+    if (p_sample_rate <= 0) {
+        UtilityFunctions::printerr("LipSyncJitterBuffer: Invalid sample rate ", p_sample_rate);
+        return;
+    }
+    _push(p_sequence, pcm_convert::resample_linear(p_mono.ptr(), p_mono.size(), p_sample_rate, TARGET_SAMPLE_RATE));
+}
+
+void LipSyncJitterBuffer::_push(int64_t p_sequence, std::vector<float> &&p_samples) {
+    if (p_samples.empty()) {
+        return;
+    }
+    received++;
+    packet_duration = (double)p_samples.size() / TARGET_SAMPLE_RATE;
+
+    // Interarrival jitter: how much the transit time moves between packets
+    const double transit = clock - (double)p_sequence * packet_duration;
+    if (has_transit) {
+        jitter += (std::abs(transit - last_transit) - jitter) / 16.0;
+    }
+    last_transit = transit;
+    has_transit = true;
+
+    if ((next_sequence >= 0 && p_sequence < next_sequence) || packets.count(p_sequence)) {
+        // Its slot has been played (concealed), or a duplicate
+        late++;
+        return;
+    }
+    buffered += (int64_t)p_samples.size();
+    packets.emplace(p_sequence, std::move(p_samples));
+}
+
+void LipSyncJitterBuffer::_conceal(size_t p_count) {
+    current.assign(p_count, 0.0f);
+    current_pos = 0;
+    current_concealed = true;
+    concealed_run += (double)p_count / TARGET_SAMPLE_RATE;
+    if (concealment == CONCEALMENT_COMFORT_NOISE && noise_floor > 0.0f) {
+        // Uniform noise with the floor's RMS
+        const float amplitude = noise_floor * 1.7320508f;
+        for (float &sample : current) {
+            noise_state ^= noise_state << 13;
+            noise_state ^= noise_state >> 17;
+            noise_state ^= noise_state << 5;
+            sample = amplitude * ((float)(noise_state >> 8) * (2.0f / 16777216.0f) - 1.0f);
+        }
+    }
+}
+
+bool LipSyncJitterBuffer::_fill_hop() {
+    float *out = hop.ptrw();
+    size_t filled = 0;
+    bool concealed = false;
+    while (filled < (size_t)HOP_LENGTH) {
+        if (current_pos < current.size()) {
+            const size_t n = std::min((size_t)HOP_LENGTH - filled, current.size() - current_pos);
+            memcpy(out + filled, current.data() + current_pos, n * sizeof(float));
+            current_pos += n;
+            filled += n;
+            if (current_concealed) {
+                concealed = true;
+            } else {
+                buffered -= (int64_t)n;
+            }
+            continue;
+        }
+
+        auto next = packets.begin();
+        if (next != packets.end() && next->first == next_sequence) {
+            current = std::move(next->second);
+            packets.erase(next);
+            current_pos = 0;
+            current_concealed = false;
+            next_sequence++;
+            concealed_run = 0.0;
+
+            // Noise floor for comfort noise: falls at once, rises slowly
+            double energy = 0.0;
+            for (float sample : current) {
+                energy += (double)sample * sample;
+            }
+            const float rms = (float)std::sqrt(energy / current.size());
+            noise_floor = (noise_floor == 0.0f || rms < noise_floor) ? rms : noise_floor + (rms - noise_floor) * 0.02f;
+        } else if (next != packets.end()) {
+            // A later packet is here, so this one is lost: conceal its slot
+            _conceal((size_t)std::lround(packet_duration * TARGET_SAMPLE_RATE));
+            concealed_packets++;
+            next_sequence++;
+        } else if (concealed_run < max_concealment) {
+            // Nothing buffered: conceal hop by hop while waiting
+            _conceal((size_t)HOP_LENGTH - filled);
+        } else {
+            // The talker has stopped; rebuffer on the next packet
+            playing = false;
+            current.clear();
+            current_pos = 0;
+            budget = 0.0;
+            return false;
+        }
+    }
+    if (concealed) {
+        concealed_hops++;
+    }
+    return true;
+}
+
+PackedFloat32Array LipSyncJitterBuffer::update(double p_delta) {
+    p_delta = std::max(0.0, p_delta);
+    clock += p_delta;
+    if (context.is_null()) {
+        return visemes;
+    }
+    if (!playing) {
+        if (packets.empty() || get_buffered_time() < get_target_delay()) {
+            return visemes;
+        }
+        // Start (or restart) at the oldest packet, skipping slots lost while stopped
+        playing = true;
+        next_sequence = packets.begin()->first;
+        budget = 0.0;
+    }
+    if (hop.size() != HOP_LENGTH) {
+        hop.resize(HOP_LENGTH);
+    }
+
+    budget += p_delta * TARGET_SAMPLE_RATE;
+    int hops = (int)(budget / HOP_LENGTH);
+    if (hops > max_hops_per_update) {
+        hops = max_hops_per_update;
+        budget = 0.0;
+    } else {
+        budget -= (double)hops * HOP_LENGTH;
+    }
+
+    // A burst after a stall leaves more than the window buffered; drain it a
+    // hop per update so the latency comes back down without a visible jump
+    if (hops > 0 && get_buffered_time() > get_target_delay() + packet_duration + (double)HOP_LENGTH / TARGET_SAMPLE_RATE) {
+        if (_fill_hop()) {
+            skipped_hops++;
+        }
+    }
+
+    for (int i = 0; i < hops && playing; i++) {
+        if (!_fill_hop()) {
+            break;
+        }
+        // At 16 kHz every hop adds exactly one frame, so each call infers once
+        PackedFloat32Array result = context->process_mono(hop, TARGET_SAMPLE_RATE);
+        hops_played++;
+        if (!result.is_empty()) {
+            visemes = result;
+        }
+    }
+    return visemes;
+}
+
+double LipSyncJitterBuffer::get_target_delay() const {
+    return std::clamp(packet_duration + 3.0 * jitter, min_delay, max_delay);
+}
+
+double LipSyncJitterBuffer::get_buffered_time() const {
+    return (double)buffered / TARGET_SAMPLE_RATE;
+}
+
+Dictionary LipSyncJitterBuffer::get_stats() const {
+    Dictionary stats;
+    stats["received"] = received;
+    stats["late"] = late;
+    stats["concealed_packets"] = concealed_packets;
+    stats["concealed_hops"] = concealed_hops;
+    stats["skipped_hops"] = skipped_hops;
+    stats["hops_played"] = hops_played;
+    stats["jitter"] = jitter;
+    stats["target_delay"] = get_target_delay();
+    stats["buffered"] = get_buffered_time();
+    return stats;
+}
+
+void LipSyncJitterBuffer::reset() {
+    packets.clear();
+    current.clear();
+    current_pos = 0;
+    current_concealed = false;
+    next_sequence = -1;
+    buffered = 0;
+    playing = false;
+    clock = 0.0;
+    budget = 0.0;
+    jitter = 0.0;
+    has_transit = false;
+    concealed_run = 0.0;
+    noise_floor = 0.0f;
+    visemes = PackedFloat32Array();
+    received = late = concealed_packets = concealed_hops = skipped_hops = hops_played = 0;
+    if (context.is_valid()) {
+        context->reset();
+    }
+}
+
+void LipSyncJitterBuffer::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("set_context", "context"), &LipSyncJitterBuffer::set_context);
+    ClassDB::bind_method(D_METHOD("get_context"), &LipSyncJitterBuffer::get_context);
+    ClassDB::bind_method(D_METHOD("set_concealment", "concealment"), &LipSyncJitterBuffer::set_concealment);
+    ClassDB::bind_method(D_METHOD("get_concealment"), &LipSyncJitterBuffer::get_concealment);
+    ClassDB::bind_method(D_METHOD("set_min_delay", "seconds"), &LipSyncJitterBuffer::set_min_delay);
+    ClassDB::bind_method(D_METHOD("get_min_delay"), &LipSyncJitterBuffer::get_min_delay);
+    ClassDB::bind_method(D_METHOD("set_max_delay", "seconds"), &LipSyncJitterBuffer::set_max_delay);
+    ClassDB::bind_method(D_METHOD("get_max_delay"), &LipSyncJitterBuffer::get_max_delay);
+    ClassDB::bind_method(D_METHOD("set_max_concealment", "seconds"), &LipSyncJitterBuffer::set_max_concealment);
+    ClassDB::bind_method(D_METHOD("get_max_concealment"), &LipSyncJitterBuffer::get_max_concealment);
+    ClassDB::bind_method(D_METHOD("set_max_hops_per_update", "hops"), &LipSyncJitterBuffer::set_max_hops_per_update);
+    ClassDB::bind_method(D_METHOD("get_max_hops_per_update"), &LipSyncJitterBuffer::get_max_hops_per_update);
+
+    ClassDB::bind_method(D_METHOD("push_pcm16", "sequence", "pcm", "channels", "sample_rate"), &LipSyncJitterBuffer::push_pcm16);
+    ClassDB::bind_method(D_METHOD("push_samples", "sequence", "mono", "sample_rate"), &LipSyncJitterBuffer::push_samples);
+    ClassDB::bind_method(D_METHOD("update", "delta"), &LipSyncJitterBuffer::update);
+    ClassDB::bind_method(D_METHOD("get_visemes"), &LipSyncJitterBuffer::get_visemes);
+    ClassDB::bind_method(D_METHOD("get_target_delay"), &LipSyncJitterBuffer::get_target_delay);
+    ClassDB::bind_method(D_METHOD("get_buffered_time"), &LipSyncJitterBuffer::get_buffered_time);
+    ClassDB::bind_method(D_METHOD("is_playing"), &LipSyncJitterBuffer::is_playing);
+    ClassDB::bind_method(D_METHOD("get_stats"), &LipSyncJitterBuffer::get_stats);
+    ClassDB::bind_method(D_METHOD("reset"), &LipSyncJitterBuffer::reset);
+
+    BIND_ENUM_CONSTANT(CONCEALMENT_SILENCE);
+    BIND_ENUM_CONSTANT(CONCEALMENT_COMFORT_NOISE);
+}
@@ -0,0 +1,125 @@
+#ifndef LIP_SYNC_JITTER_BUFFER_H
+#define LIP_SYNC_JITTER_BUFFER_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include "lip_sync_context.h"
+#include <map>
+#include <vector>
+
+namespace godot {
+
+// Network voice ingest for a LipSyncContext. Voice packets arrive in bursts,
+// out of order or not at all; fed straight into process() they cause bursts
+// of inference followed by stalls, and every gap shifts the TCN history.
+//
+// Packets go in with their sequence numbers (increasing, not wrapped) and wait
+// in a window sized from the measured arrival jitter. update() then plays them
+// out on the local clock, one hop per inference, so the work is spread evenly
+// over frames. A packet that hasn't arrived by its turn is concealed with
+// silence or comfort noise at the speaker's noise floor, and its late arrival
+// is dropped. If the backlog grows past the window, one hop per update is
+// skipped until it is back. After max_concealment seconds with nothing to
+// play, playout stops until the window fills again.
+//
+// Give it a context of its own: it resets the context on reset().
+class LipSyncJitterBuffer : public RefCounted {
+    GDCLASS(LipSyncJitterBuffer, RefCounted)
+
+public:
+    enum Concealment {
+        CONCEALMENT_SILENCE,
+        CONCEALMENT_COMFORT_NOISE,
+    };
+
+private:
+    Ref<LipSyncContext> context;
+    Concealment concealment = CONCEALMENT_COMFORT_NOISE;
+
+    std::map<int64_t, std::vector<float>> packets; // Waiting packets, 16 kHz mono
+    std::vector<float> current;                    // Packet (or concealment) being played out
+    size_t current_pos = 0;
+    bool current_concealed = false;
+    int64_t next_sequence = -1; // Next packet due, -1 before the first playout
+    int64_t buffered = 0;       // Samples waiting, including the rest of current
+    bool playing = false;
+
+    // Playout clock
+    double clock = 0.0;  // Seconds of update() time
+    double budget = 0.0; // Samples owed to playout
+    int max_hops_per_update = 8;
+
+    // Adaptive window (RFC 3550 interarrival jitter)
+    double min_delay = 0.04;
+    double max_delay = 0.3;
+    double jitter = 0.0;
+    double last_transit = 0.0;
+    bool has_transit = false;
+    double packet_duration = 0.02; // Last packet's, in seconds
+
+    // Concealment
+    double max_concealment = 0.5;
+    double concealed_run = 0.0; // Seconds concealed since real audio
+    float noise_floor = 0.0f;
+    uint32_t noise_state = 0x9E3779B9u;
+
+    PackedFloat32Array visemes; // Last output
+    PackedFloat32Array hop;
+
+    // Counters for get_stats()
+    int64_t received = 0;
+    int64_t late = 0;
+    int64_t concealed_packets = 0;
+    int64_t concealed_hops = 0;
+    int64_t skipped_hops = 0;
+    int64_t hops_played = 0;
+
+    void _push(int64_t p_sequence, std::vector<float> &&p_samples);
+    void _conceal(size_t p_count);
+    bool _fill_hop();
+
+protected:
+    static void _bind_methods();
+
+public:
+    void set_context(const Ref<LipSyncContext> &p_context);
+    Ref<LipSyncContext> get_context() const { return context; }
+    void set_concealment(Concealment p_concealment) { concealment = p_concealment; }
+    Concealment get_concealment() const { return concealment; }
+    // Bounds of the adaptive window, in seconds
+    void set_min_delay(double p_seconds);
+    double get_min_delay() const { return min_delay; }
+    void set_max_delay(double p_seconds);
+    double get_max_delay() const { return max_delay; }
+    void set_max_concealment(double p_seconds) { max_concealment = p_seconds < 0.0 ? 0.0 : p_seconds; }
+    double get_max_concealment() const { return max_concealment; }
+    // Caps the hops one update() runs, so a hitch is skipped rather than caught up
+    void set_max_hops_per_update(int p_hops) { max_hops_per_update = p_hops < 1 ? 1 : p_hops; }
+    int get_max_hops_per_update() const { return max_hops_per_update; }
+
+    void push_pcm16(int64_t p_sequence, const PackedByteArray &p_pcm, int p_channels, int p_sample_rate);
+    void push_samples(int64_t p_sequence, const PackedFloat32Array &p_mono, int p_sample_rate);
+
+    // Advances the playout clock by p_delta seconds and runs the hops that are
+    // due. Returns the newest visemes (the previous ones if no hop completed).
+    PackedFloat32Array update(double p_delta);
+    PackedFloat32Array get_visemes() const { return visemes; }
+
+    // Window the buffer is aiming for, from the measured jitter
+    double get_target_delay() const;
+    double get_buffered_time() const;
+    bool is_playing() const { return playing; }
+    // received, late, concealed_packets, concealed_hops, skipped_hops,
+    // hops_played, jitter, target_delay, buffered
+    Dictionary get_stats() const;
+
+    void reset();
+};
+
+} // namespace godot
+
+VARIANT_ENUM_CAST(LipSyncJitterBuffer::Concealment);
+
+#endif
@@ -0,0 +1,171 @@
+#include "lip_sync_lookahead.h"
+#include "pcm_convert.h"
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace godot;
+
+static const int TARGET_SAMPLE_RATE = 16000;
+static const int HOP_LENGTH = 160;    // LipSyncContext's hop
+static const int WINDOW_HOPS = 3;     // Hops that cover the 400-sample analysis window
+
+double LipSyncLookahead::_cursor_time() const {
+    return (double)cursor / TARGET_SAMPLE_RATE;
+}
+
+void LipSyncLookahead::set_context(const Ref<LipSyncContext> &p_context) {
+    context = p_context;
+    seek(0.0);
+}
+
+void LipSyncLookahead::_set_clip(const float *p_mono, int64_t p_count, int p_sample_rate) {
+    samples = pcm_convert::resample_linear(p_mono, p_count, p_sample_rate, TARGET_SAMPLE_RATE);
+    seek(0.0);
+}
+
+void LipSyncLookahead::set_samples(const PackedFloat32Array &p_mono, int p_sample_rate) {
+    if (p_sample_rate <= 0) {
+        UtilityFunctions::printerr("LipSyncLookahead: Invalid sample rate ", p_sample_rate);
+        return;
+    }
+    _set_clip(p_mono.ptr(), p_mono.size(), p_sample_rate);
+}
+
+void LipSyncLookahead::set_pcm16(const PackedByteArray &p_pcm, int p_channels, int p_sample_rate) {
+    if (p_channels < 1 || p_sample_rate <= 0) {
+        UtilityFunctions::printerr("LipSyncLookahead: Invalid channel count or sample rate.");
+        return;
+    }
+    const int64_t frames = p_pcm.size() / (2 * p_channels);
+    std::vector<float> mono((size_t)frames);
+    pcm_convert::int16_to_mono(p_pcm.ptr(), frames, p_channels, mono.data());
+    _set_clip(mono.data(), frames, p_sample_rate);
+}
+
+bool LipSyncLookahead::set_stream(const Ref<AudioStreamWAV> &p_stream) {
+    if (p_stream.is_null()) {
+        return false;
+    }
+    const int channels = p_stream->is_stereo() ? 2 : 1;
+    const PackedByteArray data = p_stream->get_data();
+    switch (p_stream->get_format()) {
+        case AudioStreamWAV::FORMAT_16_BITS:
+            set_pcm16(data, channels, p_stream->get_mix_rate());
+            return true;
+        case AudioStreamWAV::FORMAT_8_BITS: {
+            // Signed 8-bit
+            const int64_t frames = data.size() / channels;
+            const uint8_t *bytes = data.ptr();
+            std::vector<float> mono((size_t)frames);
+            for (int64_t i = 0; i < frames; i++) {
+                int sum = 0;
+                for (int c = 0; c < channels; c++) {
+                    sum += (int8_t)bytes[i * channels + c];
+                }
+                mono[i] = sum / (128.0f * channels);
+            }
+            _set_clip(mono.data(), frames, p_stream->get_mix_rate());
+            return true;
+        }
+        default:
+            UtilityFunctions::printerr("LipSyncLookahead: Only 8- and 16-bit PCM streams can be read ahead; reimport the WAV without compression.");
+            return false;
+    }
+}
+
+void LipSyncLookahead::seek(double p_position) {
+    queue.clear();
+    current = PackedFloat32Array();
+    last_position = std::max(0.0, p_position);
+    const int64_t hops = (int64_t)samples.size() / HOP_LENGTH;
+    const int64_t target = std::min<int64_t>(hops, (int64_t)(last_position * TARGET_SAMPLE_RATE) / HOP_LENGTH);
+    cursor = target * HOP_LENGTH;
+    if (context.is_null()) {
+        return;
+    }
+    context->reset();
+    if (target == 0) {
+        return;
+    }
+
+    // Rebuild the history the context would have after playing up to the
+    // target: the last context_size hops plus the window's overlap, fed in one
+    // call so only the final hop runs inference.
+    const int64_t first = std::max<int64_t>(0, target - context->get_context_size() - WINDOW_HOPS);
+    PackedFloat32Array warm;
+    warm.resize((target - first) * HOP_LENGTH);
+    memcpy(warm.ptrw(), samples.data() + first * HOP_LENGTH, (size_t)warm.size() * sizeof(float));
+    PackedFloat32Array visemes = context->process_mono(warm, TARGET_SAMPLE_RATE);
+    if (!visemes.is_empty()) {
+        queue.push_back({ _cursor_time(), visemes });
+    }
+}
+
+int LipSyncLookahead::update(double p_position, int p_max_hops) {
+    if (context.is_null()) {
+        return 0;
+    }
+    // Rewinds, and jumps further ahead than one context can bridge, start over
+    const double context_seconds = (double)context->get_context_size() * HOP_LENGTH / TARGET_SAMPLE_RATE;
+    const bool has_more = cursor + HOP_LENGTH <= (int64_t)samples.size();
+    if (p_position < last_position - 0.001 || (has_more && p_position > _cursor_time() + context_seconds)) {
+        seek(p_position);
+    }
+    last_position = std::max(last_position, p_position);
+
+    int computed = 0;
+    PackedFloat32Array hop;
+    hop.resize(HOP_LENGTH);
+    while (_cursor_time() < p_position + lookahead && cursor + HOP_LENGTH <= (int64_t)samples.size()) {
+        if (p_max_hops > 0 && computed >= p_max_hops) {
+            break;
+        }
+        memcpy(hop.ptrw(), samples.data() + cursor, HOP_LENGTH * sizeof(float));
+        // At 16 kHz every hop adds exactly one frame, so each call infers once
+        PackedFloat32Array visemes = context->process_mono(hop, TARGET_SAMPLE_RATE);
+        cursor += HOP_LENGTH;
+        computed++;
+        if (!visemes.is_empty()) {
+            queue.push_back({ _cursor_time(), visemes });
+        }
+    }
+    return computed;
+}
+
+PackedFloat32Array LipSyncLookahead::get_visemes(double p_position) {
+    // Drop what playback has passed, keeping the newest entry at or before it
+    while (queue.size() > 1 && queue[1].time <= p_position) {
+        queue.pop_front();
+    }
+    if (!queue.empty() && queue.front().time <= p_position) {
+        current = queue.front().visemes;
+    }
+    return current;
+}
+
+double LipSyncLookahead::get_length() const {
+    return (double)samples.size() / TARGET_SAMPLE_RATE;
+}
+
+bool LipSyncLookahead::is_finished() const {
+    return cursor + HOP_LENGTH > (int64_t)samples.size() && queue.size() <= 1;
+}
+
+void LipSyncLookahead::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("set_context", "context"), &LipSyncLookahead::set_context);
+    ClassDB::bind_method(D_METHOD("get_context"), &LipSyncLookahead::get_context);
+    ClassDB::bind_method(D_METHOD("set_lookahead", "seconds"), &LipSyncLookahead::set_lookahead);
+    ClassDB::bind_method(D_METHOD("get_lookahead"), &LipSyncLookahead::get_lookahead);
+    ClassDB::bind_method(D_METHOD("set_stream", "stream"), &LipSyncLookahead::set_stream);
+    ClassDB::bind_method(D_METHOD("set_samples", "mono", "sample_rate"), &LipSyncLookahead::set_samples);
+    ClassDB::bind_method(D_METHOD("set_pcm16", "pcm", "channels", "sample_rate"), &LipSyncLookahead::set_pcm16);
+    ClassDB::bind_method(D_METHOD("update", "position", "max_hops"), &LipSyncLookahead::update, DEFVAL(0));
+    ClassDB::bind_method(D_METHOD("seek", "position"), &LipSyncLookahead::seek);
+    ClassDB::bind_method(D_METHOD("get_visemes", "position"), &LipSyncLookahead::get_visemes);
+    ClassDB::bind_method(D_METHOD("get_length"), &LipSyncLookahead::get_length);
+    ClassDB::bind_method(D_METHOD("get_computed_time"), &LipSyncLookahead::get_computed_time);
+    ClassDB::bind_method(D_METHOD("is_finished"), &LipSyncLookahead::is_finished);
+}
@@ -0,0 +1,78 @@
+#ifndef LIP_SYNC_LOOKAHEAD_H
+#define LIP_SYNC_LOOKAHEAD_H
+
+#include <godot_cpp/classes/audio_stream_wav.hpp>
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include "lip_sync_context.h"
+#include <deque>
+#include <vector>
+
+namespace godot {
+
+// Lookahead for audio that is known ahead of playback (voice lines played
+// through an AudioStreamPlayer). Reads ahead of the playback head through a
+// LipSyncContext, one hop per inference exactly as streaming would, and keeps
+// the results in a small queue stamped with the audio time they belong to.
+// get_visemes(position) then serves the one for the playback position, so the
+// model and buffering latency of live streaming disappear.
+//
+// Call update() every frame with the playback position; max_hops caps the work
+// per call, and a bigger lookahead lets idle frames compute further ahead.
+// Give it a context of its own: it resets the context on every seek.
+class LipSyncLookahead : public RefCounted {
+    GDCLASS(LipSyncLookahead, RefCounted)
+
+private:
+    struct Entry {
+        double time; // End of the hop the visemes were computed for (seconds)
+        PackedFloat32Array visemes;
+    };
+
+    Ref<LipSyncContext> context;
+    std::vector<float> samples; // Whole clip, 16 kHz mono
+    int64_t cursor = 0;         // Next sample to feed, always hop aligned
+    double lookahead = 0.2;     // Seconds computed ahead of the playback position
+    double last_position = 0.0;
+    std::deque<Entry> queue;
+    PackedFloat32Array current; // Last visemes served
+
+    double _cursor_time() const;
+    void _set_clip(const float *p_mono, int64_t p_count, int p_sample_rate);
+
+protected:
+    static void _bind_methods();
+
+public:
+    void set_context(const Ref<LipSyncContext> &p_context);
+    Ref<LipSyncContext> get_context() const { return context; }
+    void set_lookahead(double p_seconds) { lookahead = p_seconds < 0.0 ? 0.0 : p_seconds; }
+    double get_lookahead() const { return lookahead; }
+
+    // The clip to read ahead from. Each resets the queue to the start.
+    // AudioStreamWAV needs 8- or 16-bit PCM data (not IMA-ADPCM or QOA).
+    bool set_stream(const Ref<AudioStreamWAV> &p_stream);
+    void set_samples(const PackedFloat32Array &p_mono, int p_sample_rate);
+    void set_pcm16(const PackedByteArray &p_pcm, int p_channels, int p_sample_rate);
+
+    // Computes visemes up to p_position + lookahead, at most p_max_hops of them
+    // (0 = no cap). Seeks on its own when the position jumps back or far ahead.
+    // Returns the number of hops computed.
+    int update(double p_position, int p_max_hops = 0);
+    // Rebuilds the context history for p_position and drops the queue
+    void seek(double p_position);
+
+    // Visemes for the hop that ends at or before p_position; the last ones
+    // served if the queue has nothing newer (empty before the first hop)
+    PackedFloat32Array get_visemes(double p_position);
+
+    double get_length() const;
+    // Audio time computed so far, in seconds
+    double get_computed_time() const { return _cursor_time(); }
+    bool is_finished() const;
+};
+
+} // namespace godot
+
+#endif
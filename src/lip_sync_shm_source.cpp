@@ -0,0 +1,207 @@
+#include "lip_sync_shm_source.h"
+#include "pcm_convert.h"
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <algorithm>
+#include <cstring>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__ANDROID__)
+#define LIP_SYNC_SHM_SUPPORTED 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace godot;
+
+LipSyncShmSource::~LipSyncShmSource() {
+    close();
+}
+
+bool LipSyncShmSource::open(const String &p_name) {
+    close();
+#ifdef LIP_SYNC_SHM_SUPPORTED
+    const CharString name = p_name.utf8();
+    const int fd = shm_open(name.get_data(), O_RDWR, 0);
+    if (fd < 0) {
+        UtilityFunctions::printerr("LipSyncShmSource: No shared memory ring named ", p_name);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(olsync_shm_header)) {
+        ::close(fd);
+        UtilityFunctions::printerr("LipSyncShmSource: ", p_name, " is too small to be a ring.");
+        return false;
+    }
+    void *memory = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        UtilityFunctions::printerr("LipSyncShmSource: Could not map ", p_name);
+        return false;
+    }
+
+    olsync_shm_header *ring = (olsync_shm_header *)memory;
+    const bool magic_ok = __atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) == OLSYNC_SHM_MAGIC;
+    // One snapshot of the layout, so what gets validated is what gets used
+    const uint32_t ring_version = ring->version;
+    const uint32_t ring_channels = ring->channels;
+    const uint32_t ring_format = ring->format;
+    const uint32_t ring_sample_rate = ring->sample_rate;
+    const uint32_t ring_capacity = ring->capacity;
+    const bool valid = magic_ok && ring_version == OLSYNC_SHM_VERSION &&
+            ring_channels > 0 && ring_sample_rate > 0 &&
+            ring_capacity > 0 && (ring_capacity & (ring_capacity - 1)) == 0 &&
+            (ring_format == OLSYNC_SHM_FORMAT_F32 || ring_format == OLSYNC_SHM_FORMAT_S16) &&
+            olsync_shm_size(ring_capacity, ring_channels, ring_format) <= (size_t)info.st_size;
+    if (!valid) {
+        munmap(memory, (size_t)info.st_size);
+        UtilityFunctions::printerr("LipSyncShmSource: ", p_name, " is not a version ", OLSYNC_SHM_VERSION, " OpenLipSync ring.");
+        return false;
+    }
+
+    header = ring;
+    data = (const uint8_t *)memory + OLSYNC_SHM_DATA_OFFSET;
+    mapped_size = (size_t)info.st_size;
+    channels = ring_channels;
+    format = ring_format;
+    sample_rate = ring_sample_rate;
+    capacity = ring_capacity;
+    frames_read = 0;
+    handoff_usec = 0.0;
+    // Start at the live edge rather than replaying whatever is still in the ring
+    read_pos = __atomic_load_n(&header->write_pos, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&header->read_pos, read_pos, __ATOMIC_RELEASE);
+    return true;
+#else
+    UtilityFunctions::printerr("LipSyncShmSource: Shared memory rings are not supported on this platform.");
+    return false;
+#endif
+}
+
+void LipSyncShmSource::close() {
+#ifdef LIP_SYNC_SHM_SUPPORTED
+    if (header) {
+        munmap(header, mapped_size);
+    }
+#endif
+    header = nullptr;
+    data = nullptr;
+    mapped_size = 0;
+    channels = 0;
+    format = 0;
+    sample_rate = 0;
+    capacity = 0;
+    read_pos = 0;
+}
+
+void LipSyncShmSource::_downmix(uint64_t p_start, int64_t p_count, float *r_mono) const {
+    if (format == OLSYNC_SHM_FORMAT_S16) {
+        pcm_convert::int16_to_mono(data + p_start * channels * 2, p_count, (int)channels, r_mono);
+        return;
+    }
+    const float *samples = (const float *)data + p_start * channels;
+    if (channels == 1) {
+        memcpy(r_mono, samples, (size_t)p_count * sizeof(float));
+        return;
+    }
+    const float scale = 1.0f / channels;
+    for (int64_t i = 0; i < p_count; i++) {
+        float sum = 0.0f;
+        for (uint32_t c = 0; c < channels; c++) {
+            sum += samples[i * channels + c];
+        }
+        r_mono[i] = sum * scale;
+    }
+}
+
+PackedFloat32Array LipSyncShmSource::poll() {
+#ifdef LIP_SYNC_SHM_SUPPORTED
+    if (!header || context.is_null()) {
+        return PackedFloat32Array();
+    }
+    const uint64_t write_pos = __atomic_load_n(&header->write_pos, __ATOMIC_ACQUIRE);
+    uint64_t available = write_pos - read_pos;
+    if (available == 0) {
+        return PackedFloat32Array();
+    }
+    if (available > capacity) {
+        // Can't happen with a well-behaved producer; resynchronise at its edge
+        read_pos = write_pos;
+        __atomic_store_n(&header->read_pos, read_pos, __ATOMIC_RELEASE);
+        return PackedFloat32Array();
+    }
+    if (max_frames_per_poll > 0 && available > (uint64_t)max_frames_per_poll) {
+        available = (uint64_t)max_frames_per_poll;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+    const uint64_t write_time = __atomic_load_n(&header->write_time, __ATOMIC_RELAXED);
+    handoff_usec = now_ns > write_time ? (double)(now_ns - write_time) / 1000.0 : 0.0;
+
+    // Downmix in place from the ring: up to the end, then from its start
+    mono.resize((int64_t)available);
+    float *out = mono.ptrw();
+    const uint64_t start = read_pos & (capacity - 1);
+    const uint64_t first = std::min(available, capacity - start);
+    _downmix(start, (int64_t)first, out);
+    if (available > first) {
+        _downmix(0, (int64_t)(available - first), out + first);
+    }
+    read_pos += available;
+    __atomic_store_n(&header->read_pos, read_pos, __ATOMIC_RELEASE);
+    frames_read += available;
+
+    return context->process_mono(mono, (int)sample_rate);
+#else
+    return PackedFloat32Array();
+#endif
+}
+
+int LipSyncShmSource::get_sample_rate() const {
+    return (int)sample_rate;
+}
+
+int LipSyncShmSource::get_channels() const {
+    return (int)channels;
+}
+
+int64_t LipSyncShmSource::get_available() const {
+#ifdef LIP_SYNC_SHM_SUPPORTED
+    if (!header) {
+        return 0;
+    }
+    const uint64_t available = __atomic_load_n(&header->write_pos, __ATOMIC_ACQUIRE) - read_pos;
+    return available > capacity ? 0 : (int64_t)available;
+#else
+    return 0;
+#endif
+}
+
+int64_t LipSyncShmSource::get_dropped() const {
+#ifdef LIP_SYNC_SHM_SUPPORTED
+    return header ? (int64_t)__atomic_load_n(&header->dropped, __ATOMIC_RELAXED) : 0;
+#else
+    return 0;
+#endif
+}
+
+void LipSyncShmSource::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("set_context", "context"), &LipSyncShmSource::set_context);
+    ClassDB::bind_method(D_METHOD("get_context"), &LipSyncShmSource::get_context);
+    ClassDB::bind_method(D_METHOD("set_max_frames_per_poll", "frames"), &LipSyncShmSource::set_max_frames_per_poll);
+    ClassDB::bind_method(D_METHOD("get_max_frames_per_poll"), &LipSyncShmSource::get_max_frames_per_poll);
+    ClassDB::bind_method(D_METHOD("open", "name"), &LipSyncShmSource::open);
+    ClassDB::bind_method(D_METHOD("close"), &LipSyncShmSource::close);
+    ClassDB::bind_method(D_METHOD("is_open"), &LipSyncShmSource::is_open);
+    ClassDB::bind_method(D_METHOD("poll"), &LipSyncShmSource::poll);
+    ClassDB::bind_method(D_METHOD("get_sample_rate"), &LipSyncShmSource::get_sample_rate);
+    ClassDB::bind_method(D_METHOD("get_channels"), &LipSyncShmSource::get_channels);
+    ClassDB::bind_method(D_METHOD("get_available"), &LipSyncShmSource::get_available);
+    ClassDB::bind_method(D_METHOD("get_frames_read"), &LipSyncShmSource::get_frames_read);
+    ClassDB::bind_method(D_METHOD("get_dropped"), &LipSyncShmSource::get_dropped);
+    ClassDB::bind_method(D_METHOD("get_handoff_usec"), &LipSyncShmSource::get_handoff_usec);
+}
@@ -0,0 +1,80 @@
+#ifndef LIP_SYNC_SHM_SOURCE_H
+#define LIP_SYNC_SHM_SOURCE_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include "lip_sync_context.h"
+#include "openlipsync_shm.h"
+
+namespace godot {
+
+// Audio from another process through the shared-memory ring described in
+// openlipsync_shm.h, for voice chat clients that already have decoded PCM.
+// Skips the round trip through Godot's audio buses: poll() downmixes the
+// samples straight out of the mapped ring into the context's input and
+// releases them, one copy in all.
+//
+// The external process creates the ring (shm_producer/olsync_producer.c);
+// open() maps it by name. A producer that restarts creates a new ring, so
+// reopen it then. POSIX only (not Windows or Android).
+class LipSyncShmSource : public RefCounted {
+    GDCLASS(LipSyncShmSource, RefCounted)
+
+private:
+    Ref<LipSyncContext> context;
+    olsync_shm_header *header = nullptr;
+    const uint8_t *data = nullptr;
+    size_t mapped_size = 0;
+    // The producer can write the header at any time, so the layout is read
+    // from it once, validated in open(), and only these copies are used after.
+    // The read cursor is ours; the header's copy is only published.
+    uint32_t channels = 0;
+    uint32_t format = 0;
+    uint32_t sample_rate = 0;
+    uint64_t capacity = 0;
+    uint64_t read_pos = 0;
+    int max_frames_per_poll = 0;
+
+    uint64_t frames_read = 0;
+    double handoff_usec = 0.0;
+    PackedFloat32Array mono;
+
+    void _downmix(uint64_t p_start, int64_t p_count, float *r_mono) const;
+
+protected:
+    static void _bind_methods();
+
+public:
+    ~LipSyncShmSource();
+
+    void set_context(const Ref<LipSyncContext> &p_context) { context = p_context; }
+    Ref<LipSyncContext> get_context() const { return context; }
+    // Caps the frames one poll() consumes (0 = everything available); the
+    // rest stay in the ring for the next call
+    void set_max_frames_per_poll(int p_frames) { max_frames_per_poll = p_frames < 0 ? 0 : p_frames; }
+    int get_max_frames_per_poll() const { return max_frames_per_poll; }
+
+    // Maps the ring p_name ("/name"). Fails if it doesn't exist yet or its
+    // header doesn't match this version.
+    bool open(const String &p_name);
+    void close();
+    bool is_open() const { return header != nullptr; }
+
+    // Feeds everything the producer has written since the last poll to the
+    // context. Returns its visemes (empty if no new frame was completed).
+    PackedFloat32Array poll();
+
+    int get_sample_rate() const;
+    int get_channels() const;
+    int64_t get_available() const;
+    int64_t get_frames_read() const { return (int64_t)frames_read; }
+    // Frames the producer dropped because the ring was full
+    int64_t get_dropped() const;
+    // Microseconds from the producer's last write to the poll() that read it
+    double get_handoff_usec() const { return handoff_usec; }
+};
+
+} // namespace godot
+
+#endif
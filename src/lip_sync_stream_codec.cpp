@@ -0,0 +1,75 @@
+#include "lip_sync_stream_codec.h"
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <cstring>
+
+using namespace godot;
+
+void LipSyncStreamCodec::_configure() {
+    encoder.configure(config);
+    decoder.configure(config);
+    config = encoder.get_config();
+}
+
+void LipSyncStreamCodec::set_viseme_count(int p_count) {
+    config.viseme_count = p_count;
+    _configure();
+}
+
+void LipSyncStreamCodec::set_bits(int p_bits) {
+    config.bits = p_bits;
+    _configure();
+}
+
+void LipSyncStreamCodec::set_deadband(int p_steps) {
+    config.deadband = p_steps;
+    _configure();
+}
+
+void LipSyncStreamCodec::set_stride(int p_frames) {
+    config.stride = p_frames;
+    _configure();
+}
+
+PackedByteArray LipSyncStreamCodec::encode(const PackedFloat32Array &p_visemes) {
+    const int count = config.viseme_count;
+    if (p_visemes.size() % count != 0) {
+        UtilityFunctions::printerr("LipSyncStreamCodec: ", p_visemes.size(), " values is not a whole number of ", count, "-viseme frames.");
+        return PackedByteArray();
+    }
+    const std::vector<uint8_t> packet = encoder.encode(p_visemes.ptr(), p_visemes.size() / count);
+    PackedByteArray result;
+    result.resize((int64_t)packet.size());
+    memcpy(result.ptrw(), packet.data(), packet.size());
+    return result;
+}
+
+PackedFloat32Array LipSyncStreamCodec::decode(const PackedByteArray &p_packet) {
+    decoded.clear();
+    PackedFloat32Array result;
+    if (!decoder.decode(p_packet.ptr(), (size_t)p_packet.size(), decoded)) {
+        return result;
+    }
+    result.resize((int64_t)decoded.size());
+    memcpy(result.ptrw(), decoded.data(), decoded.size() * sizeof(float));
+    return result;
+}
+
+void LipSyncStreamCodec::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("set_viseme_count", "count"), &LipSyncStreamCodec::set_viseme_count);
+    ClassDB::bind_method(D_METHOD("get_viseme_count"), &LipSyncStreamCodec::get_viseme_count);
+    ClassDB::bind_method(D_METHOD("set_bits", "bits"), &LipSyncStreamCodec::set_bits);
+    ClassDB::bind_method(D_METHOD("get_bits"), &LipSyncStreamCodec::get_bits);
+    ClassDB::bind_method(D_METHOD("set_deadband", "steps"), &LipSyncStreamCodec::set_deadband);
+    ClassDB::bind_method(D_METHOD("get_deadband"), &LipSyncStreamCodec::get_deadband);
+    ClassDB::bind_method(D_METHOD("set_stride", "frames"), &LipSyncStreamCodec::set_stride);
+    ClassDB::bind_method(D_METHOD("get_stride"), &LipSyncStreamCodec::get_stride);
+    ClassDB::bind_method(D_METHOD("set_keyframe_interval", "packets"), &LipSyncStreamCodec::set_keyframe_interval);
+    ClassDB::bind_method(D_METHOD("get_keyframe_interval"), &LipSyncStreamCodec::get_keyframe_interval);
+
+    ClassDB::bind_method(D_METHOD("encode", "visemes"), &LipSyncStreamCodec::encode);
+    ClassDB::bind_method(D_METHOD("request_keyframe"), &LipSyncStreamCodec::request_keyframe);
+    ClassDB::bind_method(D_METHOD("decode", "packet"), &LipSyncStreamCodec::decode);
+    ClassDB::bind_method(D_METHOD("needs_keyframe"), &LipSyncStreamCodec::needs_keyframe);
+    ClassDB::bind_method(D_METHOD("reset"), &LipSyncStreamCodec::reset);
+}
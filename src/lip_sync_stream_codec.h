@@ -0,0 +1,63 @@
+#ifndef LIP_SYNC_STREAM_CODEC_H
+#define LIP_SYNC_STREAM_CODEC_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include "viseme_codec.h"
+
+namespace godot {
+
+// Viseme streams as small packets for multiplayer, so only the speaker's
+// machine runs a LipSyncContext. The speaker encodes the visemes of each
+// network tick and sends the packet (an RPC, or a PackedByteArray property on
+// a MultiplayerSynchronizer set to always sync); every peer decodes it into the
+// same frames at the same rate. See viseme_codec.h for the format.
+//
+// Defaults (5 bits, deadband 1, stride 2) stay under 1 kbps for continuous
+// speech. Packets are deltas, so peers must see them in order: a decoder that
+// misses one drops deltas until the next keyframe (needs_keyframe() tells the
+// receiver to ask the speaker for request_keyframe()).
+//
+// One instance encodes or decodes one stream; changing a setting resets both
+// directions and makes the next packet a keyframe.
+class LipSyncStreamCodec : public RefCounted {
+    GDCLASS(LipSyncStreamCodec, RefCounted)
+
+private:
+    viseme_codec::Config config;
+    viseme_codec::Encoder encoder;
+    viseme_codec::Decoder decoder;
+    std::vector<float> decoded; // Scratch reused across decode calls
+
+    void _configure();
+
+protected:
+    static void _bind_methods();
+
+public:
+    void set_viseme_count(int p_count);
+    int get_viseme_count() const { return encoder.get_config().viseme_count; }
+    void set_bits(int p_bits);
+    int get_bits() const { return encoder.get_config().bits; }
+    void set_deadband(int p_steps);
+    int get_deadband() const { return encoder.get_config().deadband; }
+    void set_stride(int p_frames);
+    int get_stride() const { return encoder.get_config().stride; }
+    void set_keyframe_interval(int p_packets) { encoder.set_keyframe_interval(p_packets); }
+    int get_keyframe_interval() const { return encoder.get_keyframe_interval(); }
+
+    // Whole frames [frames * viseme_count] into one packet
+    PackedByteArray encode(const PackedFloat32Array &p_visemes);
+    void request_keyframe() { encoder.request_keyframe(); }
+
+    // The packet's frames [frames * viseme_count]; empty while waiting for a keyframe
+    PackedFloat32Array decode(const PackedByteArray &p_packet);
+    bool needs_keyframe() const { return decoder.needs_keyframe(); }
+
+    void reset() { _configure(); }
+};
+
+} // namespace godot
+
+#endif
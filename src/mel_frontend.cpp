@@ -0,0 +1,310 @@
+#include "mel_frontend.h"
+#include "custom_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace mel_frontend {
+
+void Frontend::configure(const Config &p_config) {
+    config = p_config;
+    packed_basis.clear();
+    packed_mel_bank.clear();
+    _init_window();
+    _init_fft();
+    _init_mel_filter_bank();
+}
+
+void Frontend::_init_window() {
+    window.resize(config.window_length);
+
+    // Hann window
+    for (int i = 0; i < config.window_length; i++) {
+        window[i] = 0.5f * (1.0f - std::cos(2.0f * M_PI * i / (config.window_length - 1)));
+    }
+}
+
+// Simple bit reversal and trig table pre-computation
+void Frontend::_init_fft() {
+    const int n_fft = config.n_fft;
+    // Assumes n_fft is power of 2
+    int levels = 0;
+    int temp = n_fft;
+    while (temp > 1) {
+        temp >>= 1;
+        levels++;
+    }
+
+    bit_reverse_table.resize(n_fft);
+    for (int i = 0; i < n_fft; i++) {
+        int rev = 0;
+        int curr = i;
+        for (int j = 0; j < levels; j++) {
+            rev = (rev << 1) | (curr & 1);
+            curr >>= 1;
+        }
+        bit_reverse_table[i] = rev;
+    }
+
+    trig_tables.resize(n_fft / 2);
+    for (int i = 0; i < n_fft / 2; i++) {
+        float angle = -2.0f * M_PI * i / n_fft;
+        trig_tables[i] = std::complex<float>(std::cos(angle), std::sin(angle));
+    }
+}
+
+// In-place iterative Cooley-Tukey FFT
+void Frontend::_fft(std::vector<std::complex<float>> &p_data) const {
+    int n = p_data.size();
+
+    // Bit-reverse permutation
+    for (int i = 0; i < n; i++) {
+        if (i < bit_reverse_table[i]) {
+            std::swap(p_data[i], p_data[bit_reverse_table[i]]);
+        }
+    }
+
+    // Butterfly operations
+    for (int len = 2; len <= n; len <<= 1) {
+        int half_len = len >> 1;
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < half_len; j++) {
+                std::complex<float> u = p_data[i + j];
+                std::complex<float> v = p_data[i + j + half_len] * trig_tables[j * step];
+                p_data[i + j] = u + v;
+                p_data[i + j + half_len] = u - v;
+            }
+        }
+    }
+}
+
+float Frontend::hz_to_mel(float p_hz) {
+    return 2595.0f * std::log10(1.0f + p_hz / 700.0f);
+}
+
+float Frontend::mel_to_hz(float p_mel) {
+    return 700.0f * (std::pow(10.0f, p_mel / 2595.0f) - 1.0f);
+}
+
+void Frontend::_init_mel_filter_bank() {
+    const int n_mels = config.n_mels;
+    int num_spectra = config.n_fft / 2 + 1;
+    mel_filter_bank.assign(n_mels * num_spectra, 0.0f);
+
+    float mel_min = hz_to_mel(config.f_min);
+    float mel_max = hz_to_mel(config.f_max);
+
+    std::vector<float> mel_points(n_mels + 2);
+    std::vector<float> hz_points(n_mels + 2);
+    std::vector<float> bin_points(n_mels + 2);
+
+    for (int i = 0; i < n_mels + 2; i++) {
+        mel_points[i] = mel_min + (mel_max - mel_min) * i / (n_mels + 1);
+        hz_points[i] = mel_to_hz(mel_points[i]);
+        // Matching C# implementation exactly: (_nFft + 1) * hz / sample_rate
+        bin_points[i] = (float)(config.n_fft + 1) * hz_points[i] / config.sample_rate;
+    }
+
+    for (int i = 0; i < n_mels; i++) {
+        float left = bin_points[i];
+        float center = bin_points[i + 1];
+        float right = bin_points[i + 2];
+
+        for (int j = 0; j < num_spectra; j++) {
+            float weight = 0.0f;
+            if (j >= left && j <= center) {
+                weight = (j - left) / (center - left);
+            } else if (j > center && j <= right) {
+                weight = (right - j) / (right - center);
+            }
+
+            mel_filter_bank[i * num_spectra + j] = weight;
+        }
+    }
+}
+
+void Frontend::_init_basis() {
+    const int window_length = config.window_length;
+    const int n_mels = config.n_mels;
+    const int num_spectra = config.n_fft / 2 + 1;
+
+    // Only the bins some filter touches contribute to the output
+    int first = num_spectra;
+    int last = -1;
+    for (int i = 0; i < n_mels; i++) {
+        for (int j = 0; j < num_spectra; j++) {
+            if (mel_filter_bank[i * num_spectra + j] != 0.0f) {
+                first = std::min(first, j);
+                last = std::max(last, j);
+            }
+        }
+    }
+    if (last < first) {
+        first = 0;
+        last = 0;
+    }
+    basis_first_bin = first;
+    basis_bins = last - first + 1;
+
+    // Rows [0, bins) are the real parts, [bins, 2 * bins) the imaginary ones,
+    // with the window folded in. The phase index is reduced mod n_fft and the
+    // trig done in double so the basis is exact to float precision.
+    std::vector<float> basis((size_t)(2 * basis_bins * window_length));
+    for (int b = 0; b < basis_bins; b++) {
+        int64_t k = first + b;
+        for (int n = 0; n < window_length; n++) {
+            double angle = -2.0 * M_PI * (double)((k * n) % config.n_fft) / config.n_fft;
+            basis[(size_t)b * window_length + n] = (float)(std::cos(angle) * window[n]);
+            basis[(size_t)(basis_bins + b) * window_length + n] = (float)(std::sin(angle) * window[n]);
+        }
+    }
+    packed_basis = custom_ops::pack_conv_weights(basis.data(), 2 * basis_bins, window_length, 1);
+
+    std::vector<float> bank((size_t)(n_mels * basis_bins));
+    for (int i = 0; i < n_mels; i++) {
+        for (int b = 0; b < basis_bins; b++) {
+            bank[(size_t)i * basis_bins + b] = mel_filter_bank[i * num_spectra + first + b];
+        }
+    }
+    packed_mel_bank = custom_ops::pack_conv_weights(bank.data(), n_mels, basis_bins, 1);
+}
+
+// Normalizes the mel bands of one frame relative to each other, like
+// NormalizePerUtterance in the C# implementation (it is handed one frame).
+static void _normalize(float *r_features, int n_mels) {
+    float sum = 0.0f;
+    for (int i = 0; i < n_mels; i++) sum += r_features[i];
+    float mean = sum / n_mels;
+
+    float sum_sq = 0.0f;
+    for (int i = 0; i < n_mels; i++) {
+        float diff = r_features[i] - mean;
+        sum_sq += diff * diff;
+    }
+    float std = std::sqrt(sum_sq / n_mels);
+    if (std < 1e-8f) std = 1e-8f;
+
+    for (int i = 0; i < n_mels; i++) {
+        r_features[i] = (r_features[i] - mean) / std;
+    }
+}
+
+void Frontend::compute_frame(const float *p_samples, float *r_features, float *r_band_energy) const {
+    // Scratch per thread, the custom op may run on several ORT threads at once
+    thread_local std::vector<std::complex<float>> fft_input;
+
+    // 1. Apply Window & Prepare FFT Input
+    // Zero pad if window_length < n_fft
+    fft_input.assign(config.n_fft, std::complex<float>(0, 0));
+    for (int i = 0; i < config.window_length; i++) {
+        fft_input[i] = std::complex<float>(p_samples[i] * window[i], 0);
+    }
+
+    // 2. FFT
+    _fft(fft_input);
+
+    // 3. Power Spectrum & Mel Filtering
+    // We only need the first n_fft/2 + 1 bins (nyquist)
+    const int n_mels = config.n_mels;
+    int num_spectra = config.n_fft / 2 + 1;
+    for (int i = 0; i < n_mels; i++) {
+        float sum = 0.0f;
+        for (int j = 0; j < num_spectra; j++) {
+            // Power spectrum, as in the C# implementation (Magnitude * Magnitude)
+            float power = std::norm(fft_input[j]);
+            sum += power * mel_filter_bank[i * num_spectra + j];
+        }
+
+        // 4. Log Scale (dB)
+        // 10 * log10(max(val, 1e-10))
+        r_features[i] = 10.0f * std::log10(std::max(sum, 1e-10f));
+    }
+
+    if (r_band_energy) {
+        memcpy(r_band_energy, r_features, n_mels * sizeof(float));
+    }
+    _normalize(r_features, n_mels);
+}
+
+void Frontend::compute_clip(const float *p_samples, int64_t p_count, float *r_features) const {
+    const int64_t window_length = config.window_length;
+    const int64_t frames = frame_count(p_count);
+    std::vector<float> frame((size_t)window_length);
+    for (int64_t f = 0; f < frames; f++) {
+        // Window ending at the last sample of hop f, zero before the clip start.
+        // A window shorter than the hop covers the start of the hop instead.
+        int64_t start = window_length >= config.hop_length ? (f + 1) * config.hop_length - window_length : f * config.hop_length;
+        int64_t skip = start < 0 ? -start : 0;
+        std::fill(frame.begin(), frame.begin() + std::min(skip, window_length), 0.0f);
+        if (skip < window_length) {
+            memcpy(frame.data() + skip, p_samples + start + skip, (size_t)(window_length - skip) * sizeof(float));
+        }
+        compute_frame(frame.data(), r_features + f * config.n_mels);
+    }
+}
+
+void Frontend::compute_clip_batched(const float *p_samples, int64_t p_count, float *r_features) {
+    if (packed_basis.empty()) {
+        _init_basis();
+    }
+    const int64_t window_length = config.window_length;
+    const int64_t hop_length = config.hop_length;
+    const int64_t n_mels = config.n_mels;
+    const int64_t bins = basis_bins;
+    const int64_t frames = frame_count(p_count);
+    const std::vector<float> zero_bias((size_t)std::max<int64_t>(2 * bins, n_mels), 0.0f);
+
+    // Blocks of frames keep the framed samples, the spectrum and the power of a
+    // block in L2 while the packed basis streams through once per block.
+    const int64_t BLOCK = 128;
+    std::vector<float> framed((size_t)(window_length * BLOCK));
+    std::vector<float> spectrum((size_t)(2 * bins * BLOCK));
+    std::vector<float> power((size_t)(bins * BLOCK));
+    std::vector<float> mel((size_t)(n_mels * BLOCK));
+    for (int64_t f0 = 0; f0 < frames; f0 += BLOCK) {
+        const int64_t count = std::min(BLOCK, frames - f0);
+
+        // Framed samples, time-major: framed[n, t] is sample n of frame f0 + t.
+        // Framing as in compute_clip().
+        for (int64_t t = 0; t < count; t++) {
+            int64_t f = f0 + t;
+            int64_t start = window_length >= hop_length ? (f + 1) * hop_length - window_length : f * hop_length;
+            for (int64_t n = 0; n < window_length; n++) {
+                int64_t index = start + n;
+                framed[n * count + t] = index >= 0 ? p_samples[index] : 0.0f;
+            }
+        }
+
+        // [2 * bins, count] = basis x framed, then |.|^2
+        custom_ops::causal_conv1d(framed.data(), packed_basis.data(), zero_bias.data(), nullptr, 0, spectrum.data(),
+                window_length, 2 * bins, 1, 1, count, false);
+        for (int64_t b = 0; b < bins; b++) {
+            const float *re = spectrum.data() + b * count;
+            const float *im = spectrum.data() + (bins + b) * count;
+            float *p = power.data() + b * count;
+            for (int64_t t = 0; t < count; t++) {
+                p[t] = re[t] * re[t] + im[t] * im[t];
+            }
+        }
+
+        // [n_mels, count] = filter bank x power
+        custom_ops::causal_conv1d(power.data(), packed_mel_bank.data(), zero_bias.data(), nullptr, 0, mel.data(),
+                bins, n_mels, 1, 1, count, false);
+
+        // Log (dB) and normalization, back to frame-major
+        for (int64_t t = 0; t < count; t++) {
+            float *features = r_features + (f0 + t) * n_mels;
+            for (int64_t i = 0; i < n_mels; i++) {
+                features[i] = 10.0f * std::log10(std::max(mel[i * count + t], 1e-10f));
+            }
+            _normalize(features, (int)n_mels);
+        }
+    }
+}
+
+} // namespace mel_frontend
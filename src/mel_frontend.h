@@ -0,0 +1,84 @@
+#ifndef MEL_FRONTEND_H
+#define MEL_FRONTEND_H
+
+// Log-mel feature extraction shared by AudioProcessor (streaming) and the
+// LogMelFeatures custom op (whole clips inside the ONNX graph), so both produce
+// the same features. Has no Godot dependencies.
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+namespace mel_frontend {
+
+struct Config {
+    int sample_rate = 16000;
+    int hop_length = 160;    // 10ms at 16kHz
+    int window_length = 400; // 25ms at 16kHz
+    int n_fft = 1024;        // Power of 2
+    int n_mels = 80;
+    float f_min = 50.0f;
+    float f_max = 8000.0f;
+};
+
+class Frontend {
+    Config config;
+
+    std::vector<float> window; // Hann, window_length
+
+    // Mel Filter Bank: flattened [n_mels * (n_fft/2 + 1)]
+    // Stored as row-major: filter_bank[mel_idx * (n_fft/2 + 1) + bin_idx]
+    std::vector<float> mel_filter_bank;
+
+    std::vector<int> bit_reverse_table;
+    std::vector<std::complex<float>> trig_tables;
+
+    // Batched path, built on first use: the windowed DFT basis truncated to the
+    // bins the filter bank uses ([re; im] x window_length) and the matching
+    // filter bank columns, both packed for custom_ops::causal_conv1d.
+    int basis_first_bin = 0;
+    int basis_bins = 0;
+    std::vector<float> packed_basis;
+    std::vector<float> packed_mel_bank;
+    void _init_basis();
+
+    void _init_window();
+    void _init_fft();
+    void _init_mel_filter_bank();
+    void _fft(std::vector<std::complex<float>> &p_data) const;
+
+public:
+    Frontend() { configure(Config()); }
+
+    // Recomputes the window, FFT tables and filter bank
+    void configure(const Config &p_config);
+    const Config &get_config() const { return config; }
+
+    const std::vector<float> &get_window() const { return window; }
+    const std::vector<float> &get_mel_filter_bank() const { return mel_filter_bank; }
+
+    // One frame: window_length raw samples -> n_mels log-mel features,
+    // normalised to zero mean and unit variance across the bands. When given,
+    // r_band_energy receives the n_mels band energies in dB before normalisation.
+    void compute_frame(const float *p_samples, float *r_features, float *r_band_energy = nullptr) const;
+
+    // A whole clip, as if its hops were streamed through AudioProcessor right
+    // after a reset: frame i ends at sample (i + 1) * hop_length and anything
+    // before the clip start is silence. Writes frame_count() * n_mels values.
+    int64_t frame_count(int64_t p_samples) const { return p_samples / config.hop_length; }
+    void compute_clip(const float *p_samples, int64_t p_count, float *r_features) const;
+
+    // Same output as compute_clip() up to float rounding, computed as two GEMMs
+    // over blocks of frames instead of one FFT per frame:
+    //   power = |frames x DFT basis|^2, mel = power x filter bank.
+    // Builds its tables on the first call, so it is not safe to call
+    // concurrently on the same Frontend.
+    void compute_clip_batched(const float *p_samples, int64_t p_count, float *r_features);
+
+    static float hz_to_mel(float p_hz);
+    static float mel_to_hz(float p_mel);
+};
+
+} // namespace mel_frontend
+
+#endif
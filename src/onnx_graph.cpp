@@ -0,0 +1,1137 @@
+#include "onnx_graph.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <set>
+
+namespace onnx_graph {
+
+// ONNX field numbers (onnx.proto3)
+enum {
+    MODEL_OPSET_IMPORT = 8,
+    MODEL_GRAPH = 7,
+
+    OPSET_DOMAIN = 1,
+    OPSET_VERSION = 2,
+
+    GRAPH_NODE = 1,
+    GRAPH_INITIALIZER = 5,
+    GRAPH_INPUT = 11,
+    GRAPH_OUTPUT = 12,
+
+    NODE_INPUT = 1,
+    NODE_OUTPUT = 2,
+    NODE_NAME = 3,
+    NODE_OP_TYPE = 4,
+    NODE_ATTRIBUTE = 5,
+    NODE_DOMAIN = 7,
+
+    ATTR_NAME = 1,
+    ATTR_F = 2,
+    ATTR_I = 3,
+    ATTR_T = 5,
+    ATTR_S = 4,
+    ATTR_INTS = 8,
+    ATTR_TYPE = 20,
+
+    TENSOR_DIMS = 1,
+    TENSOR_DATA_TYPE = 2,
+    TENSOR_INT64_DATA = 7,
+    TENSOR_NAME = 8,
+    TENSOR_RAW_DATA = 9,
+
+    VALUE_INFO_NAME = 1,
+    VALUE_INFO_TYPE = 2,
+
+    TYPE_TENSOR = 1,
+    TYPE_TENSOR_ELEM_TYPE = 1,
+    TYPE_TENSOR_SHAPE = 2,
+    SHAPE_DIM = 1,
+    DIM_VALUE = 1,
+    DIM_PARAM = 2,
+};
+
+enum {
+    WIRE_VARINT = 0,
+    WIRE_FIXED64 = 1,
+    WIRE_BYTES = 2,
+    WIRE_FIXED32 = 5,
+};
+
+enum {
+    ATTR_TYPE_FLOAT = 1,
+    ATTR_TYPE_INT = 2,
+    ATTR_TYPE_STRING = 3,
+    ATTR_TYPE_INTS = 7,
+};
+
+static const int TENSOR_TYPE_FLOAT = 1;
+static const int TENSOR_TYPE_INT64 = 7;
+
+static bool _read_varint(const uint8_t *&p, const uint8_t *end, uint64_t &r_value) {
+    r_value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) {
+            return false;
+        }
+        uint8_t byte = *p++;
+        r_value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void _write_varint(std::string &r_out, uint64_t p_value) {
+    while (p_value >= 0x80) {
+        r_out.push_back((char)((p_value & 0x7F) | 0x80));
+        p_value >>= 7;
+    }
+    r_out.push_back((char)p_value);
+}
+
+// --- Message ---
+
+bool Message::parse(const uint8_t *p_data, size_t p_size) {
+    fields.clear();
+    const uint8_t *p = p_data;
+    const uint8_t *end = p_data + p_size;
+    while (p < end) {
+        uint64_t key;
+        if (!_read_varint(p, end, key)) {
+            return false;
+        }
+        Field field;
+        field.number = (uint32_t)(key >> 3);
+        field.wire_type = (uint32_t)(key & 7);
+        switch (field.wire_type) {
+            case WIRE_VARINT:
+                if (!_read_varint(p, end, field.value)) {
+                    return false;
+                }
+                break;
+            case WIRE_FIXED64:
+                if (end - p < 8) {
+                    return false;
+                }
+                memcpy(&field.value, p, 8);
+                p += 8;
+                break;
+            case WIRE_BYTES: {
+                uint64_t length;
+                if (!_read_varint(p, end, length) || (uint64_t)(end - p) < length) {
+                    return false;
+                }
+                field.bytes.assign((const char *)p, (size_t)length);
+                p += length;
+            } break;
+            case WIRE_FIXED32: {
+                if (end - p < 4) {
+                    return false;
+                }
+                uint32_t v;
+                memcpy(&v, p, 4);
+                field.value = v;
+                p += 4;
+            } break;
+            default:
+                // Groups are deprecated and never used by ONNX
+                return false;
+        }
+        fields.push_back(std::move(field));
+    }
+    return true;
+}
+
+std::string Message::serialize() const {
+    std::string out;
+    for (const Field &field : fields) {
+        _write_varint(out, ((uint64_t)field.number << 3) | field.wire_type);
+        switch (field.wire_type) {
+            case WIRE_VARINT:
+                _write_varint(out, field.value);
+                break;
+            case WIRE_FIXED64:
+                out.append((const char *)&field.value, 8);
+                break;
+            case WIRE_BYTES:
+                _write_varint(out, field.bytes.size());
+                out.append(field.bytes);
+                break;
+            case WIRE_FIXED32: {
+                uint32_t v = (uint32_t)field.value;
+                out.append((const char *)&v, 4);
+            } break;
+        }
+    }
+    return out;
+}
+
+const Field *Message::find(uint32_t p_number) const {
+    for (const Field &field : fields) {
+        if (field.number == p_number) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+std::string Message::get_string(uint32_t p_number) const {
+    const Field *field = find(p_number);
+    return field ? field->bytes : std::string();
+}
+
+std::vector<std::string> Message::get_strings(uint32_t p_number) const {
+    std::vector<std::string> result;
+    for (const Field &field : fields) {
+        if (field.number == p_number) {
+            result.push_back(field.bytes);
+        }
+    }
+    return result;
+}
+
+int64_t Message::get_int(uint32_t p_number, int64_t p_default) const {
+    const Field *field = find(p_number);
+    return field ? (int64_t)field->value : p_default;
+}
+
+std::vector<int64_t> Message::get_ints(uint32_t p_number) const {
+    std::vector<int64_t> result;
+    for (const Field &field : fields) {
+        if (field.number != p_number) {
+            continue;
+        }
+        if (field.wire_type == WIRE_BYTES) {
+            const uint8_t *p = (const uint8_t *)field.bytes.data();
+            const uint8_t *end = p + field.bytes.size();
+            uint64_t v;
+            while (p < end && _read_varint(p, end, v)) {
+                result.push_back((int64_t)v);
+            }
+        } else {
+            result.push_back((int64_t)field.value);
+        }
+    }
+    return result;
+}
+
+void Message::add_varint(uint32_t p_number, uint64_t p_value) {
+    Field field;
+    field.number = p_number;
+    field.wire_type = WIRE_VARINT;
+    field.value = p_value;
+    fields.push_back(std::move(field));
+}
+
+void Message::add_fixed32(uint32_t p_number, uint32_t p_value) {
+    Field field;
+    field.number = p_number;
+    field.wire_type = WIRE_FIXED32;
+    field.value = p_value;
+    fields.push_back(std::move(field));
+}
+
+void Message::add_bytes(uint32_t p_number, const std::string &p_bytes) {
+    Field field;
+    field.number = p_number;
+    field.wire_type = WIRE_BYTES;
+    field.bytes = p_bytes;
+    fields.push_back(std::move(field));
+}
+
+void Message::remove(uint32_t p_number) {
+    std::vector<Field> kept;
+    for (Field &field : fields) {
+        if (field.number != p_number) {
+            kept.push_back(std::move(field));
+        }
+    }
+    fields.swap(kept);
+}
+
+// --- Nodes ---
+
+std::string node_op_type(const Message &p_node) {
+    return p_node.get_string(NODE_OP_TYPE);
+}
+
+std::string node_name(const Message &p_node) {
+    return p_node.get_string(NODE_NAME);
+}
+
+std::vector<std::string> node_inputs(const Message &p_node) {
+    return p_node.get_strings(NODE_INPUT);
+}
+
+std::vector<std::string> node_outputs(const Message &p_node) {
+    return p_node.get_strings(NODE_OUTPUT);
+}
+
+static void _set_nth(Message &p_message, uint32_t p_number, int p_index, const std::string &p_value) {
+    int index = 0;
+    for (Field &field : p_message.fields) {
+        if (field.number == p_number) {
+            if (index == p_index) {
+                field.bytes = p_value;
+                return;
+            }
+            index++;
+        }
+    }
+}
+
+void set_node_input(Message &p_node, int p_index, const std::string &p_name) {
+    _set_nth(p_node, NODE_INPUT, p_index, p_name);
+}
+
+void set_node_output(Message &p_node, int p_index, const std::string &p_name) {
+    _set_nth(p_node, NODE_OUTPUT, p_index, p_name);
+}
+
+static bool _find_attribute(const Message &p_node, const std::string &p_name, Message &r_attribute) {
+    for (const Field &field : p_node.fields) {
+        if (field.number != NODE_ATTRIBUTE) {
+            continue;
+        }
+        Message attribute;
+        if (attribute.parse(field.bytes) && attribute.get_string(ATTR_NAME) == p_name) {
+            r_attribute = attribute;
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t node_attribute_int(const Message &p_node, const std::string &p_name, int64_t p_default) {
+    Message attribute;
+    if (!_find_attribute(p_node, p_name, attribute)) {
+        return p_default;
+    }
+    return attribute.get_int(ATTR_I, p_default);
+}
+
+std::vector<int64_t> node_attribute_ints(const Message &p_node, const std::string &p_name) {
+    Message attribute;
+    if (!_find_attribute(p_node, p_name, attribute)) {
+        return std::vector<int64_t>();
+    }
+    return attribute.get_ints(ATTR_INTS);
+}
+
+Message make_node(const std::string &p_op_type, const std::string &p_name, const std::vector<std::string> &p_inputs, const std::vector<std::string> &p_outputs, const std::string &p_domain) {
+    Message node;
+    for (const std::string &input : p_inputs) {
+        node.add_bytes(NODE_INPUT, input);
+    }
+    for (const std::string &output : p_outputs) {
+        node.add_bytes(NODE_OUTPUT, output);
+    }
+    node.add_bytes(NODE_NAME, p_name);
+    node.add_bytes(NODE_OP_TYPE, p_op_type);
+    if (!p_domain.empty()) {
+        node.add_bytes(NODE_DOMAIN, p_domain);
+    }
+    return node;
+}
+
+void add_attribute_int(Message &p_node, const std::string &p_name, int64_t p_value) {
+    Message attribute;
+    attribute.add_bytes(ATTR_NAME, p_name);
+    attribute.add_varint(ATTR_I, (uint64_t)p_value);
+    attribute.add_varint(ATTR_TYPE, ATTR_TYPE_INT);
+    p_node.add_message(NODE_ATTRIBUTE, attribute);
+}
+
+void add_attribute_float(Message &p_node, const std::string &p_name, float p_value) {
+    Message attribute;
+    attribute.add_bytes(ATTR_NAME, p_name);
+    uint32_t bits;
+    memcpy(&bits, &p_value, sizeof(bits));
+    attribute.add_fixed32(ATTR_F, bits);
+    attribute.add_varint(ATTR_TYPE, ATTR_TYPE_FLOAT);
+    p_node.add_message(NODE_ATTRIBUTE, attribute);
+}
+
+void add_attribute_ints(Message &p_node, const std::string &p_name, const std::vector<int64_t> &p_values) {
+    Message attribute;
+    attribute.add_bytes(ATTR_NAME, p_name);
+    for (int64_t value : p_values) {
+        attribute.add_varint(ATTR_INTS, (uint64_t)value);
+    }
+    attribute.add_varint(ATTR_TYPE, ATTR_TYPE_INTS);
+    p_node.add_message(NODE_ATTRIBUTE, attribute);
+}
+
+void add_attribute_string(Message &p_node, const std::string &p_name, const std::string &p_value) {
+    Message attribute;
+    attribute.add_bytes(ATTR_NAME, p_name);
+    attribute.add_bytes(ATTR_S, p_value);
+    attribute.add_varint(ATTR_TYPE, ATTR_TYPE_STRING);
+    p_node.add_message(NODE_ATTRIBUTE, attribute);
+}
+
+Message make_int64_tensor(const std::string &p_name, const std::vector<int64_t> &p_dims, const std::vector<int64_t> &p_values) {
+    Message tensor;
+    for (int64_t dim : p_dims) {
+        tensor.add_varint(TENSOR_DIMS, (uint64_t)dim);
+    }
+    tensor.add_varint(TENSOR_DATA_TYPE, TENSOR_TYPE_INT64);
+    tensor.add_bytes(TENSOR_NAME, p_name);
+    // raw_data is always little-endian, as are all our targets
+    tensor.add_bytes(TENSOR_RAW_DATA, std::string((const char *)p_values.data(), p_values.size() * sizeof(int64_t)));
+    return tensor;
+}
+
+Message make_float_tensor(const std::string &p_name, const std::vector<int64_t> &p_dims, const std::vector<float> &p_values) {
+    Message tensor;
+    for (int64_t dim : p_dims) {
+        tensor.add_varint(TENSOR_DIMS, (uint64_t)dim);
+    }
+    tensor.add_varint(TENSOR_DATA_TYPE, TENSOR_TYPE_FLOAT);
+    tensor.add_bytes(TENSOR_NAME, p_name);
+    tensor.add_bytes(TENSOR_RAW_DATA, std::string((const char *)p_values.data(), p_values.size() * sizeof(float)));
+    return tensor;
+}
+
+Message make_float_value_info(const std::string &p_name, const std::vector<std::string> &p_dims) {
+    Message shape;
+    for (const std::string &dim : p_dims) {
+        Message dimension;
+        char *end = nullptr;
+        long long value = strtoll(dim.c_str(), &end, 10);
+        if (!dim.empty() && *end == '\0') {
+            dimension.add_varint(DIM_VALUE, (uint64_t)value);
+        } else {
+            dimension.add_bytes(DIM_PARAM, dim);
+        }
+        shape.add_message(SHAPE_DIM, dimension);
+    }
+    Message tensor_type;
+    tensor_type.add_varint(TYPE_TENSOR_ELEM_TYPE, TENSOR_TYPE_FLOAT);
+    tensor_type.add_message(TYPE_TENSOR_SHAPE, shape);
+    Message type;
+    type.add_message(TYPE_TENSOR, tensor_type);
+
+    Message info;
+    info.add_bytes(VALUE_INFO_NAME, p_name);
+    info.add_message(VALUE_INFO_TYPE, type);
+    return info;
+}
+
+static bool _tensor_ints(const Message &p_tensor, std::vector<int64_t> &r_values) {
+    if (p_tensor.get_int(TENSOR_DATA_TYPE) != TENSOR_TYPE_INT64) {
+        return false;
+    }
+    const Field *raw = p_tensor.find(TENSOR_RAW_DATA);
+    if (raw) {
+        r_values.resize(raw->bytes.size() / sizeof(int64_t));
+        memcpy(r_values.data(), raw->bytes.data(), r_values.size() * sizeof(int64_t));
+    } else {
+        r_values = p_tensor.get_ints(TENSOR_INT64_DATA);
+    }
+    return true;
+}
+
+// --- Model ---
+
+bool Model::load(const uint8_t *p_data, size_t p_size, std::string &r_error) {
+    nodes.clear();
+    if (!model.parse(p_data, p_size)) {
+        r_error = "Malformed model protobuf";
+        return false;
+    }
+    const Field *graph_field = model.find(MODEL_GRAPH);
+    if (!graph_field || !graph.parse(graph_field->bytes)) {
+        r_error = "Model has no readable graph";
+        return false;
+    }
+    for (const Field &field : graph.fields) {
+        if (field.number == GRAPH_NODE) {
+            Message node;
+            if (!node.parse(field.bytes)) {
+                r_error = "Malformed node";
+                return false;
+            }
+            nodes.push_back(std::move(node));
+        }
+    }
+    graph.remove(GRAPH_NODE);
+    return true;
+}
+
+std::string Model::save() const {
+    Message out_graph;
+    for (const Message &node : nodes) {
+        out_graph.add_message(GRAPH_NODE, node);
+    }
+    out_graph.fields.insert(out_graph.fields.end(), graph.fields.begin(), graph.fields.end());
+
+    Message out_model;
+    for (const Field &field : model.fields) {
+        if (field.number == MODEL_GRAPH) {
+            out_model.add_message(MODEL_GRAPH, out_graph);
+        } else {
+            out_model.fields.push_back(field);
+        }
+    }
+    return out_model.serialize();
+}
+
+int64_t Model::get_opset(const std::string &p_domain) const {
+    for (const Field &field : model.fields) {
+        if (field.number != MODEL_OPSET_IMPORT) {
+            continue;
+        }
+        Message opset;
+        if (!opset.parse(field.bytes)) {
+            continue;
+        }
+        std::string domain = opset.get_string(OPSET_DOMAIN);
+        if (domain == p_domain || (p_domain.empty() && domain == "ai.onnx")) {
+            return opset.get_int(OPSET_VERSION, 0);
+        }
+    }
+    return 0;
+}
+
+void Model::set_opset(const std::string &p_domain, int64_t p_version) {
+    if (get_opset(p_domain) == p_version) {
+        return;
+    }
+    Message opset;
+    opset.add_bytes(OPSET_DOMAIN, p_domain);
+    opset.add_varint(OPSET_VERSION, (uint64_t)p_version);
+    model.add_message(MODEL_OPSET_IMPORT, opset);
+}
+
+static std::vector<std::string> _value_info_names(const Message &p_graph, uint32_t p_number) {
+    std::vector<std::string> names;
+    for (const Field &field : p_graph.fields) {
+        if (field.number != p_number) {
+            continue;
+        }
+        Message info;
+        if (info.parse(field.bytes)) {
+            names.push_back(info.get_string(VALUE_INFO_NAME));
+        }
+    }
+    return names;
+}
+
+std::vector<std::string> Model::input_names() const {
+    return _value_info_names(graph, GRAPH_INPUT);
+}
+
+std::vector<std::string> Model::output_names() const {
+    return _value_info_names(graph, GRAPH_OUTPUT);
+}
+
+std::vector<std::string> Model::initializer_names() const {
+    std::vector<std::string> names;
+    for (const Field &field : graph.fields) {
+        if (field.number != GRAPH_INITIALIZER) {
+            continue;
+        }
+        Message tensor;
+        if (tensor.parse(field.bytes)) {
+            names.push_back(tensor.get_string(TENSOR_NAME));
+        }
+    }
+    return names;
+}
+
+std::vector<int64_t> Model::initializer_dims(const std::string &p_name, bool &r_found) const {
+    r_found = false;
+    for (const Field &field : graph.fields) {
+        if (field.number != GRAPH_INITIALIZER) {
+            continue;
+        }
+        Message tensor;
+        if (tensor.parse(field.bytes) && tensor.get_string(TENSOR_NAME) == p_name) {
+            r_found = true;
+            return tensor.get_ints(TENSOR_DIMS);
+        }
+    }
+    return std::vector<int64_t>();
+}
+
+bool Model::replace_input(const std::string &p_name, const Message &p_value_info) {
+    for (Field &field : graph.fields) {
+        if (field.number != GRAPH_INPUT) {
+            continue;
+        }
+        Message info;
+        if (info.parse(field.bytes) && info.get_string(VALUE_INFO_NAME) == p_name) {
+            field.bytes = p_value_info.serialize();
+            return true;
+        }
+    }
+    return false;
+}
+
+int Model::find_producer(const std::string &p_tensor) const {
+    for (size_t i = 0; i < nodes.size(); i++) {
+        for (const std::string &output : node_outputs(nodes[i])) {
+            if (output == p_tensor) {
+                return (int)i;
+            }
+        }
+    }
+    return -1;
+}
+
+int Model::count_consumers(const std::string &p_tensor) const {
+    int count = 0;
+    for (const Message &node : nodes) {
+        for (const std::string &input : node_inputs(node)) {
+            if (input == p_tensor) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+bool Model::get_constant_ints(const std::string &p_tensor, std::vector<int64_t> &r_values) const {
+    int producer = find_producer(p_tensor);
+    if (producer >= 0) {
+        const Message &node = nodes[producer];
+        if (node_op_type(node) != "Constant") {
+            return false;
+        }
+        for (const Field &field : node.fields) {
+            if (field.number != NODE_ATTRIBUTE) {
+                continue;
+            }
+            Message attribute;
+            Message tensor;
+            if (attribute.parse(field.bytes) && attribute.get_string(ATTR_NAME) == "value" && tensor.parse(attribute.get_string(ATTR_T))) {
+                return _tensor_ints(tensor, r_values);
+            }
+        }
+        return false;
+    }
+    for (const Field &field : graph.fields) {
+        if (field.number != GRAPH_INITIALIZER) {
+            continue;
+        }
+        Message tensor;
+        if (tensor.parse(field.bytes) && tensor.get_string(TENSOR_NAME) == p_tensor) {
+            return _tensor_ints(tensor, r_values);
+        }
+    }
+    return false;
+}
+
+int Model::remove_dead_nodes() {
+    std::set<std::string> graph_outputs;
+    for (const std::string &name : output_names()) {
+        graph_outputs.insert(name);
+    }
+
+    int removed = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::set<std::string> used(graph_outputs);
+        for (const Message &node : nodes) {
+            for (const std::string &input : node_inputs(node)) {
+                used.insert(input);
+            }
+        }
+        std::vector<Message> kept;
+        for (Message &node : nodes) {
+            bool live = false;
+            for (const std::string &output : node_outputs(node)) {
+                live = live || used.count(output);
+            }
+            if (live) {
+                kept.push_back(std::move(node));
+            } else {
+                removed++;
+                changed = true;
+            }
+        }
+        nodes.swap(kept);
+    }
+    return removed;
+}
+
+// --- Passes ---
+
+// Finds the single time-series input of a node that acts on each time step of
+// a [B, T, C] tensor independently. Returns -1 if the node isn't one.
+static int _per_step_data_input(const Model &p_model, const Message &p_node) {
+    std::string op = node_op_type(p_node);
+    std::vector<std::string> inputs = node_inputs(p_node);
+
+    static const std::set<std::string> unary = { "Relu", "Sigmoid", "Tanh", "Identity", "LeakyRelu", "Elu", "HardSigmoid" };
+    if (unary.count(op) && inputs.size() == 1) {
+        return 0;
+    }
+    if ((op == "Softmax" || op == "LogSoftmax") && inputs.size() == 1) {
+        // The default axis was 1 before opset 13, and those versions flatten
+        // to [B, T * C] from it, so that one normalises across time
+        int64_t axis = node_attribute_int(p_node, "axis", p_model.get_opset() >= 13 ? -1 : 1);
+        if (axis < 0) {
+            axis += 3;
+        }
+        return axis == 2 ? 0 : -1;
+    }
+    if (op == "MatMul" && inputs.size() == 2) {
+        // x[B, T, C] @ W[C, K] with constant W
+        bool found;
+        std::vector<int64_t> dims = p_model.initializer_dims(inputs[1], found);
+        return (found && dims.size() == 2) ? 0 : -1;
+    }
+    if ((op == "Add" || op == "Mul" || op == "Sub" || op == "Div") && inputs.size() == 2) {
+        // Elementwise with a constant broadcast along channels only
+        for (int i = 0; i < 2; i++) {
+            bool found;
+            std::vector<int64_t> dims = p_model.initializer_dims(inputs[1 - i], found);
+            if (found && dims.size() <= 1) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+bool slice_output_to_last_step(Model &p_model, std::string &r_error) {
+    if (p_model.get_opset() < 10) {
+        r_error = "Slice with tensor inputs needs opset 10 or newer";
+        return false;
+    }
+    // Rewrite a copy so a failure leaves the model untouched
+    Model model = p_model;
+    std::vector<std::string> outputs = model.output_names();
+    if (outputs.empty()) {
+        r_error = "Model has no outputs";
+        return false;
+    }
+
+    // Walk back from the output through per-time-step ops
+    std::string tensor = outputs[0];
+    int first_node = -1;
+    int first_input = -1;
+    while (true) {
+        int producer = model.find_producer(tensor);
+        if (producer < 0) {
+            break;
+        }
+        int data_input = _per_step_data_input(model, model.nodes[producer]);
+        if (data_input < 0) {
+            break;
+        }
+        std::string source = node_inputs(model.nodes[producer])[data_input];
+        // Slicing a tensor that also feeds other nodes would be fine, but keep the
+        // rewrite to the output tail only.
+        if (model.count_consumers(source) != 1) {
+            break;
+        }
+        first_node = producer;
+        first_input = data_input;
+        tensor = source;
+    }
+
+    const std::string prefix = "openlipsync_last_step";
+    model.add_initializer(make_int64_tensor(prefix + "_starts", { 1 }, { -1 }));
+    model.add_initializer(make_int64_tensor(prefix + "_ends", { 1 }, { std::numeric_limits<int64_t>::max() }));
+    model.add_initializer(make_int64_tensor(prefix + "_axes", { 1 }, { 1 }));
+
+    if (first_node >= 0) {
+        // Slice the input of the earliest per-step op, right before it
+        std::string sliced = tensor + "_last_step";
+        Message slice = make_node("Slice", prefix, { tensor, prefix + "_starts", prefix + "_ends", prefix + "_axes" }, { sliced });
+        set_node_input(model.nodes[first_node], first_input, sliced);
+        model.nodes.insert(model.nodes.begin() + first_node, slice);
+    } else {
+        // Nothing to hoist over: slice the output itself
+        int producer = model.find_producer(outputs[0]);
+        if (producer < 0) {
+            r_error = "Output is not produced by any node";
+            return false;
+        }
+        std::string full = outputs[0] + "_all_steps";
+        std::vector<std::string> producer_outputs = node_outputs(model.nodes[producer]);
+        for (size_t i = 0; i < producer_outputs.size(); i++) {
+            if (producer_outputs[i] == outputs[0]) {
+                set_node_output(model.nodes[producer], (int)i, full);
+            }
+        }
+        Message slice = make_node("Slice", prefix, { full, prefix + "_starts", prefix + "_ends", prefix + "_axes" }, { outputs[0] });
+        model.nodes.insert(model.nodes.begin() + producer + 1, slice);
+    }
+    p_model = std::move(model);
+    return true;
+}
+
+static std::vector<int> _consumers(const Model &p_model, const std::string &p_tensor) {
+    std::vector<int> result;
+    for (size_t i = 0; i < p_model.nodes.size(); i++) {
+        for (const std::string &input : node_inputs(p_model.nodes[i])) {
+            if (input == p_tensor) {
+                result.push_back((int)i);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+static bool _constant_is(const Model &p_model, const std::string &p_tensor, const std::vector<int64_t> &p_expected) {
+    std::vector<int64_t> values;
+    return p_model.get_constant_ints(p_tensor, values) && values == p_expected;
+}
+
+// Slice over the time axis of a [B, C, T] tensor with starts 0 and unit steps
+static bool _is_time_slice_from_start(const Model &p_model, const Message &p_node) {
+    std::vector<std::string> inputs = node_inputs(p_node);
+    if (node_op_type(p_node) != "Slice" || inputs.size() < 4) {
+        return false;
+    }
+    bool axes_ok = _constant_is(p_model, inputs[3], { 2 }) || _constant_is(p_model, inputs[3], { -1 });
+    bool steps_ok = inputs.size() < 5 || inputs[4].empty() || _constant_is(p_model, inputs[4], { 1 });
+    return _constant_is(p_model, inputs[1], { 0 }) && axes_ok && steps_ok;
+}
+
+// The "chomp" after a symmetrically padded conv: x[:, :, :-p_pad]
+static bool _is_chomp(const Model &p_model, const Message &p_node, int64_t p_pad) {
+    return _is_time_slice_from_start(p_model, p_node) && _constant_is(p_model, node_inputs(p_node)[2], { -p_pad });
+}
+
+// PyTorch exports x[:, :, :y.size(2)] as Shape -> Slice/Gather -> (Squeeze ->
+// Unsqueeze) feeding the Slice ends. Returns the tensor whose length is used, or
+// an empty string if p_ends isn't computed that way.
+static std::string _time_length_source(const Model &p_model, const std::string &p_ends) {
+    std::string tensor = p_ends;
+    while (true) {
+        int producer = p_model.find_producer(tensor);
+        if (producer < 0) {
+            return std::string();
+        }
+        const Message &node = p_model.nodes[producer];
+        std::string op = node_op_type(node);
+        std::vector<std::string> inputs = node_inputs(node);
+        if ((op == "Unsqueeze" || op == "Squeeze") && !inputs.empty()) {
+            tensor = inputs[0];
+        } else if (op == "Slice" && inputs.size() >= 3) {
+            // shape[-1:] or shape[2:3]
+            bool last = _constant_is(p_model, inputs[1], { -1 }) || _constant_is(p_model, inputs[1], { 2 });
+            if (!last || (inputs.size() >= 4 && !_constant_is(p_model, inputs[3], { 0 }))) {
+                return std::string();
+            }
+            tensor = inputs[0];
+        } else if (op == "Gather" && inputs.size() == 2) {
+            if (!_constant_is(p_model, inputs[1], { -1 }) && !_constant_is(p_model, inputs[1], { 2 })) {
+                return std::string();
+            }
+            tensor = inputs[0];
+        } else if (op == "Shape" && !inputs.empty()) {
+            return inputs[0];
+        } else {
+            return std::string();
+        }
+    }
+}
+
+// x[:, :, :y.size(2)]: crops x to the length of y. Returns y, or an empty string.
+static std::string _crop_to_length_of(const Model &p_model, const Message &p_node) {
+    if (!_is_time_slice_from_start(p_model, p_node)) {
+        return std::string();
+    }
+    return _time_length_source(p_model, node_inputs(p_node)[2]);
+}
+
+static bool _graph_is_closed(const Model &p_model) {
+    std::set<std::string> available;
+    for (const std::string &name : p_model.input_names()) {
+        available.insert(name);
+    }
+    for (const std::string &name : p_model.initializer_names()) {
+        available.insert(name);
+    }
+    for (const Message &node : p_model.nodes) {
+        for (const std::string &input : node_inputs(node)) {
+            if (!input.empty() && !available.count(input)) {
+                return false;
+            }
+        }
+        for (const std::string &output : node_outputs(node)) {
+            available.insert(output);
+        }
+    }
+    for (const std::string &name : p_model.output_names()) {
+        if (!available.count(name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool fuse_causal_conv1d(Model &p_model, int &r_fused, std::string &r_error) {
+    r_fused = 0;
+
+    // Rewrite a copy so a half-matched graph never leaks out
+    Model model = p_model;
+    std::set<std::string> zero_biases;
+    for (size_t i = 0; i < model.nodes.size(); i++) {
+        const Message conv = model.nodes[i];
+        std::vector<std::string> inputs = node_inputs(conv);
+        if (node_op_type(conv) != "Conv" || inputs.size() < 2) {
+            continue;
+        }
+        bool found;
+        std::vector<int64_t> w_dims = model.initializer_dims(inputs[1], found);
+        if (!found || w_dims.size() != 3 || node_attribute_int(conv, "group", 1) != 1) {
+            continue;
+        }
+        std::vector<int64_t> strides = node_attribute_ints(conv, "strides");
+        std::vector<int64_t> dilations = node_attribute_ints(conv, "dilations");
+        std::vector<int64_t> pads = node_attribute_ints(conv, "pads");
+        int64_t kernel = w_dims[2];
+        int64_t dilation = dilations.empty() ? 1 : dilations[0];
+        int64_t pad = (kernel - 1) * dilation;
+        if (!(strides.empty() || strides == std::vector<int64_t>{ 1 })) {
+            continue;
+        }
+        if (pads.empty()) {
+            pads = { 0, 0 };
+        }
+        bool symmetric = pads == std::vector<int64_t>{ pad, pad };
+        bool left_only = pads == std::vector<int64_t>{ pad, 0 };
+        if (!symmetric && !left_only) {
+            continue;
+        }
+
+        // Causal conv output: either the conv itself or its chomp
+        int last = (int)i;
+        std::string tensor = node_outputs(conv)[0];
+        if (pad > 0 && symmetric) {
+            std::vector<int> consumers = _consumers(model, tensor);
+            if (consumers.size() != 1 || !_is_chomp(model, model.nodes[consumers[0]], pad)) {
+                continue;
+            }
+            last = consumers[0];
+            tensor = node_outputs(model.nodes[last])[0];
+        }
+        const std::string conv_output = tensor;
+
+        // Shape nodes only measure the tensor for the crops below
+        auto real_consumers = [&model](const std::string &p_tensor) {
+            std::vector<int> result;
+            for (int index : _consumers(model, p_tensor)) {
+                if (node_op_type(model.nodes[index]) != "Shape") {
+                    result.push_back(index);
+                }
+            }
+            return result;
+        };
+
+        // Optional residual: Add(x[:, :, :T], residual[:, :, :T])
+        std::string residual;
+        std::vector<int> consumers = real_consumers(tensor);
+        if (consumers.size() == 1 && _crop_to_length_of(model, model.nodes[consumers[0]]) == conv_output &&
+                node_inputs(model.nodes[consumers[0]])[0] == conv_output) {
+            tensor = node_outputs(model.nodes[consumers[0]])[0];
+            consumers = real_consumers(tensor);
+        }
+        if (consumers.size() == 1 && node_op_type(model.nodes[consumers[0]]) == "Add") {
+            std::vector<std::string> add_inputs = node_inputs(model.nodes[consumers[0]]);
+            std::string other = add_inputs[0] == tensor ? add_inputs[1] : add_inputs[0];
+            int crop = model.find_producer(other);
+            if (crop >= 0 && _crop_to_length_of(model, model.nodes[crop]) == conv_output) {
+                other = node_inputs(model.nodes[crop])[0];
+            }
+            bool is_initializer;
+            model.initializer_dims(other, is_initializer);
+            if (add_inputs.size() == 2 && add_inputs[0] != add_inputs[1] && !is_initializer) {
+                residual = other;
+                last = consumers[0];
+                tensor = node_outputs(model.nodes[last])[0];
+                consumers = real_consumers(tensor);
+            }
+        }
+        int64_t activation = 0;
+        if (consumers.size() == 1 && node_op_type(model.nodes[consumers[0]]) == "Relu" &&
+                model.count_consumers(tensor) == 1) {
+            activation = 1;
+            last = consumers[0];
+            tensor = node_outputs(model.nodes[last])[0];
+        }
+
+        std::string bias = inputs.size() > 2 ? inputs[2] : std::string();
+        if (bias.empty()) {
+            bias = inputs[1] + "_openlipsync_zero_bias";
+            if (!zero_biases.count(bias)) {
+                model.add_initializer(make_float_tensor(bias, { w_dims[0] }, std::vector<float>((size_t)w_dims[0], 0.0f)));
+                zero_biases.insert(bias);
+            }
+        }
+        std::vector<std::string> fused_inputs = { inputs[0], inputs[1], bias };
+        if (!residual.empty()) {
+            fused_inputs.push_back(residual);
+        }
+        Message fused = make_node("FusedCausalConv1d", node_name(conv), fused_inputs, { tensor }, CUSTOM_OP_DOMAIN);
+        add_attribute_int(fused, "dilation", dilation);
+        add_attribute_int(fused, "activation", activation);
+
+        // The fused node takes the place of the last node it covers, where all of
+        // its inputs already exist. The rest becomes dead and is dropped below.
+        model.nodes[last] = fused;
+        r_fused++;
+    }
+
+    if (r_fused == 0) {
+        r_error = "No causal Conv1d found";
+        return false;
+    }
+    model.remove_dead_nodes();
+    if (!_graph_is_closed(model)) {
+        r_fused = 0;
+        r_error = "Fused graph would use tensors that no longer exist";
+        return false;
+    }
+    model.set_opset(CUSTOM_OP_DOMAIN, 1);
+    p_model = std::move(model);
+    return true;
+}
+
+int64_t receptive_field(const Model &p_model) {
+    int64_t field = 1;
+    for (const Message &node : p_model.nodes) {
+        std::string op = node_op_type(node);
+        std::vector<std::string> inputs = node_inputs(node);
+        if ((op != "Conv" && op != "FusedCausalConv1d") || inputs.size() < 2) {
+            continue;
+        }
+        bool found;
+        std::vector<int64_t> w_dims = p_model.initializer_dims(inputs[1], found);
+        if (!found || w_dims.size() != 3) {
+            continue;
+        }
+        int64_t dilation = 1;
+        if (op == "Conv") {
+            std::vector<int64_t> dilations = node_attribute_ints(node, "dilations");
+            dilation = dilations.empty() ? 1 : dilations[0];
+        } else {
+            dilation = node_attribute_int(node, "dilation", 1);
+        }
+        field += (w_dims[2] - 1) * dilation;
+    }
+    return field;
+}
+
+bool prepend_log_mel_features(Model &p_model, const mel_frontend::Config &p_config, const std::string &p_pcm_name, std::string &r_error) {
+    std::vector<std::string> initializers = p_model.initializer_names();
+    std::vector<std::string> inputs;
+    for (const std::string &name : p_model.input_names()) {
+        // Older exporters also list initializers as inputs
+        if (std::find(initializers.begin(), initializers.end(), name) == initializers.end()) {
+            inputs.push_back(name);
+        }
+    }
+    if (inputs.size() != 1) {
+        r_error = "Expected a single feature input";
+        return false;
+    }
+    if (p_model.find_producer(p_pcm_name) >= 0 || p_model.count_consumers(p_pcm_name) > 0) {
+        r_error = "PCM input name is already used by the graph";
+        return false;
+    }
+
+    // The old input becomes the op's output, so every consumer stays as is
+    const std::string features = inputs[0];
+    Message node = make_node("LogMelFeatures", "openlipsync_log_mel", { p_pcm_name }, { features }, CUSTOM_OP_DOMAIN);
+    add_attribute_int(node, "sample_rate", p_config.sample_rate);
+    add_attribute_int(node, "hop_length", p_config.hop_length);
+    add_attribute_int(node, "window_length", p_config.window_length);
+    add_attribute_int(node, "n_fft", p_config.n_fft);
+    add_attribute_int(node, "n_mels", p_config.n_mels);
+    add_attribute_float(node, "f_min", p_config.f_min);
+    add_attribute_float(node, "f_max", p_config.f_max);
+
+    p_model.replace_input(features, make_float_value_info(p_pcm_name, { "1", "samples" }));
+    p_model.nodes.insert(p_model.nodes.begin(), node);
+    p_model.set_opset(CUSTOM_OP_DOMAIN, 1);
+    return true;
+}
+
+// Swaps the first dim of a serialized ValueInfoProto for a symbolic one
+static bool _set_leading_dim(std::string &r_info, const std::string &p_param) {
+    Message info;
+    if (!info.parse(r_info)) {
+        return false;
+    }
+    for (Field &type_field : info.fields) {
+        if (type_field.number != VALUE_INFO_TYPE) {
+            continue;
+        }
+        Message type;
+        if (!type.parse(type_field.bytes)) {
+            return false;
+        }
+        for (Field &tensor_field : type.fields) {
+            if (tensor_field.number != TYPE_TENSOR) {
+                continue;
+            }
+            Message tensor;
+            if (!tensor.parse(tensor_field.bytes)) {
+                return false;
+            }
+            for (Field &shape_field : tensor.fields) {
+                if (shape_field.number != TYPE_TENSOR_SHAPE) {
+                    continue;
+                }
+                Message shape;
+                if (!shape.parse(shape_field.bytes)) {
+                    return false;
+                }
+                for (Field &dim_field : shape.fields) {
+                    if (dim_field.number != SHAPE_DIM) {
+                        continue;
+                    }
+                    Message dim;
+                    dim.add_bytes(DIM_PARAM, p_param);
+                    dim_field.bytes = dim.serialize();
+                    shape_field.bytes = shape.serialize();
+                    tensor_field.bytes = tensor.serialize();
+                    type_field.bytes = type.serialize();
+                    r_info = info.serialize();
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool make_batch_dynamic(Model &p_model, std::string &r_error) {
+    std::vector<std::string> fixed = p_model.initializer_names();
+    Message graph = p_model.graph;
+    for (Field &field : graph.fields) {
+        if (field.number != GRAPH_INPUT && field.number != GRAPH_OUTPUT) {
+            continue;
+        }
+        Message info;
+        if (!info.parse(field.bytes)) {
+            r_error = "Malformed graph input or output";
+            return false;
+        }
+        // Older exporters list initializers as inputs too; those keep their shape
+        if (std::find(fixed.begin(), fixed.end(), info.get_string(VALUE_INFO_NAME)) != fixed.end()) {
+            continue;
+        }
+        if (!_set_leading_dim(field.bytes, "batch")) {
+            r_error = "Graph input or output " + info.get_string(VALUE_INFO_NAME) + " has no shape";
+            return false;
+        }
+    }
+    p_model.graph = graph;
+    return true;
+}
+
+} // namespace onnx_graph
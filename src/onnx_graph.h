@@ -0,0 +1,128 @@
+#ifndef ONNX_GRAPH_H
+#define ONNX_GRAPH_H
+
+// Minimal in-memory ONNX model editing, used to rewrite the graph at load time
+// before handing the bytes to ORT. Works directly on the protobuf wire format so
+// we don't need to link libprotobuf. Has no Godot dependencies.
+
+#include "mel_frontend.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace onnx_graph {
+
+// Domain of the custom ops the rewrites below emit (implemented in custom_ops.cpp)
+static const char CUSTOM_OP_DOMAIN[] = "ai.openlipsync";
+
+// A protobuf message kept as an ordered list of raw fields. Unknown fields are
+// preserved untouched, so a parse/serialize round trip is lossless.
+struct Field {
+    uint32_t number = 0;
+    uint32_t wire_type = 0;
+    uint64_t value = 0; // Varint and fixed32/fixed64 payloads
+    std::string bytes;  // Length-delimited payload
+};
+
+struct Message {
+    std::vector<Field> fields;
+
+    bool parse(const uint8_t *p_data, size_t p_size);
+    bool parse(const std::string &p_data) { return parse((const uint8_t *)p_data.data(), p_data.size()); }
+    std::string serialize() const;
+
+    const Field *find(uint32_t p_number) const;
+    std::string get_string(uint32_t p_number) const;
+    std::vector<std::string> get_strings(uint32_t p_number) const;
+    int64_t get_int(uint32_t p_number, int64_t p_default = 0) const;
+    std::vector<int64_t> get_ints(uint32_t p_number) const; // Packed or unpacked
+
+    void add_varint(uint32_t p_number, uint64_t p_value);
+    void add_fixed32(uint32_t p_number, uint32_t p_value);
+    void add_bytes(uint32_t p_number, const std::string &p_bytes);
+    void add_message(uint32_t p_number, const Message &p_message) { add_bytes(p_number, p_message.serialize()); }
+    void remove(uint32_t p_number);
+};
+
+// Node helpers (NodeProto)
+std::string node_op_type(const Message &p_node);
+std::string node_name(const Message &p_node);
+std::vector<std::string> node_inputs(const Message &p_node);
+std::vector<std::string> node_outputs(const Message &p_node);
+void set_node_input(Message &p_node, int p_index, const std::string &p_name);
+void set_node_output(Message &p_node, int p_index, const std::string &p_name);
+int64_t node_attribute_int(const Message &p_node, const std::string &p_name, int64_t p_default);
+std::vector<int64_t> node_attribute_ints(const Message &p_node, const std::string &p_name);
+
+Message make_node(const std::string &p_op_type, const std::string &p_name, const std::vector<std::string> &p_inputs, const std::vector<std::string> &p_outputs, const std::string &p_domain = "");
+void add_attribute_int(Message &p_node, const std::string &p_name, int64_t p_value);
+void add_attribute_float(Message &p_node, const std::string &p_name, float p_value);
+void add_attribute_ints(Message &p_node, const std::string &p_name, const std::vector<int64_t> &p_values);
+void add_attribute_string(Message &p_node, const std::string &p_name, const std::string &p_value);
+
+Message make_int64_tensor(const std::string &p_name, const std::vector<int64_t> &p_dims, const std::vector<int64_t> &p_values);
+Message make_float_tensor(const std::string &p_name, const std::vector<int64_t> &p_dims, const std::vector<float> &p_values);
+// ValueInfoProto for a float tensor. Numeric dims are fixed, others are symbolic.
+Message make_float_value_info(const std::string &p_name, const std::vector<std::string> &p_dims);
+
+// ModelProto with its main graph unpacked for editing
+class Model {
+public:
+    Message model;
+    Message graph;              // GraphProto without its nodes
+    std::vector<Message> nodes; // GraphProto.node, in topological order
+
+    bool load(const uint8_t *p_data, size_t p_size, std::string &r_error);
+    std::string save() const;
+
+    int64_t get_opset(const std::string &p_domain = "") const;
+    void set_opset(const std::string &p_domain, int64_t p_version);
+
+    std::vector<std::string> input_names() const;
+    std::vector<std::string> output_names() const;
+    std::vector<std::string> initializer_names() const;
+    // Dims of an initializer, or empty with r_found=false if there is none
+    std::vector<int64_t> initializer_dims(const std::string &p_name, bool &r_found) const;
+    void add_initializer(const Message &p_tensor) { graph.add_message(5, p_tensor); }
+    // Swaps the ValueInfoProto of graph input p_name, false if there is none
+    bool replace_input(const std::string &p_name, const Message &p_value_info);
+
+    int find_producer(const std::string &p_tensor) const;
+    int count_consumers(const std::string &p_tensor) const;
+    // Values of an int64 tensor that is an initializer or a Constant node output
+    bool get_constant_ints(const std::string &p_tensor, std::vector<int64_t> &r_values) const;
+    // Drops nodes whose outputs are neither consumed nor graph outputs
+    int remove_dead_nodes();
+};
+
+// Hoists a Slice that keeps only the last time step (axis 1) above the
+// per-time-step tail of the graph (output MatMul/bias/activation), so those
+// ops run for a single frame and the output becomes [1, 1, C].
+bool slice_output_to_last_step(Model &p_model, std::string &r_error);
+
+// Replaces each causal dilated Conv1d (symmetric pads + chomp Slice, or left
+// pads only) and the bias, residual Add and Relu that follow it with a single
+// FusedCausalConv1d node. r_fused is the number of convs replaced; the model is
+// left untouched if the result would not be a valid graph.
+bool fuse_causal_conv1d(Model &p_model, int &r_fused, std::string &r_error);
+
+// Frames of input history a single output frame can depend on, from the
+// kernel sizes and dilations of its Conv and FusedCausalConv1d nodes. Summed
+// over every conv, so an upper bound when convs sit on parallel branches;
+// 1x1 residual projections add nothing.
+int64_t receptive_field(const Model &p_model);
+
+// Makes the model take raw PCM [1, samples] as p_pcm_name and compute its
+// old feature input in-graph with a LogMelFeatures node (see mel_frontend.h),
+// so audio to visemes is a single Session::Run.
+bool prepend_log_mel_features(Model &p_model, const mel_frontend::Config &p_config, const std::string &p_pcm_name, std::string &r_error);
+
+// Makes the first (batch) dim of every graph input and output symbolic, so
+// several windows of the same length run as one [B, T, C] call. Only declares
+// the shapes; reshapes that bake in a batch of 1 still fail at run time.
+bool make_batch_dynamic(Model &p_model, std::string &r_error);
+
+} // namespace onnx_graph
+
+#endif
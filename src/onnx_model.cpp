@@ -1,127 +1,584 @@
 #include "onnx_model.h"
+#include "custom_ops.h"
+#include "half_float.h"
+#include "onnx_graph.h"
 #include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/json.hpp>
 #include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/variant/array.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
 #include <vector>
 
 using namespace godot;
 
+static uint64_t _ticks_usec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 OnnxModel::OnnxModel() : env(ORT_LOGGING_LEVEL_WARNING, "GodotOnnx") {
 }
 
 OnnxModel::~OnnxModel() {
+    _join_warmup();
     if (session) {
         delete session;
     }
 }
 
 bool OnnxModel::load_model(const String &p_path) {
+    // A worker may still be warming up the previous session
+    _join_warmup();
+
     if (session) {
         delete session;
         session = nullptr;
     }
+    warm = false;
+    profiling_active = false;
+    last_frame_output = false;
+    fused_conv_count = 0;
+    pcm_input_active = false;
+    receptive_field = 0;
+    output_channels = 0;
+    input_half = false;
+    output_half = false;
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        load_usec = 0;
+        warmup_usec = 0;
+        warmup_first_run_usec = 0;
+        first_inference_usec = 0;
+        last_inference_usec = 0;
+        steady_inference_usec = 0.0;
+        inference_count = 0;
+    }
+
+    uint64_t start = _ticks_usec();
+
+    // Load through FileAccess so res:// paths inside exported packs work too,
+    // and so the graph can be rewritten in memory before ORT sees it.
+    PackedByteArray file_bytes = FileAccess::get_file_as_bytes(p_path);
+    if (file_bytes.is_empty()) {
+        UtilityFunctions::printerr("ONNX Runtime Error: Could not read model file ", p_path);
+        return false;
+    }
+    const uint8_t *model_data = file_bytes.ptr();
+    size_t model_size = file_bytes.size();
+
+    std::string rewritten;
+    onnx_graph::Model graph;
+    std::string error;
+    bool changed = false;
+    if (!graph.load(model_data, model_size, error)) {
+        UtilityFunctions::printerr("OnnxModel: Keeping the original graph, could not parse it: ", error.c_str());
+    } else {
+        receptive_field = onnx_graph::receptive_field(graph);
+        if (last_frame_only) {
+            if (onnx_graph::slice_output_to_last_step(graph, error)) {
+                last_frame_output = true;
+                changed = true;
+            } else {
+                UtilityFunctions::printerr("OnnxModel: Keeping full output, graph rewrite failed: ", error.c_str());
+            }
+        }
+        if (fused_conv) {
+            if (onnx_graph::fuse_causal_conv1d(graph, fused_conv_count, error)) {
+                changed = true;
+            } else {
+                UtilityFunctions::printerr("OnnxModel: Keeping stock Conv nodes, fusion failed: ", error.c_str());
+            }
+        }
+        if (pcm_input) {
+            mel_frontend::Config config;
+            if (onnx_graph::prepend_log_mel_features(graph, config, "pcm", error)) {
+                pcm_input_active = true;
+                pcm_hop_length = config.hop_length;
+                changed = true;
+            } else {
+                UtilityFunctions::printerr("OnnxModel: Keeping feature input, could not add the mel frontend: ", error.c_str());
+            }
+        }
+    }
+    if (changed) {
+        rewritten = graph.save();
+        model_data = (const uint8_t *)rewritten.data();
+        model_size = rewritten.size();
+    }
 
     try {
         Ort::SessionOptions session_options;
         session_options.SetIntraOpNumThreads(1);
         session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_BASIC);
+        // Always registered, so models saved with the fused ops load as well
+        custom_ops::add_to_session_options(session_options);
+        if (profiling_enabled) {
+            String prefix = ProjectSettings::get_singleton()->globalize_path(profile_prefix);
+#ifdef _WIN32
+            session_options.EnableProfiling(prefix.wide_string().get_data());
+#else
+            session_options.EnableProfiling(prefix.utf8().get_data());
+#endif
+        }
 
-        String global_path = ProjectSettings::get_singleton()->globalize_path(p_path);
-        session = new Ort::Session(env, global_path.utf8().get_data(), session_options);
-        return true;
+        session = new Ort::Session(env, model_data, model_size, session_options);
+        profiling_active = profiling_enabled;
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        input_name = session->GetInputNameAllocated(0, allocator).get();
+        output_name = session->GetOutputNameAllocated(0, allocator).get();
+        Ort::TypeInfo input_info = session->GetInputTypeInfo(0);
+        Ort::TypeInfo output_info = session->GetOutputTypeInfo(0);
+        input_shape = input_info.GetTensorTypeAndShapeInfo().GetShape();
+        input_half = input_info.GetTensorTypeAndShapeInfo().GetElementType() == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+        output_half = output_info.GetTensorTypeAndShapeInfo().GetElementType() == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+        std::vector<int64_t> output_shape = output_info.GetTensorTypeAndShapeInfo().GetShape();
+        if (!output_shape.empty() && output_shape.back() > 0) {
+            output_channels = output_shape.back();
+        }
     } catch (const Ort::Exception &e) {
         UtilityFunctions::printerr("ONNX Runtime Error: ", e.what());
+        if (session) {
+            delete session;
+            session = nullptr;
+        }
         return false;
     }
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        load_usec = _ticks_usec() - start;
+    }
+
+    if (warmup_runs > 0) {
+        if (warmup_on_worker) {
+            warmup_thread = std::thread(&OnnxModel::_run_warmup, this);
+        } else {
+            _run_warmup();
+        }
+    } else {
+        warm = true;
+    }
+
+    return true;
+}
+
+void OnnxModel::set_warmup_runs(int p_runs) {
+    warmup_runs = p_runs < 0 ? 0 : p_runs;
+}
+
+void OnnxModel::set_warmup_frames(int p_frames) {
+    warmup_frames = p_frames < 1 ? 1 : p_frames;
+}
+
+void OnnxModel::warmup() {
+    _join_warmup();
+    if (!session) {
+        UtilityFunctions::printerr("Model not loaded.");
+        return;
+    }
+    _run_warmup();
+}
+
+void OnnxModel::_run_warmup() {
+    // Dummy input at the configured context size so the shapes planned here are
+    // the ones real calls will hit.
+    int64_t frame_size = 1;
+    bool has_dynamic_dim = false;
+    for (int64_t dim : input_shape) {
+        if (dim > 0) {
+            frame_size *= dim;
+        } else {
+            has_dynamic_dim = true;
+        }
+    }
+    if (pcm_input_active) {
+        // One hop of samples per feature frame
+        frame_size *= pcm_hop_length;
+    }
+    std::vector<float> dummy((size_t)(has_dynamic_dim ? warmup_frames * frame_size : frame_size), 0.0f);
+    PackedFloat32Array output;
+
+    uint64_t start = _ticks_usec();
+    for (int i = 0; i < warmup_runs; i++) {
+        uint64_t run_start = _ticks_usec();
+        if (!_run(dummy.data(), false, dummy.size(), output)) {
+            break;
+        }
+        if (i == 0) {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            warmup_first_run_usec = _ticks_usec() - run_start;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        warmup_usec = _ticks_usec() - start;
+    }
+    warm = true;
+}
+
+void OnnxModel::_join_warmup() {
+    if (warmup_thread.joinable()) {
+        warmup_thread.join();
+    }
+}
+
+void OnnxModel::_record_inference(uint64_t p_usec) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    last_inference_usec = p_usec;
+    if (inference_count == 0) {
+        first_inference_usec = p_usec;
+    } else {
+        // Running mean over the calls after the first one
+        steady_inference_usec += ((double)p_usec - steady_inference_usec) / (double)inference_count;
+    }
+    inference_count++;
 }
 
 PackedFloat32Array OnnxModel::run_inference(const PackedFloat32Array &p_input) {
+    return run_inference_raw(p_input.ptr(), false, p_input.size());
+}
+
+PackedFloat32Array OnnxModel::run_inference_raw(const void *p_input, bool p_half, size_t p_count) {
     if (!session) {
         UtilityFunctions::printerr("Model not loaded.");
         return PackedFloat32Array();
     }
 
+    PackedFloat32Array result;
+    uint64_t start = _ticks_usec();
+    if (!_run(p_input, p_half, p_count, result)) {
+        return PackedFloat32Array();
+    }
+    _record_inference(_ticks_usec() - start);
+    return result;
+}
+
+PackedFloat32Array OnnxModel::run_offline(const PackedFloat32Array &p_features, int p_context_frames, int p_threads) {
+    if (!session) {
+        UtilityFunctions::printerr("Model not loaded.");
+        return PackedFloat32Array();
+    }
+    if (pcm_input_active || output_channels <= 0 || input_shape.empty() || input_shape.back() <= 0) {
+        UtilityFunctions::printerr("OnnxModel: Offline inference needs a [1, T, C] feature input and a fixed viseme count.");
+        return PackedFloat32Array();
+    }
+    const int64_t channels = input_shape.back();
+    const int64_t visemes = output_channels;
+    const int64_t frames = p_features.size() / channels;
+    const int64_t context = p_context_frames > 0 ? p_context_frames : frames;
+    PackedFloat32Array result;
+    result.resize(frames * visemes);
+    if (frames == 0) {
+        return result;
+    }
+    const float *features = p_features.ptr();
+    float *out = result.ptrw();
+
+    // Streaming frame t sees the window [t - context + 1, t]. When the receptive
+    // field fits in that window, the window start never reaches the output, so
+    // frame t equals frame t of a run over the whole clip. The clip is then cut
+    // into chunks, each run with receptive_field - 1 frames of left overlap that
+    // are dropped from its output. Otherwise every frame needs its own window,
+    // exactly as streaming computes it.
+    struct Job {
+        int64_t first; // First frame whose output the job writes
+        int64_t count;
+    };
+    std::vector<Job> jobs;
+    const bool chunked = !last_frame_output && receptive_field > 0 && receptive_field <= context;
+    unsigned threads = p_threads > 0 ? (unsigned)p_threads : std::max(1u, std::thread::hardware_concurrency());
+    if (chunked) {
+        // A few chunks per thread to balance load, but long enough that the
+        // overlap stays a small share of the work
+        int64_t chunk = std::max<int64_t>((frames + threads * 4 - 1) / (threads * 4), 4 * receptive_field);
+        for (int64_t first = 0; first < frames; first += chunk) {
+            jobs.push_back({ first, std::min(chunk, frames - first) });
+        }
+    } else {
+        for (int64_t t = 0; t < frames; t++) {
+            jobs.push_back({ t, 1 });
+        }
+    }
+    threads = (unsigned)std::min<size_t>(threads, jobs.size());
+
+    // Session::Run is safe to call concurrently; each call uses one core (intra-op threads = 1)
+    std::atomic<size_t> next_job{0};
+    std::atomic<bool> failed{false};
+    auto worker = [&]() {
+        PackedFloat32Array output;
+        for (size_t j = next_job++; j < jobs.size() && !failed.load(); j = next_job++) {
+            const Job &job = jobs[j];
+            int64_t last = job.first + job.count - 1;
+            int64_t start = chunked ? std::max<int64_t>(0, job.first - (receptive_field - 1)) : std::max<int64_t>(0, last - context + 1);
+            int64_t length = last - start + 1;
+            if (!_run(features + start * channels, false, (size_t)(length * channels), output)) {
+                failed = true;
+                return;
+            }
+            // Full output [1, length, V] or last step only [1, 1, V]; the rows we
+            // want are the trailing job.count ones either way
+            if (output.size() < job.count * visemes) {
+                failed = true;
+                return;
+            }
+            const float *src = output.ptr() + output.size() - job.count * visemes;
+            memcpy(out + job.first * visemes, src, (size_t)(job.count * visemes) * sizeof(float));
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+
+    if (failed.load()) {
+        return PackedFloat32Array();
+    }
+    return result;
+}
+
+bool OnnxModel::_run(const void *p_data, bool p_half, size_t p_count, PackedFloat32Array &r_output) {
     try {
-        Ort::AllocatorWithDefaultOptions allocator;
+        const char* input_names[] = { input_name.c_str() };
+        const char* output_names[] = { output_name.c_str() };
 
-        auto input_name_ptr = session->GetInputNameAllocated(0, allocator);
-        const char* input_names[] = { input_name_ptr.get() };
-        
-        auto type_info = session->GetInputTypeInfo(0);
-        auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
-        auto input_shape = tensor_info.GetShape();
-        
         // Resolve dynamic shapes
         // Expected shape usually: [Batch, Time, Channels] or [Batch, Channels, Time]
         // OpenLipSync TCN export: [Batch=1, Time=Dynamic, Channels=80]
-        
+        std::vector<int64_t> shape = input_shape;
+
         int64_t known_size = 1;
         int dynamic_dim_index = -1;
         
-        for (size_t i = 0; i < input_shape.size(); i++) {
-            if (input_shape[i] < 0) {
+        for (size_t i = 0; i < shape.size(); i++) {
+            if (shape[i] < 0) {
                 if (dynamic_dim_index != -1) {
                     // More than one dynamic dimension? Default others to 1 to be safe, 
                     // but usually only Time is dynamic for us.
-                    input_shape[i] = 1; 
+                    shape[i] = 1; 
                 } else {
                     dynamic_dim_index = i;
                 }
             } else {
-                known_size *= input_shape[i];
+                known_size *= shape[i];
             }
         }
         
         if (dynamic_dim_index != -1) {
             // Calculate missing dimension
-            if (p_input.size() % known_size != 0) {
-                 UtilityFunctions::printerr("Input size ", p_input.size(), " not divisible by known dimensions size ", known_size);
-                 return PackedFloat32Array();
+            if (p_count % known_size != 0) {
+                 UtilityFunctions::printerr("Input size ", (int64_t)p_count, " not divisible by known dimensions size ", known_size);
+                 return false;
             }
-            input_shape[dynamic_dim_index] = p_input.size() / known_size;
+            shape[dynamic_dim_index] = p_count / known_size;
         } else {
             // No dynamic dims, strict check
-            if (p_input.size() != known_size) {
-                UtilityFunctions::printerr("Input size mismatch. Expected ", known_size, ", got ", p_input.size());
-                return PackedFloat32Array();
+            if ((int64_t)p_count != known_size) {
+                UtilityFunctions::printerr("Input size mismatch. Expected ", known_size, ", got ", (int64_t)p_count);
+                return false;
             }
         }
 
         auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-        
-        // Data copy (PackedFloat32Array to std::vector<float>)
-        std::vector<float> input_tensor_values(p_input.size());
-        const float* src = p_input.ptr();
-        for(int i=0; i<p_input.size(); i++) {
-            input_tensor_values[i] = src[i];
-        }
-        
-        Ort::Value input_tensor = Ort::Value::CreateTensor<float>(memory_info, input_tensor_values.data(), input_tensor_values.size(), input_shape.data(), input_shape.size());
 
-        auto output_name_ptr = session->GetOutputNameAllocated(0, allocator);
-        const char* output_names[] = { output_name_ptr.get() };
+        // ORT never writes to inputs, so the tensor wraps the caller's buffer.
+        // Only a precision mismatch with the model goes through a scratch copy.
+        thread_local std::vector<float> float_scratch;
+        thread_local std::vector<uint16_t> half_scratch;
+        Ort::Value input_tensor{ nullptr };
+        if (input_half) {
+            const uint16_t *half_data = (const uint16_t *)p_data;
+            if (!p_half) {
+                half_scratch.resize(p_count);
+                half_float::encode((const float *)p_data, half_scratch.data(), (int64_t)p_count);
+                half_data = half_scratch.data();
+            }
+            input_tensor = Ort::Value::CreateTensor<Ort::Float16_t>(memory_info, (Ort::Float16_t *)half_data, p_count, shape.data(), shape.size());
+        } else {
+            const float *float_data = (const float *)p_data;
+            if (p_half) {
+                float_scratch.resize(p_count);
+                half_float::decode((const uint16_t *)p_data, float_scratch.data(), (int64_t)p_count);
+                float_data = float_scratch.data();
+            }
+            input_tensor = Ort::Value::CreateTensor<float>(memory_info, (float *)float_data, p_count, shape.data(), shape.size());
+        }
 
         auto output_tensors = session->Run(Ort::RunOptions{nullptr}, input_names, &input_tensor, 1, output_names, 1);
         
-        float* floatarr = output_tensors[0].GetTensorMutableData<float>();
         size_t output_count = output_tensors[0].GetTensorTypeAndShapeInfo().GetElementCount();
-        
-        PackedFloat32Array result;
-        result.resize(output_count);
-        float* dst = result.ptrw();
-        for (size_t i = 0; i < output_count; i++) {
-            dst[i] = floatarr[i];
+        r_output.resize(output_count);
+        if (output_half) {
+            half_float::decode((const uint16_t *)output_tensors[0].GetTensorData<Ort::Float16_t>(), r_output.ptrw(), (int64_t)output_count);
+        } else {
+            memcpy(r_output.ptrw(), output_tensors[0].GetTensorData<float>(), output_count * sizeof(float));
         }
         
-        return result;
+        return true;
 
     } catch (const Ort::Exception &e) {
         UtilityFunctions::printerr("Inference Error: ", e.what());
-        return PackedFloat32Array();
+        return false;
+    }
+}
+
+struct ProfileEntry {
+    String op;
+    int64_t count = 0;
+    int64_t total_usec = 0;
+};
+
+static Array _profile_table(const std::map<String, ProfileEntry> &p_entries, int64_t p_total_usec, const char *p_key) {
+    std::vector<std::pair<String, ProfileEntry>> sorted(p_entries.begin(), p_entries.end());
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<String, ProfileEntry> &a, const std::pair<String, ProfileEntry> &b) {
+        return a.second.total_usec > b.second.total_usec;
+    });
+
+    Array table;
+    for (const std::pair<String, ProfileEntry> &entry : sorted) {
+        Dictionary row;
+        row[p_key] = entry.first;
+        row["op"] = entry.second.op;
+        row["count"] = entry.second.count;
+        row["total_usec"] = entry.second.total_usec;
+        row["avg_usec"] = entry.second.count > 0 ? (double)entry.second.total_usec / entry.second.count : 0.0;
+        row["percent"] = p_total_usec > 0 ? 100.0 * entry.second.total_usec / p_total_usec : 0.0;
+        table.push_back(row);
+    }
+    return table;
+}
+
+Dictionary OnnxModel::end_profiling() {
+    Dictionary report;
+    if (!session || !profiling_active) {
+        UtilityFunctions::printerr("OnnxModel: Profiling is not active. Enable it before load_model.");
+        return report;
+    }
+    _join_warmup();
+
+    String file;
+    try {
+        Ort::AllocatorWithDefaultOptions allocator;
+        file = String::utf8(session->EndProfilingAllocated(allocator).get());
+    } catch (const Ort::Exception &e) {
+        UtilityFunctions::printerr("ONNX Runtime Error: ", e.what());
+        return report;
     }
+    profiling_active = false;
+
+    // ORT writes a Chrome trace: an array of events. Per-kernel events have
+    // cat "Node", a name ending in "_kernel_time" and the op type in args.
+    Variant parsed = JSON::parse_string(FileAccess::get_file_as_string(file));
+    if (parsed.get_type() != Variant::ARRAY) {
+        UtilityFunctions::printerr("OnnxModel: Could not parse profile ", file);
+        return report;
+    }
+    Array events = parsed;
+
+    std::map<String, ProfileEntry> ops;
+    std::map<String, ProfileEntry> nodes;
+    int64_t total_usec = 0;
+    int64_t runs = 0;
+    const String kernel_suffix = "_kernel_time";
+
+    for (int64_t i = 0; i < events.size(); i++) {
+        if (events[i].get_type() != Variant::DICTIONARY) {
+            continue;
+        }
+        Dictionary event = events[i];
+        String category = event.get("cat", "");
+        String name = event.get("name", "");
+        if (category == "Session" && name == "model_run") {
+            runs++;
+            continue;
+        }
+        if (category != "Node" || !name.ends_with(kernel_suffix)) {
+            continue;
+        }
+        Dictionary args = event.get("args", Dictionary());
+        String op = args.get("op_name", "");
+        String node = name.trim_suffix(kernel_suffix);
+        int64_t dur = event.get("dur", 0);
+
+        ProfileEntry &op_entry = ops[op];
+        op_entry.op = op;
+        op_entry.count++;
+        op_entry.total_usec += dur;
+
+        ProfileEntry &node_entry = nodes[node];
+        node_entry.op = op;
+        node_entry.count++;
+        node_entry.total_usec += dur;
+
+        total_usec += dur;
+    }
+
+    report["file"] = file;
+    report["runs"] = runs;
+    report["total_usec"] = total_usec;
+    report["ops"] = _profile_table(ops, total_usec, "op");
+    report["nodes"] = _profile_table(nodes, total_usec, "node");
+    return report;
+}
+
+Dictionary OnnxModel::get_inference_stats() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    Dictionary stats;
+    stats["load_usec"] = (int64_t)load_usec;
+    stats["warmup_runs"] = warmup_runs;
+    stats["warmup_frames"] = warmup_frames;
+    stats["warmup_usec"] = (int64_t)warmup_usec;
+    stats["warmup_first_run_usec"] = (int64_t)warmup_first_run_usec;
+    stats["warm"] = warm.load();
+    stats["inference_count"] = (int64_t)inference_count;
+    stats["first_inference_usec"] = (int64_t)first_inference_usec;
+    stats["last_inference_usec"] = (int64_t)last_inference_usec;
+    stats["steady_inference_usec"] = steady_inference_usec;
+    // ~1.0 means the first real call costs the same as steady state
+    stats["first_to_steady_ratio"] = steady_inference_usec > 0.0 ? (double)first_inference_usec / steady_inference_usec : 0.0;
+    return stats;
 }
 
 void OnnxModel::_bind_methods() {
     ClassDB::bind_method(D_METHOD("load_model", "path"), &OnnxModel::load_model);
     ClassDB::bind_method(D_METHOD("run_inference", "input"), &OnnxModel::run_inference);
+    ClassDB::bind_method(D_METHOD("run_offline", "features", "context_frames", "threads"), &OnnxModel::run_offline, DEFVAL(0));
+    ClassDB::bind_method(D_METHOD("get_receptive_field"), &OnnxModel::get_receptive_field);
+
+    ClassDB::bind_method(D_METHOD("set_last_frame_only", "enabled"), &OnnxModel::set_last_frame_only);
+    ClassDB::bind_method(D_METHOD("is_last_frame_only"), &OnnxModel::is_last_frame_only);
+    ClassDB::bind_method(D_METHOD("has_last_frame_output"), &OnnxModel::has_last_frame_output);
+    ClassDB::bind_method(D_METHOD("get_output_channels"), &OnnxModel::get_output_channels);
+    ClassDB::bind_method(D_METHOD("set_fused_conv", "enabled"), &OnnxModel::set_fused_conv);
+    ClassDB::bind_method(D_METHOD("is_fused_conv"), &OnnxModel::is_fused_conv);
+    ClassDB::bind_method(D_METHOD("get_fused_conv_count"), &OnnxModel::get_fused_conv_count);
+    ClassDB::bind_method(D_METHOD("set_pcm_input", "enabled"), &OnnxModel::set_pcm_input);
+    ClassDB::bind_method(D_METHOD("is_pcm_input"), &OnnxModel::is_pcm_input);
+    ClassDB::bind_method(D_METHOD("has_pcm_input"), &OnnxModel::has_pcm_input);
+
+    ClassDB::bind_method(D_METHOD("set_profiling_enabled", "enabled"), &OnnxModel::set_profiling_enabled);
+    ClassDB::bind_method(D_METHOD("is_profiling_enabled"), &OnnxModel::is_profiling_enabled);
+    ClassDB::bind_method(D_METHOD("set_profile_prefix", "prefix"), &OnnxModel::set_profile_prefix);
+    ClassDB::bind_method(D_METHOD("get_profile_prefix"), &OnnxModel::get_profile_prefix);
+    ClassDB::bind_method(D_METHOD("end_profiling"), &OnnxModel::end_profiling);
+
+    ClassDB::bind_method(D_METHOD("set_warmup_runs", "runs"), &OnnxModel::set_warmup_runs);
+    ClassDB::bind_method(D_METHOD("get_warmup_runs"), &OnnxModel::get_warmup_runs);
+    ClassDB::bind_method(D_METHOD("set_warmup_frames", "frames"), &OnnxModel::set_warmup_frames);
+    ClassDB::bind_method(D_METHOD("get_warmup_frames"), &OnnxModel::get_warmup_frames);
+    ClassDB::bind_method(D_METHOD("set_warmup_on_worker", "enabled"), &OnnxModel::set_warmup_on_worker);
+    ClassDB::bind_method(D_METHOD("is_warmup_on_worker"), &OnnxModel::is_warmup_on_worker);
+    ClassDB::bind_method(D_METHOD("warmup"), &OnnxModel::warmup);
+    ClassDB::bind_method(D_METHOD("is_warm"), &OnnxModel::is_warm);
+    ClassDB::bind_method(D_METHOD("get_inference_stats"), &OnnxModel::get_inference_stats);
 }
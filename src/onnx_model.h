@@ -3,7 +3,13 @@
 
 #include <godot_cpp/classes/ref_counted.hpp>
 #include <godot_cpp/variant/packed_float32_array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
 #include <onnxruntime_cxx_api.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace godot {
 
@@ -14,6 +20,64 @@ private:
     Ort::Env env;
     Ort::Session *session = nullptr;
 
+    // I/O metadata, resolved once at load instead of on every run
+    std::string input_name;
+    std::string output_name;
+    std::vector<int64_t> input_shape; // Dynamic dims are kept as -1
+    int64_t output_channels = 0;      // Last output dim (visemes), 0 if dynamic
+    int64_t receptive_field = 0;      // Frames of history one output depends on, 0 if unknown
+    bool input_half = false;          // float16 model input, fed without a float32 copy
+    bool output_half = false;
+
+    // Graph surgery: keep only the last time step of the output, so the output
+    // projection runs for one frame and only [1, 1, C] is copied back.
+    bool last_frame_only = false;
+    bool last_frame_output = false; // Whether the loaded graph was rewritten
+
+    // Graph surgery: replace each causal dilated Conv1d and the bias, residual
+    // and Relu after it with one FusedCausalConv1d node (see custom_ops.h).
+    bool fused_conv = false;
+    int fused_conv_count = 0; // Convs replaced in the loaded graph
+
+    // Graph surgery: compute the mel features in-graph (LogMelFeatures custom
+    // op), so run_inference takes raw 16 kHz PCM and the whole pipeline is one
+    // Session::Run. Meant for whole clips; streaming keeps AudioProcessor.
+    bool pcm_input = false;
+    bool pcm_input_active = false; // Whether the loaded graph takes PCM
+    int pcm_hop_length = 160;
+
+    // ORT built-in profiler. Records every Run from session creation until
+    // end_profiling(), which writes the trace JSON and aggregates it.
+    bool profiling_enabled = false;
+    String profile_prefix = "user://onnx_profile";
+    bool profiling_active = false;
+
+    // Warm-up: ORT selects kernels, prepacks weights and grows its arena lazily
+    // on the first Run, so we pay that cost at load with dummy inputs instead of
+    // when a character first speaks.
+    int warmup_runs = 1;
+    int warmup_frames = 100; // Should match the context size used for real calls
+    bool warmup_on_worker = false;
+    std::thread warmup_thread;
+    std::atomic<bool> warm{false};
+
+    // Timing stats (microseconds)
+    std::mutex stats_mutex;
+    uint64_t load_usec = 0;
+    uint64_t warmup_usec = 0;
+    uint64_t warmup_first_run_usec = 0; // Cold run absorbed by the warm-up
+    uint64_t first_inference_usec = 0;  // First real call after load
+    uint64_t last_inference_usec = 0;
+    double steady_inference_usec = 0.0; // Running mean of real calls after the first
+    uint64_t inference_count = 0;
+
+    // p_data is float32 or, with p_half, float16 bits; converted only when the
+    // model's input type differs
+    bool _run(const void *p_data, bool p_half, size_t p_count, PackedFloat32Array &r_output);
+    void _run_warmup();
+    void _join_warmup();
+    void _record_inference(uint64_t p_usec);
+
 protected:
     static void _bind_methods();
 
@@ -23,6 +87,51 @@ public:
 
     bool load_model(const String &p_path);
     PackedFloat32Array run_inference(const PackedFloat32Array &p_input);
+    // Same, straight from a float32 buffer or, with p_half, float16 bits. Only
+    // converted when the model's input type differs.
+    PackedFloat32Array run_inference_raw(const void *p_input, bool p_half, size_t p_count);
+    bool has_half_input() const { return input_half; }
+
+    // Offline inference over a whole clip of features [T * C]. Returns [T * V]
+    // where row t is exactly what streaming with a p_context_frames window
+    // (0 = unbounded) produces at frame t. Runs on p_threads cores (0 = all).
+    // Fast, chunked path when get_receptive_field() <= p_context_frames and the
+    // graph keeps its full output; otherwise one window per frame.
+    PackedFloat32Array run_offline(const PackedFloat32Array &p_features, int p_context_frames, int p_threads = 0);
+    int get_receptive_field() const { return (int)receptive_field; }
+
+    // Applied on the next load_model
+    void set_last_frame_only(bool p_enabled) { last_frame_only = p_enabled; }
+    bool is_last_frame_only() const { return last_frame_only; }
+    bool has_last_frame_output() const { return last_frame_output; }
+    int get_output_channels() const { return (int)output_channels; }
+    void set_fused_conv(bool p_enabled) { fused_conv = p_enabled; }
+    bool is_fused_conv() const { return fused_conv; }
+    int get_fused_conv_count() const { return fused_conv_count; }
+    void set_pcm_input(bool p_enabled) { pcm_input = p_enabled; }
+    bool is_pcm_input() const { return pcm_input; }
+    bool has_pcm_input() const { return pcm_input_active; }
+
+    void set_profiling_enabled(bool p_enabled) { profiling_enabled = p_enabled; }
+    bool is_profiling_enabled() const { return profiling_enabled; }
+    void set_profile_prefix(const String &p_prefix) { profile_prefix = p_prefix; }
+    String get_profile_prefix() const { return profile_prefix; }
+    // Stops profiling and returns per-op and per-node costs. Reload to profile again.
+    Dictionary end_profiling();
+
+    // Warm-up configuration (applied on the next load_model)
+    void set_warmup_runs(int p_runs);
+    int get_warmup_runs() const { return warmup_runs; }
+    void set_warmup_frames(int p_frames);
+    int get_warmup_frames() const { return warmup_frames; }
+    void set_warmup_on_worker(bool p_enabled) { warmup_on_worker = p_enabled; }
+    bool is_warmup_on_worker() const { return warmup_on_worker; }
+
+    // Runs the configured dummy inferences now. Blocks the caller.
+    void warmup();
+    bool is_warm() const { return warm.load(); }
+
+    Dictionary get_inference_stats();
 };
 
 } // namespace godot
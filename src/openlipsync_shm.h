@@ -0,0 +1,98 @@
+#ifndef OPENLIPSYNC_SHM_H
+#define OPENLIPSYNC_SHM_H
+
+/*
+ * Shared-memory audio ring between an external audio process (the producer,
+ * e.g. a voice chat client) and LipSyncShmSource (the consumer). It is
+ * single producer, single consumer and lock-free, and it works in C and C++.
+ *
+ * The ring is a POSIX shared memory object (shm_open), so the game only needs
+ * its name. The producer creates it and the consumer maps it read-write to
+ * publish read_pos. All fields are native-endian, and both processes run on
+ * the same machine.
+ *
+ *   offset  size  field
+ *        0     4  magic        OLSYNC_SHM_MAGIC ("OLSM")
+ *        4     4  version      OLSYNC_SHM_VERSION
+ *        8     4  sample_rate  producer's rate in Hz
+ *       12     4  channels     interleaved channels per frame
+ *       16     4  capacity     frames in the ring, a power of two
+ *       20     4  format       OLSYNC_SHM_FORMAT_*
+ *       24     8  dropped      frames the producer dropped on a full ring
+ *       64     8  write_pos    frames written, ever (producer, release store)
+ *       72     8  write_time   CLOCK_MONOTONIC ns of the last write
+ *      128     8  read_pos     frames read, ever (consumer, release store)
+ *      256     -  data         capacity * channels samples
+ *
+ * Frame n lives at data[(n & (capacity - 1)) * channels]. write_pos and
+ * read_pos only grow, and write_pos - read_pos frames are readable. Each
+ * position sits on a cache line of its own so the two sides never share a
+ * written line. The producer writes the samples, then publishes write_pos
+ * with a release store. The consumer loads it with acquire ordering, reads
+ * the samples in place, then publishes read_pos the same way.
+ *
+ * Producer library (shm_producer/olsync_producer.c; POSIX, no dependencies):
+ *
+ *   olsync_producer *p = olsync_producer_create("/my_voice", 48000, 1, 16384, OLSYNC_SHM_FORMAT_S16);
+ *   olsync_producer_write(p, pcm, frames);  // From the audio callback
+ *   olsync_producer_destroy(p);             // Unmaps and unlinks the ring
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OLSYNC_SHM_MAGIC 0x4D534C4Fu /* "OLSM" */
+#define OLSYNC_SHM_VERSION 1u
+#define OLSYNC_SHM_DATA_OFFSET 256
+
+#define OLSYNC_SHM_FORMAT_F32 0u /* float in [-1, 1] */
+#define OLSYNC_SHM_FORMAT_S16 1u /* signed 16-bit */
+
+typedef struct olsync_shm_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t capacity;
+    uint32_t format;
+    uint64_t dropped;
+    uint8_t pad0[64 - 32];
+    uint64_t write_pos;
+    uint64_t write_time;
+    uint8_t pad1[128 - 80];
+    uint64_t read_pos;
+    uint8_t pad2[OLSYNC_SHM_DATA_OFFSET - 136];
+} olsync_shm_header;
+
+static inline size_t olsync_shm_sample_size(uint32_t p_format) {
+    return p_format == OLSYNC_SHM_FORMAT_S16 ? 2 : 4;
+}
+
+static inline size_t olsync_shm_size(uint32_t p_capacity, uint32_t p_channels, uint32_t p_format) {
+    return OLSYNC_SHM_DATA_OFFSET + (size_t)p_capacity * p_channels * olsync_shm_sample_size(p_format);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct olsync_producer olsync_producer;
+
+/* Creates (or replaces) the ring p_name ("/name") for p_capacity frames,
+ * rounded up to a power of two. NULL on failure, with errno set. */
+olsync_producer *olsync_producer_create(const char *p_name, uint32_t p_sample_rate, uint32_t p_channels, uint32_t p_capacity, uint32_t p_format);
+
+/* Copies up to p_frames interleaved frames into the ring, never blocking.
+ * Returns the frames written; the rest are dropped and counted in the header. */
+size_t olsync_producer_write(olsync_producer *p_producer, const void *p_frames, size_t p_count);
+
+/* Frames the consumer has not read yet */
+size_t olsync_producer_pending(const olsync_producer *p_producer);
+
+void olsync_producer_destroy(olsync_producer *p_producer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+#include "pcm_convert.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+// SSE2 is part of the x86-64 baseline, so no runtime check
+#include <emmintrin.h>
+#define PCM_CONVERT_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PCM_CONVERT_NEON 1
+#endif
+
+namespace pcm_convert {
+
+static inline int16_t _read_s16(const uint8_t *p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+void int16_to_mono(const uint8_t *p_bytes, int64_t p_frames, int p_channels, float *r_mono) {
+    const float scale = 1.0f / (32768.0f * p_channels);
+    int64_t i = 0;
+    if (p_channels == 1) {
+#if defined(PCM_CONVERT_SSE2)
+        const __m128 v_scale = _mm_set1_ps(scale);
+        for (; i + 8 <= p_frames; i += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p_bytes + i * 2));
+            // Sign-extend by placing each sample in the top half of a 32-bit lane
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            _mm_storeu_ps(r_mono + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), v_scale));
+            _mm_storeu_ps(r_mono + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), v_scale));
+        }
+#elif defined(PCM_CONVERT_NEON)
+        const float32x4_t v_scale = vdupq_n_f32(scale);
+        for (; i + 8 <= p_frames; i += 8) {
+            int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(p_bytes + i * 2));
+            vst1q_f32(r_mono + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), v_scale));
+            vst1q_f32(r_mono + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), v_scale));
+        }
+#endif
+    } else if (p_channels == 2) {
+#if defined(PCM_CONVERT_SSE2)
+        // madd against ones sums each L/R pair into one 32-bit lane
+        const __m128 v_scale = _mm_set1_ps(scale);
+        const __m128i ones = _mm_set1_epi16(1);
+        for (; i + 8 <= p_frames; i += 8) {
+            __m128i a = _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(p_bytes + i * 4)), ones);
+            __m128i b = _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(p_bytes + i * 4 + 16)), ones);
+            _mm_storeu_ps(r_mono + i, _mm_mul_ps(_mm_cvtepi32_ps(a), v_scale));
+            _mm_storeu_ps(r_mono + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), v_scale));
+        }
+#elif defined(PCM_CONVERT_NEON)
+        const float32x4_t v_scale = vdupq_n_f32(scale);
+        for (; i + 8 <= p_frames; i += 8) {
+            int16x8x2_t v = vld2q_s16((const int16_t *)(p_bytes + i * 4)); // Deinterleaves L and R
+            int32x4_t lo = vaddl_s16(vget_low_s16(v.val[0]), vget_low_s16(v.val[1]));
+            int32x4_t hi = vaddl_s16(vget_high_s16(v.val[0]), vget_high_s16(v.val[1]));
+            vst1q_f32(r_mono + i, vmulq_f32(vcvtq_f32_s32(lo), v_scale));
+            vst1q_f32(r_mono + i + 4, vmulq_f32(vcvtq_f32_s32(hi), v_scale));
+        }
+#endif
+    }
+    for (; i < p_frames; i++) {
+        const uint8_t *frame = p_bytes + i * 2 * p_channels;
+        int32_t sum = 0;
+        for (int c = 0; c < p_channels; c++) {
+            sum += _read_s16(frame + c * 2);
+        }
+        r_mono[i] = sum * scale;
+    }
+}
+
+std::vector<float> resample_linear(const float *p_samples, int64_t p_count, int p_source_rate, int p_target_rate) {
+    if (p_source_rate == p_target_rate) {
+        return std::vector<float>(p_samples, p_samples + p_count);
+    }
+    const double ratio = (double)p_source_rate / p_target_rate;
+    const int64_t count = p_count > 1 ? (int64_t)((p_count - 1) / ratio) + 1 : p_count;
+    std::vector<float> result((size_t)count);
+    for (int64_t i = 0; i < count; i++) {
+        double pos = i * ratio;
+        int64_t index = (int64_t)pos;
+        float t = (float)(pos - index);
+        float s0 = p_samples[index];
+        float s1 = index + 1 < p_count ? p_samples[index + 1] : s0;
+        result[i] = s0 + (s1 - s0) * t;
+    }
+    return result;
+}
+
+} // namespace pcm_convert
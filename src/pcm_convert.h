@@ -0,0 +1,22 @@
+#ifndef PCM_CONVERT_H
+#define PCM_CONVERT_H
+
+// PCM to the 16 kHz mono float samples the pipeline consumes.
+// Has no Godot dependencies.
+
+#include <cstdint>
+#include <vector>
+
+namespace pcm_convert {
+
+// Interleaved little-endian int16 frames (p_bytes need not be aligned) to mono
+// floats in [-1, 1), averaging the channels. SSE2 or NEON for mono and stereo.
+void int16_to_mono(const uint8_t *p_bytes, int64_t p_frames, int p_channels, float *r_mono);
+
+// Whole-clip linear interpolation from p_source_rate to p_target_rate. Output
+// sample i reads the source at i * ratio and the last sample is held at the end.
+std::vector<float> resample_linear(const float *p_samples, int64_t p_count, int p_source_rate, int p_target_rate);
+
+} // namespace pcm_convert
+
+#endif
@@ -8,6 +8,12 @@
 #include "onnx_model.h"
 #include "audio_processor.h"
 #include "lip_sync_context.h"
+#include "lip_sync_baker.h"
+#include "lip_sync_capture.h"
+#include "lip_sync_lookahead.h"
+#include "lip_sync_jitter_buffer.h"
+#include "lip_sync_shm_source.h"
+#include "lip_sync_stream_codec.h"
 
 using namespace godot;
 
@@ -19,6 +25,12 @@ void initialize_gdextension_types(ModuleInitializationLevel p_level)
 	GDREGISTER_CLASS(OnnxModel);
 	GDREGISTER_CLASS(AudioProcessor);
 	GDREGISTER_CLASS(LipSyncContext);
+	GDREGISTER_CLASS(LipSyncBaker);
+	GDREGISTER_CLASS(LipSyncLookahead);
+	GDREGISTER_CLASS(LipSyncJitterBuffer);
+	GDREGISTER_CLASS(LipSyncShmSource);
+	GDREGISTER_CLASS(LipSyncStreamCodec);
+	GDREGISTER_CLASS(LipSyncCapture);
 }
 
 void uninitialize_gdextension_types(ModuleInitializationLevel p_level) {
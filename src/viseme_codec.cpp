@@ -0,0 +1,307 @@
+#include "viseme_codec.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace viseme_codec {
+
+// Probabilities are 12-bit odds of a 0 bit, adapting by 1/32 of the error
+static const int PROB_BITS = 12;
+static const uint16_t PROB_INIT = 1 << (PROB_BITS - 1);
+static const int ADAPT_SHIFT = 5;
+static const uint32_t TOP = 1u << 24;
+
+void Models::reset() {
+    unchanged = PROB_INIT;
+    std::fill(std::begin(count_prefix), std::end(count_prefix), PROB_INIT);
+    std::fill(std::begin(count_suffix), std::end(count_suffix), PROB_INIT);
+    std::fill(&zero[0][0][0], &zero[0][0][0] + MAX_VISEMES * 2 * 3, PROB_INIT);
+    std::fill(&sign[0][0], &sign[0][0] + MAX_VISEMES * 3, PROB_INIT);
+    std::fill(std::begin(magnitude_prefix), std::end(magnitude_prefix), PROB_INIT);
+    std::fill(std::begin(magnitude_suffix), std::end(magnitude_suffix), PROB_INIT);
+}
+
+namespace {
+
+class RangeEncoder {
+    std::vector<uint8_t> &out;
+    uint64_t low = 0;
+    uint32_t range = 0xFFFFFFFF;
+
+    void _carry() {
+        for (size_t i = out.size(); i-- > 0;) {
+            if (++out[i] != 0) {
+                break;
+            }
+        }
+    }
+
+public:
+    explicit RangeEncoder(std::vector<uint8_t> &r_out) :
+            out(r_out) {}
+
+    void bit(uint16_t &p_prob, int p_bit) {
+        const uint32_t bound = (range >> PROB_BITS) * p_prob;
+        if (p_bit) {
+            low += bound;
+            range -= bound;
+            p_prob -= p_prob >> ADAPT_SHIFT;
+        } else {
+            range = bound;
+            p_prob += ((1 << PROB_BITS) - p_prob) >> ADAPT_SHIFT;
+        }
+        if (low >> 32) {
+            _carry();
+            low &= 0xFFFFFFFF;
+        }
+        while (range < TOP) {
+            out.push_back((uint8_t)(low >> 24));
+            low = (low << 8) & 0xFFFFFFFF;
+            range <<= 8;
+        }
+    }
+
+    // Emits the fewest bytes that, zero padded, land inside [low, low + range)
+    void finish(size_t p_payload_start) {
+        for (int bytes = 1; bytes <= 4; bytes++) {
+            const uint64_t mask = 0xFFFFFFFFull >> (8 * bytes);
+            const uint64_t value = (low + mask) & ~mask;
+            if (value - low < range) {
+                if (value >> 32) {
+                    _carry();
+                }
+                for (int i = 0; i < bytes; i++) {
+                    out.push_back((uint8_t)(value >> (24 - 8 * i)));
+                }
+                break;
+            }
+        }
+        while (out.size() > p_payload_start && out.back() == 0) {
+            out.pop_back();
+        }
+    }
+};
+
+class RangeDecoder {
+    const uint8_t *data;
+    size_t size;
+    size_t pos = 0;
+    uint32_t code = 0;
+    uint32_t range = 0xFFFFFFFF;
+
+    uint8_t _next() { return pos < size ? data[pos++] : 0; }
+
+public:
+    RangeDecoder(const uint8_t *p_data, size_t p_size) :
+            data(p_data), size(p_size) {
+        for (int i = 0; i < 4; i++) {
+            code = (code << 8) | _next();
+        }
+    }
+
+    int bit(uint16_t &p_prob) {
+        const uint32_t bound = (range >> PROB_BITS) * p_prob;
+        int result;
+        if (code < bound) {
+            range = bound;
+            p_prob += ((1 << PROB_BITS) - p_prob) >> ADAPT_SHIFT;
+            result = 0;
+        } else {
+            code -= bound;
+            range -= bound;
+            p_prob -= p_prob >> ADAPT_SHIFT;
+            result = 1;
+        }
+        while (range < TOP) {
+            code = (code << 8) | _next();
+            range <<= 8;
+        }
+        return result;
+    }
+};
+
+// Elias-gamma style: unary class k = floor(log2(v + 1)), then k bits below it
+void encode_value(RangeEncoder &p_rc, uint16_t *p_prefix, int p_classes, uint16_t *p_suffix, uint32_t p_value) {
+    const uint32_t v = p_value + 1;
+    int k = 0;
+    while ((v >> (k + 1)) != 0) {
+        k++;
+    }
+    for (int j = 0; j < k; j++) {
+        p_rc.bit(p_prefix[j], 1);
+    }
+    if (k < p_classes - 1) {
+        p_rc.bit(p_prefix[k], 0);
+    }
+    for (int j = k - 1; j >= 0; j--) {
+        p_rc.bit(p_suffix[j], (v >> j) & 1);
+    }
+}
+
+uint32_t decode_value(RangeDecoder &p_rc, uint16_t *p_prefix, int p_classes, uint16_t *p_suffix) {
+    int k = 0;
+    while (k < p_classes - 1 && p_rc.bit(p_prefix[k])) {
+        k++;
+    }
+    uint32_t v = 1;
+    for (int j = k - 1; j >= 0; j--) {
+        v = (v << 1) | (uint32_t)p_rc.bit(p_suffix[j]);
+    }
+    return v - 1;
+}
+
+Config sanitize(const Config &p_config) {
+    Config config = p_config;
+    config.viseme_count = std::clamp(config.viseme_count, 1, (int)Models::MAX_VISEMES);
+    config.bits = std::clamp(config.bits, 2, 8);
+    config.deadband = std::max(0, config.deadband);
+    config.stride = std::clamp(config.stride, 1, 16);
+    return config;
+}
+
+} // namespace
+
+void Encoder::configure(const Config &p_config) {
+    config = sanitize(p_config);
+    reference.assign(config.viseme_count, 0);
+    last_change.assign(config.viseme_count, 0);
+    phase = 0;
+    force_keyframe = true;
+}
+
+std::vector<uint8_t> Encoder::encode(const float *p_visemes, int64_t p_frames) {
+    const bool keyframe = force_keyframe || (keyframe_interval > 0 && packets_since_keyframe >= keyframe_interval);
+    if (keyframe) {
+        models.reset();
+        std::fill(reference.begin(), reference.end(), 0);
+        std::fill(last_change.begin(), last_change.end(), 0);
+        packets_since_keyframe = 0;
+        force_keyframe = false;
+    }
+    packets_since_keyframe++;
+
+    std::vector<uint8_t> packet;
+    packet.push_back((uint8_t)((keyframe ? 0x80 : 0) | (sequence & 0x7F)));
+    sequence = (sequence + 1) & 0x7F;
+
+    // The last frame of every group of stride is the one coded
+    std::vector<int64_t> coded;
+    for (int64_t f = 0; f < p_frames && (int64_t)coded.size() < MAX_FRAMES; f++) {
+        if (++phase == config.stride) {
+            coded.push_back(f);
+            phase = 0;
+        }
+    }
+
+    RangeEncoder rc(packet);
+    encode_value(rc, models.count_prefix, 16, models.count_suffix, (uint32_t)coded.size());
+
+    const int levels = (1 << config.bits) - 1;
+    const int count = config.viseme_count;
+    std::vector<int> deltas(count);
+    for (int64_t f : coded) {
+        const float *frame = p_visemes + f * count;
+        bool changed = false;
+        for (int i = 0; i < count; i++) {
+            const float v = std::clamp(frame[i], 0.0f, 1.0f);
+            const int q = (int)std::lround(v * levels);
+            int d = q - reference[i];
+            // The deadband keeps noise from costing bits; whole-range values
+            // still snap to the ends so silence decodes as exact zeros
+            if (std::abs(d) <= config.deadband && q != 0 && q != levels) {
+                d = 0;
+            }
+            deltas[i] = d;
+            changed |= d != 0;
+        }
+        rc.bit(models.unchanged, changed ? 0 : 1);
+        if (!changed) {
+            std::fill(last_change.begin(), last_change.end(), 0);
+            continue;
+        }
+        int previous_changed = 0;
+        for (int i = 0; i < count; i++) {
+            const int d = deltas[i];
+            rc.bit(models.zero[i][previous_changed][last_change[i]], d != 0);
+            previous_changed = d != 0;
+            if (d == 0) {
+                last_change[i] = 0;
+                continue;
+            }
+            rc.bit(models.sign[i][last_change[i]], d < 0);
+            encode_value(rc, models.magnitude_prefix, Models::MAGNITUDE_CLASSES, models.magnitude_suffix, (uint32_t)(std::abs(d) - 1));
+            reference[i] += d;
+            last_change[i] = d > 0 ? 1 : 2;
+        }
+    }
+    rc.finish(1);
+    return packet;
+}
+
+void Decoder::configure(const Config &p_config) {
+    config = sanitize(p_config);
+    reference.assign(config.viseme_count, 0);
+    last_change.assign(config.viseme_count, 0);
+    previous.assign(config.viseme_count, 0.0f);
+    expected_sequence = -1;
+}
+
+bool Decoder::decode(const uint8_t *p_packet, size_t p_size, std::vector<float> &r_visemes) {
+    if (p_size < 1) {
+        return false;
+    }
+    const bool keyframe = (p_packet[0] & 0x80) != 0;
+    const int sequence = p_packet[0] & 0x7F;
+    if (keyframe) {
+        models.reset();
+        std::fill(reference.begin(), reference.end(), 0);
+        std::fill(last_change.begin(), last_change.end(), 0);
+    } else if (sequence != expected_sequence) {
+        // Lost or reordered: the reference is gone until the next keyframe
+        expected_sequence = -1;
+        return false;
+    }
+
+    RangeDecoder rc(p_packet + 1, p_size - 1);
+    const uint32_t frames = decode_value(rc, models.count_prefix, 16, models.count_suffix);
+    if (frames > (uint32_t)MAX_FRAMES) {
+        expected_sequence = -1;
+        return false;
+    }
+    const int levels = (1 << config.bits) - 1;
+    const int count = config.viseme_count;
+    const int stride = config.stride;
+    r_visemes.reserve(r_visemes.size() + (size_t)frames * stride * count);
+    for (uint32_t f = 0; f < frames; f++) {
+        if (rc.bit(models.unchanged)) {
+            std::fill(last_change.begin(), last_change.end(), 0);
+        } else {
+            int previous_changed = 0;
+            for (int i = 0; i < count; i++) {
+                previous_changed = rc.bit(models.zero[i][previous_changed][last_change[i]]);
+                if (!previous_changed) {
+                    last_change[i] = 0;
+                    continue;
+                }
+                const bool negative = rc.bit(models.sign[i][last_change[i]]);
+                const int magnitude = (int)decode_value(rc, models.magnitude_prefix, Models::MAGNITUDE_CLASSES, models.magnitude_suffix) + 1;
+                reference[i] = std::clamp(reference[i] + (negative ? -magnitude : magnitude), 0, levels);
+                last_change[i] = negative ? 2 : 1;
+            }
+        }
+        for (int step = 1; step <= stride; step++) {
+            const float t = (float)step / stride;
+            for (int i = 0; i < count; i++) {
+                const float value = (float)reference[i] / levels;
+                r_visemes.push_back(previous[i] + (value - previous[i]) * t);
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            previous[i] = (float)reference[i] / levels;
+        }
+    }
+    expected_sequence = (sequence + 1) & 0x7F;
+    return true;
+}
+
+} // namespace viseme_codec
@@ -0,0 +1,104 @@
+#ifndef VISEME_CODEC_H
+#define VISEME_CODEC_H
+
+// Compact coding of viseme streams for network replication, so only the
+// speaker's machine runs inference. Has no Godot dependencies.
+//
+// Each coded frame is quantized to `bits` bits over [0, 1], delta coded against the
+// previous frame and entropy coded with an adaptive binary range coder whose
+// models persist across packets. A packet holds any number of frames:
+//
+//   byte 0      bit 7: keyframe, bits 0-6: sequence number (mod 128)
+//   bytes 1..   range coded payload: frame count, then per frame an
+//               "unchanged" flag and, if changed, one delta per viseme
+//
+// Trailing zero bytes are trimmed from the payload; the decoder reads past the
+// end as zeros. A keyframe resets the models and the reference frame to zero
+// on both sides, so deltas need every packet in order (reliable or
+// unreliable-ordered channels that drop, then ask for a keyframe).
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace viseme_codec {
+
+static const int MAX_FRAMES = 1024; // Per packet; the encoder drops the rest
+
+struct Config {
+    int viseme_count = 15;
+    int bits = 5;     // Quantization bits per value, 2-8
+    int deadband = 1; // Changes of up to this many steps are not sent (encoder only)
+    int stride = 2;   // Codes every stride-th frame; the decoder interpolates the rest
+};
+
+// Adaptive probability models shared by both directions
+struct Models {
+    static const int MAX_VISEMES = 64;
+    static const int MAGNITUDE_CLASSES = 9;
+
+    uint16_t unchanged;
+    uint16_t count_prefix[16];
+    uint16_t count_suffix[16];
+    // Contexts: did the previous viseme in this frame change, and how did this
+    // viseme change in the previous frame (0 = not, 1 = up, 2 = down)
+    uint16_t zero[MAX_VISEMES][2][3];
+    uint16_t sign[MAX_VISEMES][3];
+    uint16_t magnitude_prefix[MAGNITUDE_CLASSES];
+    uint16_t magnitude_suffix[MAGNITUDE_CLASSES - 1];
+
+    void reset();
+};
+
+class Encoder {
+    Config config;
+    Models models;
+    std::vector<int> reference;
+    std::vector<uint8_t> last_change; // Per viseme, the sign context above
+    int phase = 0;                    // Frames since the last coded one
+    uint8_t sequence = 0;
+    int keyframe_interval = 50;
+    int packets_since_keyframe = 0;
+    bool force_keyframe = true;
+
+public:
+    Encoder() { configure(Config()); }
+    void configure(const Config &p_config);
+    const Config &get_config() const { return config; }
+
+    // Every p_packets packets, 0 = only on request
+    void set_keyframe_interval(int p_packets) { keyframe_interval = p_packets < 0 ? 0 : p_packets; }
+    int get_keyframe_interval() const { return keyframe_interval; }
+    void request_keyframe() { force_keyframe = true; }
+
+    // p_frames frames of viseme_count values each into one packet. With a
+    // stride, frames between coded ones only advance the phase, which carries
+    // across packets.
+    std::vector<uint8_t> encode(const float *p_visemes, int64_t p_frames);
+};
+
+class Decoder {
+    Config config;
+    Models models;
+    std::vector<int> reference;
+    std::vector<uint8_t> last_change;
+    std::vector<float> previous; // Last coded frame, the start of the next interpolation
+    int expected_sequence = -1; // -1 until a keyframe arrives
+
+public:
+    Decoder() { configure(Config()); }
+    void configure(const Config &p_config);
+    const Config &get_config() const { return config; }
+
+    // Appends the packet's frames to r_visemes, stride per coded frame, the
+    // ones in between interpolated linearly (so a stride adds stride - 1
+    // frames of latency). Returns false for deltas after
+    // a lost packet and for bad frame counts; both wait for a keyframe.
+    // Truncated packets are the transport's to catch.
+    bool decode(const uint8_t *p_packet, size_t p_size, std::vector<float> &r_visemes);
+    bool needs_keyframe() const { return expected_sequence < 0; }
+};
+
+} // namespace viseme_codec
+
+#endif
@@ -0,0 +1,187 @@
+// Compares the stock ONNX Runtime Conv nodes of the OpenLipSync TCN with the
+// FusedCausalConv1d rewrite: checks that both graphs agree and times them.
+//
+//     g++ -O2 -std=c++17 -Isrc -Ithirdparty/onnxruntime/include -o bench_fused_conv
+//         tools/bench_fused_conv.cpp src/custom_ops.cpp src/mel_frontend.cpp src/onnx_graph.cpp
+//         -Lthirdparty/onnxruntime/lib -lonnxruntime -Wl,-rpath,thirdparty/onnxruntime/lib
+//     ./bench_fused_conv project/addons/godot_openlipsync/model.onnx [runs]
+//
+// Sessions use one intra-op thread and basic graph optimizations, like OnnxModel.
+// Inputs are standard-normal feature windows, which is what the per-frame
+// normalisation in AudioProcessor produces on average.
+
+#include "custom_ops.h"
+#include "onnx_graph.h"
+#include <onnxruntime_cxx_api.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+static double _now_usec() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static Ort::Session _create_session(Ort::Env &p_env, const std::string &p_model) {
+    Ort::SessionOptions options;
+    options.SetIntraOpNumThreads(1);
+    options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_BASIC);
+    custom_ops::add_to_session_options(options);
+    return Ort::Session(p_env, p_model.data(), p_model.size(), options);
+}
+
+static std::vector<float> _run(Ort::Session &p_session, std::vector<float> &p_input, int64_t p_frames, int64_t p_channels) {
+    Ort::AllocatorWithDefaultOptions allocator;
+    std::string input_name = p_session.GetInputNameAllocated(0, allocator).get();
+    std::string output_name = p_session.GetOutputNameAllocated(0, allocator).get();
+    const char *input_names[] = { input_name.c_str() };
+    const char *output_names[] = { output_name.c_str() };
+
+    int64_t shape[] = { 1, p_frames, p_channels };
+    auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::Value input = Ort::Value::CreateTensor<float>(memory_info, p_input.data(), p_input.size(), shape, 3);
+    std::vector<Ort::Value> outputs = p_session.Run(Ort::RunOptions{ nullptr }, input_names, &input, 1, output_names, 1);
+    const float *data = outputs[0].GetTensorData<float>();
+    return std::vector<float>(data, data + outputs[0].GetTensorTypeAndShapeInfo().GetElementCount());
+}
+
+// Median of p_runs calls, in microseconds
+static double _time(Ort::Session &p_session, std::vector<float> &p_input, int64_t p_frames, int64_t p_channels, int p_runs) {
+    std::vector<double> samples;
+    for (int i = 0; i < p_runs; i++) {
+        double start = _now_usec();
+        _run(p_session, p_input, p_frames, p_channels);
+        samples.push_back(_now_usec() - start);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// Times the kernel alone against a naive reference on one TCN-sized layer
+static void _bench_kernel(int p_runs) {
+    const int64_t channels = 256;
+    const int64_t kernel = 3;
+    const int64_t dilation = 4;
+    std::mt19937 rng(7);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+
+    printf("\nKernel, %lld -> %lld channels, K=%lld, dilation=%lld (%s)\n", (long long)channels, (long long)channels,
+            (long long)kernel, (long long)dilation, custom_ops::simd_path());
+    printf("%8s %12s %12s %10s %12s\n", "frames", "naive us", "fused us", "speedup", "max |diff|");
+    for (int64_t frames : { 1, 8, 32, 100, 400 }) {
+        std::vector<float> x((size_t)(channels * frames)), w((size_t)(channels * channels * kernel)), bias((size_t)channels);
+        std::vector<float> residual((size_t)(channels * frames));
+        for (float &v : x) {
+            v = normal(rng);
+        }
+        for (float &v : w) {
+            v = normal(rng) * 0.05f;
+        }
+        for (float &v : bias) {
+            v = normal(rng);
+        }
+        for (float &v : residual) {
+            v = normal(rng);
+        }
+
+        std::vector<float> expected((size_t)(channels * frames));
+        std::vector<double> samples;
+        for (int run = 0; run < p_runs; run++) {
+            double start = _now_usec();
+            for (int64_t co = 0; co < channels; co++) {
+                for (int64_t t = 0; t < frames; t++) {
+                    float sum = bias[co];
+                    for (int64_t ci = 0; ci < channels; ci++) {
+                        for (int64_t k = 0; k < kernel; k++) {
+                            int64_t src = t - (kernel - 1 - k) * dilation;
+                            if (src >= 0) {
+                                sum += w[(co * channels + ci) * kernel + k] * x[ci * frames + src];
+                            }
+                        }
+                    }
+                    expected[co * frames + t] = std::max(sum + residual[co * frames + t], 0.0f);
+                }
+            }
+            samples.push_back(_now_usec() - start);
+        }
+        std::sort(samples.begin(), samples.end());
+        double naive_usec = samples[samples.size() / 2];
+
+        std::vector<float> packed = custom_ops::pack_conv_weights(w.data(), channels, channels, kernel);
+        std::vector<float> y((size_t)(channels * frames));
+        samples.clear();
+        for (int run = 0; run < p_runs; run++) {
+            double start = _now_usec();
+            custom_ops::causal_conv1d(x.data(), packed.data(), bias.data(), residual.data(), frames, y.data(),
+                    channels, channels, kernel, dilation, frames, true);
+            samples.push_back(_now_usec() - start);
+        }
+        std::sort(samples.begin(), samples.end());
+        double fused_usec = samples[samples.size() / 2];
+
+        float max_diff = 0.0f;
+        for (size_t i = 0; i < y.size(); i++) {
+            max_diff = std::max(max_diff, std::fabs(y[i] - expected[i]));
+        }
+        printf("%8lld %12.1f %12.1f %9.2fx %12.2e\n", (long long)frames, naive_usec, fused_usec, naive_usec / fused_usec, max_diff);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s model.onnx [runs]\n", argv[0]);
+        return 1;
+    }
+    int runs = argc > 2 ? std::max(1, atoi(argv[2])) : 200;
+
+    std::ifstream file(argv[1], std::ios::binary);
+    std::string stock((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (stock.empty()) {
+        fprintf(stderr, "Could not read %s\n", argv[1]);
+        return 1;
+    }
+
+    onnx_graph::Model graph;
+    std::string error;
+    int fused_count = 0;
+    if (!graph.load((const uint8_t *)stock.data(), stock.size(), error) || !onnx_graph::fuse_causal_conv1d(graph, fused_count, error)) {
+        fprintf(stderr, "Rewrite failed: %s\n", error.c_str());
+        return 1;
+    }
+    std::string fused = graph.save();
+    printf("Fused %d convs, %s path\n", fused_count, custom_ops::simd_path());
+
+    Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "bench_fused_conv");
+    Ort::Session stock_session = _create_session(env, stock);
+    Ort::Session fused_session = _create_session(env, fused);
+    std::vector<int64_t> input_shape = stock_session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    int64_t channels = input_shape.back();
+
+    std::mt19937 rng(1);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    printf("%8s %12s %12s %10s %12s\n", "frames", "stock us", "fused us", "speedup", "max |diff|");
+    for (int64_t frames : { 1, 10, 50, 100, 200, 400 }) {
+        std::vector<float> input((size_t)(frames * channels));
+        for (float &v : input) {
+            v = normal(rng);
+        }
+        std::vector<float> a = _run(stock_session, input, frames, channels);
+        std::vector<float> b = _run(fused_session, input, frames, channels);
+        float max_diff = a.size() == b.size() ? 0.0f : INFINITY;
+        for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+            max_diff = std::max(max_diff, std::fabs(a[i] - b[i]));
+        }
+        double stock_usec = _time(stock_session, input, frames, channels, runs);
+        double fused_usec = _time(fused_session, input, frames, channels, runs);
+        printf("%8lld %12.1f %12.1f %9.2fx %12.2e\n", (long long)frames, stock_usec, fused_usec, stock_usec / fused_usec, max_diff);
+    }
+
+    _bench_kernel(std::max(1, runs / 10));
+    return 0;
+}
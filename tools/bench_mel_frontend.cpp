@@ -0,0 +1,77 @@
+// Compares whole-clip feature extraction one FFT per frame (the streaming
+// process_frame path) with the batched DFT-mel GEMM path: checks that both
+// agree and times them on clips of increasing length.
+//
+//     g++ -O2 -std=c++17 -Isrc -Ithirdparty/onnxruntime/include -o bench_mel_frontend
+//         tools/bench_mel_frontend.cpp src/custom_ops.cpp src/mel_frontend.cpp src/onnx_graph.cpp
+//         -Lthirdparty/onnxruntime/lib -lonnxruntime -Wl,-rpath,thirdparty/onnxruntime/lib
+//     ./bench_mel_frontend [runs]
+//
+// The clip is a few harmonics with vibrato over a noise floor, so every mel
+// band sees some energy, the way speech does.
+
+#include "custom_ops.h"
+#include "mel_frontend.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static double _now_usec() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char **argv) {
+    int runs = argc > 1 ? std::max(1, atoi(argv[1])) : 5;
+
+    mel_frontend::Frontend frontend;
+    const mel_frontend::Config &config = frontend.get_config();
+    std::mt19937 rng(5);
+    std::normal_distribution<float> noise(0.0f, 0.01f);
+
+    printf("GEMM path: %s\n", custom_ops::simd_path());
+    printf("%10s %8s %12s %12s %10s %12s\n", "seconds", "frames", "fft us", "gemm us", "speedup", "max |diff|");
+    for (double seconds : { 1.0, 10.0, 60.0, 300.0 }) {
+        std::vector<float> clip((size_t)(seconds * config.sample_rate));
+        for (size_t i = 0; i < clip.size(); i++) {
+            double t = (double)i / config.sample_rate;
+            double f0 = 140.0 + 20.0 * std::sin(2.0 * M_PI * 3.0 * t);
+            double v = 0.0;
+            for (int h = 1; h <= 8; h++) {
+                v += std::sin(2.0 * M_PI * f0 * h * t) / h;
+            }
+            clip[i] = (float)(0.2 * v) + noise(rng);
+        }
+        int64_t frames = frontend.frame_count((int64_t)clip.size());
+        std::vector<float> expected((size_t)(frames * config.n_mels));
+        std::vector<float> batched(expected.size());
+
+        // The first batched call also builds the basis; keep it out of the timing
+        frontend.compute_clip_batched(clip.data(), (int64_t)clip.size(), batched.data());
+
+        std::vector<double> fft_samples, gemm_samples;
+        for (int run = 0; run < runs; run++) {
+            double start = _now_usec();
+            frontend.compute_clip(clip.data(), (int64_t)clip.size(), expected.data());
+            fft_samples.push_back(_now_usec() - start);
+
+            start = _now_usec();
+            frontend.compute_clip_batched(clip.data(), (int64_t)clip.size(), batched.data());
+            gemm_samples.push_back(_now_usec() - start);
+        }
+        std::sort(fft_samples.begin(), fft_samples.end());
+        std::sort(gemm_samples.begin(), gemm_samples.end());
+        double fft_usec = fft_samples[fft_samples.size() / 2];
+        double gemm_usec = gemm_samples[gemm_samples.size() / 2];
+
+        float max_diff = 0.0f;
+        for (size_t i = 0; i < expected.size(); i++) {
+            max_diff = std::max(max_diff, std::fabs(expected[i] - batched[i]));
+        }
+        printf("%10.0f %8lld %12.0f %12.0f %9.2fx %12.2e\n", seconds, (long long)frames, fft_usec, gemm_usec, fft_usec / gemm_usec, max_diff);
+    }
+    return 0;
+}
@@ -0,0 +1,565 @@
+// Finds where streaming lip sync stops scaling with the number of talking
+// characters. Runs N simulated LipSyncContexts, each with its own voice,
+// feature frontend and history, driven from M threads at a game's frame
+// cadence, and reports throughput, latency percentiles, RSS and CPU use for
+// each N and backend.
+//
+//     scons bench_scaling
+//     bin/bench_scaling project/addons/godot_openlipsync/model.onnx
+//         [--contexts 1,8,64,512] [--threads M] [--modes sync,shared,async,daemon]
+//         [--fps 60] [--seconds 5] [--socket /tmp/openlipsync.sock]
+//
+// Each frame, every context takes the audio of one frame period, extracts
+// features for each whole hop and runs one inference on its context window,
+// as LipSyncContext.process does. Contexts are split round-robin over the M
+// threads; a thread that falls behind starts its next frame at once, and the
+// audio still arrives in real time, so an overloaded run shows up as fewer
+// inferences per context, longer calls and a real-time factor under 1.
+//
+// Backends:
+//   sync    a session (and Ort::Env) per context, one intra-op thread, as
+//           LipSyncContext.load_model builds today
+//   shared  one session for all contexts, called concurrently
+//   async   one session, with the contexts of a frame submitted together
+//           through RunAsync on an intra-op pool of M + 1 threads
+//   daemon  a DaemonClient per context against a running lipsync_daemon;
+//           its CPU time is in the daemon's process and not counted here
+//
+// Latency is from the start of the frame, when the audio is there, to the
+// context's visemes, so it includes waiting behind the other contexts on the
+// same thread. "call" is the process call alone.
+
+#include "custom_ops.h"
+#include "daemon_client.h"
+#include "daemon_protocol.h"
+#include "mel_frontend.h"
+#include "onnx_graph.h"
+#include <onnxruntime_cxx_api.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <malloc.h>
+#endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static const int SAMPLE_RATE = 16000;
+static const int CONTEXT_FRAMES = 100;
+static const int VOICES = 8;
+static const double VOICE_SECONDS = 4.0;
+
+static double _now_usec() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Resident and peak resident set in MB, from /proc (0 where unavailable)
+static void _memory_mb(double &r_rss, double &r_peak) {
+    r_rss = 0.0;
+    r_peak = 0.0;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            r_rss = atof(line.c_str() + 6) / 1024.0;
+        } else if (line.compare(0, 6, "VmHWM:") == 0) {
+            r_peak = atof(line.c_str() + 6) / 1024.0;
+        }
+    }
+}
+
+static double _cpu_usec() {
+#ifndef _WIN32
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec * 1e6 + usage.ru_utime.tv_usec + usage.ru_stime.tv_sec * 1e6 + usage.ru_stime.tv_usec;
+#else
+    return 0.0;
+#endif
+}
+
+// A few seconds of a syllable-paced voice: harmonics with vibrato, gated on
+// and off a few times a second, over a noise floor
+static std::vector<float> _make_voice(int p_seed) {
+    std::mt19937 rng(p_seed);
+    std::normal_distribution<float> noise(0.0f, 0.005f);
+    const double f0 = 100.0 + 25.0 * p_seed;
+    const double syllables = 3.0 + 0.5 * p_seed;
+    std::vector<float> voice((size_t)(VOICE_SECONDS * SAMPLE_RATE));
+    for (size_t i = 0; i < voice.size(); i++) {
+        const double t = (double)i / SAMPLE_RATE;
+        const double pitch = f0 + 10.0 * std::sin(2.0 * M_PI * 4.0 * t);
+        const double envelope = std::max(0.0, std::sin(M_PI * syllables * t));
+        double v = 0.0;
+        for (int h = 1; h <= 6; h++) {
+            v += std::sin(2.0 * M_PI * pitch * h * t + p_seed) / h;
+        }
+        voice[i] = (float)(0.2 * envelope * v) + noise(rng);
+    }
+    return voice;
+}
+
+struct Options {
+    std::string model_path;
+    std::vector<int> contexts = { 1, 8, 64, 512 };
+    std::vector<std::string> modes = { "sync", "shared", "async", "daemon" };
+    int threads = 0;
+    double fps = 60.0;
+    double seconds = 5.0;
+    double warmup_seconds = 1.0;
+    std::string socket_path = daemon_protocol::DEFAULT_SOCKET;
+};
+
+// The model bytes after the rewrites LipSyncContext asks OnnxModel for
+struct Model {
+    std::string bytes;
+    std::string input_name;
+    std::string output_name;
+    int n_mels = 80;
+    int visemes = 15;
+};
+
+static Ort::Session *_make_session(Ort::Env &p_env, const Model &p_model, int p_intra_threads) {
+    Ort::SessionOptions options;
+    options.SetIntraOpNumThreads(p_intra_threads);
+    if (p_intra_threads > 1) {
+        // Idle pool workers would otherwise spin and show up as CPU use
+        options.AddConfigEntry("session.intra_op.allow_spinning", "0");
+    }
+    options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_BASIC);
+    custom_ops::add_to_session_options(options);
+    return new Ort::Session(p_env, p_model.bytes.data(), p_model.bytes.size(), options);
+}
+
+// One simulated LipSyncContext: its own frontend, audio tail and history ring
+struct Context {
+    mel_frontend::Frontend frontend;
+    const std::vector<float> *voice = nullptr;
+    size_t voice_position = 0;
+    float gain = 1.0f;
+    std::vector<float> audio; // Newest samples, at least window_length
+    size_t pending = 0;       // Samples since the last hop
+    std::vector<float> history;
+    int history_start = 0;
+    int history_frames = 0;
+    std::vector<float> window;
+    std::vector<float> visemes;
+
+    // sync backend
+    std::unique_ptr<Ort::Env> env;
+    std::unique_ptr<Ort::Session> session;
+    // daemon backend
+    std::unique_ptr<DaemonClient> client;
+
+    // Appends p_count samples of its voice; returns the feature frames pushed
+    int feed(int p_count, int p_n_mels) {
+        const mel_frontend::Config &config = frontend.get_config();
+        int hops = 0;
+        while (p_count > 0) {
+            const int take = std::min(p_count, config.hop_length - (int)pending);
+            for (int i = 0; i < take; i++) {
+                audio.push_back(gain * (*voice)[voice_position]);
+                voice_position = (voice_position + 1) % voice->size();
+            }
+            p_count -= take;
+            pending += take;
+            if (pending < (size_t)config.hop_length) {
+                break;
+            }
+            pending = 0;
+            const int slot = (history_start + history_frames) % CONTEXT_FRAMES;
+            frontend.compute_frame(audio.data() + audio.size() - config.window_length, history.data() + (size_t)slot * p_n_mels);
+            if (history_frames < CONTEXT_FRAMES) {
+                history_frames++;
+            } else {
+                history_start = (history_start + 1) % CONTEXT_FRAMES;
+            }
+            hops++;
+        }
+        if (audio.size() > (size_t)config.window_length * 4) {
+            audio.erase(audio.begin(), audio.end() - config.window_length);
+        }
+        return hops;
+    }
+
+    // Oldest frame first, into window
+    void unroll(int p_n_mels) {
+        window.resize((size_t)history_frames * p_n_mels);
+        const int head = std::min(history_frames, CONTEXT_FRAMES - history_start);
+        memcpy(window.data(), history.data() + (size_t)history_start * p_n_mels, (size_t)head * p_n_mels * sizeof(float));
+        memcpy(window.data() + (size_t)head * p_n_mels, history.data(), (size_t)(history_frames - head) * p_n_mels * sizeof(float));
+    }
+};
+
+static bool _run_session(Ort::Session &p_session, const Model &p_model, Context &p_context) {
+    static const Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    const int64_t shape[3] = { 1, p_context.history_frames, p_model.n_mels };
+    Ort::Value input = Ort::Value::CreateTensor<float>(memory_info, p_context.window.data(), p_context.window.size(), shape, 3);
+    const char *input_names[] = { p_model.input_name.c_str() };
+    const char *output_names[] = { p_model.output_name.c_str() };
+    std::vector<Ort::Value> outputs = p_session.Run(Ort::RunOptions{ nullptr }, input_names, &input, 1, output_names, 1);
+    const float *values = outputs[0].GetTensorData<float>();
+    const size_t count = outputs[0].GetTensorTypeAndShapeInfo().GetElementCount();
+    p_context.visemes.assign(values + count - p_model.visemes, values + count);
+    return true;
+}
+
+// Shared state for the async backend: the contexts submitted this frame and a
+// countdown the RunAsync callbacks decrement
+struct AsyncFrame {
+    std::mutex mutex;
+    std::condition_variable done;
+    int remaining = 0;
+    std::vector<double> finish_usec;
+};
+
+struct AsyncJob {
+    AsyncFrame *frame;
+    int index;
+    Ort::Value input{ nullptr };
+    Ort::Value output{ nullptr };
+};
+
+static void _on_async_done(void *p_user_data, OrtValue **p_outputs, size_t p_count, OrtStatusPtr p_status) {
+    (void)p_outputs;
+    (void)p_count;
+    (void)p_status;
+    AsyncJob *job = (AsyncJob *)p_user_data;
+    const double now = _now_usec();
+    std::lock_guard<std::mutex> lock(job->frame->mutex);
+    job->frame->finish_usec[job->index] = now;
+    if (--job->frame->remaining == 0) {
+        job->frame->done.notify_one();
+    }
+}
+
+struct Result {
+    std::vector<double> latency_usec;
+    std::vector<double> call_usec;
+    uint64_t inferences = 0;
+    uint64_t hops = 0;
+    uint64_t errors = 0;
+};
+
+static double _percentile(std::vector<double> &p_sorted, double p_q) {
+    if (p_sorted.empty()) {
+        return 0.0;
+    }
+    return p_sorted[std::min(p_sorted.size() - 1, (size_t)(p_q * p_sorted.size()))];
+}
+
+// Runs one (mode, contexts) point; false if the backend isn't available
+static bool _run_point(const Options &p_options, const Model &p_model, const std::vector<std::vector<float>> &p_voices,
+        const std::string &p_mode, int p_count, int p_threads) {
+    double rss_before, peak;
+    _memory_mb(rss_before, peak);
+    const double setup_start = _now_usec();
+
+    Ort::Env shared_env(ORT_LOGGING_LEVEL_WARNING, "bench_scaling");
+    std::unique_ptr<Ort::Session> shared_session;
+    if (p_mode == "shared") {
+        shared_session.reset(_make_session(shared_env, p_model, 1));
+    } else if (p_mode == "async") {
+        // RunAsync runs on the intra-op pool, which needs a worker besides the caller
+        shared_session.reset(_make_session(shared_env, p_model, p_threads + 1));
+    }
+
+    std::vector<std::unique_ptr<Context>> contexts;
+    for (int i = 0; i < p_count; i++) {
+        std::unique_ptr<Context> context(new Context());
+        context->voice = &p_voices[i % VOICES];
+        // Distinct audio per context: another voice, start point and level
+        context->voice_position = (size_t)(i * 7919 * 13) % context->voice->size();
+        context->gain = 0.5f + 0.5f * (float)((i * 37) % 100) / 100.0f;
+        context->audio.assign(context->frontend.get_config().window_length, 0.0f);
+        context->history.assign((size_t)CONTEXT_FRAMES * p_model.n_mels, 0.0f);
+        if (p_mode == "sync") {
+            // OnnxModel constructs an Env of its own for every model
+            context->env.reset(new Ort::Env(ORT_LOGGING_LEVEL_WARNING, "GodotOnnx"));
+            context->session.reset(_make_session(*context->env, p_model, 1));
+        } else if (p_mode == "daemon") {
+            context->client.reset(new DaemonClient());
+            std::string error;
+            if (!context->client->connect(p_options.socket_path, CONTEXT_FRAMES, p_model.n_mels, error)) {
+                printf("%-7s %6d  skipped: %s\n", p_mode.c_str(), p_count, error.c_str());
+                return false;
+            }
+        }
+        contexts.push_back(std::move(context));
+    }
+    const double setup_seconds = (_now_usec() - setup_start) / 1e6;
+
+    const double period_usec = 1e6 / p_options.fps;
+    const int samples_per_frame = (int)std::lround(SAMPLE_RATE / p_options.fps);
+    std::vector<Result> results(p_threads);
+    std::atomic<bool> measuring(false);
+    const double start = _now_usec() + 1000.0;
+    const double measure_start = start + p_options.warmup_seconds * 1e6;
+    const double end = measure_start + p_options.seconds * 1e6;
+    double cpu_start = 0.0;
+    double measured_start_wall = 0.0;
+
+    auto drive = [&](int p_thread) {
+        Result &result = results[p_thread];
+        std::vector<Context *> mine;
+        for (int i = p_thread; i < p_count; i += p_threads) {
+            mine.push_back(contexts[i].get());
+        }
+        AsyncFrame frame;
+        std::vector<AsyncJob> jobs(mine.size());
+        std::vector<double> submitted(mine.size());
+        int64_t frame_index = 0;
+        // An overloaded point can take longer than the whole window for one
+        // frame, so measure a few frames however long they take
+        int recorded_frames = 0;
+        while (true) {
+            const double frame_start = start + frame_index * period_usec;
+            double now = _now_usec();
+            if (now >= end && recorded_frames >= 3) {
+                break;
+            }
+            if (now < frame_start) {
+                std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(frame_start - now)));
+            }
+            // Audio keeps arriving in real time; a late frame takes all of it
+            const int64_t due_frames = std::max<int64_t>(frame_index + 1, (int64_t)((_now_usec() - start) / period_usec));
+            const int samples = (int)((due_frames - frame_index) * samples_per_frame);
+            const double audio_ready = start + (due_frames - 1) * period_usec;
+            frame_index = due_frames;
+            const bool record = _now_usec() >= measure_start;
+            recorded_frames += record ? 1 : 0;
+            if (record && !measuring.exchange(true)) {
+                cpu_start = _cpu_usec();
+                measured_start_wall = _now_usec();
+            }
+
+            if (p_mode == "async") {
+                std::vector<int> ready;
+                uint64_t hops = 0;
+                for (size_t c = 0; c < mine.size(); c++) {
+                    const double call_start = _now_usec();
+                    const int added = mine[c]->feed(samples, p_model.n_mels);
+                    hops += added;
+                    if (added > 0) {
+                        mine[c]->unroll(p_model.n_mels);
+                        submitted[c] = call_start;
+                        ready.push_back((int)c);
+                    }
+                }
+                frame.remaining = (int)ready.size();
+                frame.finish_usec.assign(mine.size(), 0.0);
+                static const Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+                const char *input_names[] = { p_model.input_name.c_str() };
+                const char *output_names[] = { p_model.output_name.c_str() };
+                for (int c : ready) {
+                    AsyncJob &job = jobs[c];
+                    job.frame = &frame;
+                    job.index = c;
+                    const int64_t shape[3] = { 1, mine[c]->history_frames, p_model.n_mels };
+                    job.input = Ort::Value::CreateTensor<float>(memory_info, mine[c]->window.data(), mine[c]->window.size(), shape, 3);
+                    job.output = Ort::Value(nullptr);
+                    shared_session->RunAsync(Ort::RunOptions{ nullptr }, input_names, &job.input, 1, output_names, &job.output, 1, _on_async_done, &job);
+                }
+                std::unique_lock<std::mutex> lock(frame.mutex);
+                frame.done.wait(lock, [&]() { return frame.remaining == 0; });
+                if (record) {
+                    for (int c : ready) {
+                        result.latency_usec.push_back(frame.finish_usec[c] - audio_ready);
+                        result.call_usec.push_back(frame.finish_usec[c] - submitted[c]);
+                    }
+                    result.inferences += ready.size();
+                    result.hops += hops;
+                }
+                continue;
+            }
+
+            for (Context *context : mine) {
+                const double call_start = _now_usec();
+                bool ok = true;
+                bool inferred = false;
+                const int hops = context->feed(samples, p_model.n_mels);
+                if (hops > 0) {
+                    context->unroll(p_model.n_mels);
+                    inferred = true;
+                    try {
+                        if (p_mode == "sync") {
+                            _run_session(*context->session, p_model, *context);
+                        } else if (p_mode == "shared") {
+                            _run_session(*shared_session, p_model, *context);
+                        } else {
+                            std::string error;
+                            context->visemes.resize(context->client->viseme_count());
+                            ok = context->client->infer(context->window.data(), (uint32_t)context->history_frames, context->visemes.data(), error);
+                        }
+                    } catch (const Ort::Exception &) {
+                        ok = false;
+                    }
+                }
+                const double finish = _now_usec();
+                if (record) {
+                    result.hops += hops;
+                    if (!ok) {
+                        result.errors++;
+                    } else if (inferred) {
+                        result.inferences++;
+                        result.latency_usec.push_back(finish - audio_ready);
+                        result.call_usec.push_back(finish - call_start);
+                    }
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < p_threads; t++) {
+        workers.emplace_back(drive, t);
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    const double wall_seconds = (_now_usec() - measured_start_wall) / 1e6;
+    const double cpu_seconds = (_cpu_usec() - cpu_start) / 1e6;
+    double rss_after;
+    _memory_mb(rss_after, peak);
+
+    Result total;
+    for (Result &result : results) {
+        total.latency_usec.insert(total.latency_usec.end(), result.latency_usec.begin(), result.latency_usec.end());
+        total.call_usec.insert(total.call_usec.end(), result.call_usec.begin(), result.call_usec.end());
+        total.inferences += result.inferences;
+        total.hops += result.hops;
+        total.errors += result.errors;
+    }
+    std::sort(total.latency_usec.begin(), total.latency_usec.end());
+    std::sort(total.call_usec.begin(), total.call_usec.end());
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    // Real-time factor: hops of audio consumed over hops that arrived
+    const double realtime = total.hops / (p_count * wall_seconds * SAMPLE_RATE / 160.0);
+    printf("%-7s %6d %8.0f %6.2f %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f %8.0f %7.1f %5.0f%% %6.1f%s\n",
+            p_mode.c_str(), p_count, total.inferences / wall_seconds, realtime,
+            _percentile(total.call_usec, 0.5) / 1000.0, _percentile(total.latency_usec, 0.5) / 1000.0,
+            _percentile(total.latency_usec, 0.9) / 1000.0, _percentile(total.latency_usec, 0.99) / 1000.0,
+            _percentile(total.latency_usec, 0.999) / 1000.0, total.latency_usec.empty() ? 0.0 : total.latency_usec.back() / 1000.0,
+            rss_after - rss_before, peak, 100.0 * cpu_seconds / (wall_seconds * cores), setup_seconds,
+            total.errors > 0 ? "  errors" : "");
+    fflush(stdout);
+
+    contexts.clear();
+    shared_session.reset();
+#ifdef __linux__
+    // Hand freed session memory back so the next point starts from a clean RSS
+    malloc_trim(0);
+#endif
+    return true;
+}
+
+static std::vector<std::string> _split(const std::string &p_list) {
+    std::vector<std::string> items;
+    std::stringstream stream(p_list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const std::string value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg.compare(0, 2, "--") != 0) {
+            options.model_path = arg;
+            continue;
+        }
+        i++;
+        if (arg == "--contexts") {
+            options.contexts.clear();
+            for (const std::string &item : _split(value)) {
+                options.contexts.push_back(std::max(1, atoi(item.c_str())));
+            }
+        } else if (arg == "--modes") {
+            options.modes = _split(value);
+        } else if (arg == "--threads") {
+            options.threads = atoi(value.c_str());
+        } else if (arg == "--fps") {
+            options.fps = std::max(1.0, atof(value.c_str()));
+        } else if (arg == "--seconds") {
+            options.seconds = std::max(0.1, atof(value.c_str()));
+        } else if (arg == "--socket") {
+            options.socket_path = value;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    if (options.model_path.empty()) {
+        fprintf(stderr, "Usage: bench_scaling <model.onnx> [--contexts 1,8,64,512] [--threads M] [--modes sync,shared,async,daemon] [--fps 60] [--seconds 5] [--socket <path>]\n");
+        return 2;
+    }
+
+    std::ifstream file(options.model_path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (bytes.empty()) {
+        fprintf(stderr, "Could not read %s\n", options.model_path.c_str());
+        return 2;
+    }
+    Model model;
+    onnx_graph::Model graph;
+    std::string error;
+    if (graph.load((const uint8_t *)bytes.data(), bytes.size(), error) && onnx_graph::slice_output_to_last_step(graph, error)) {
+        model.bytes = graph.save();
+    } else {
+        fprintf(stderr, "Keeping full output: %s\n", error.c_str());
+        model.bytes = bytes;
+    }
+    {
+        Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "bench_scaling");
+        std::unique_ptr<Ort::Session> session(_make_session(env, model, 1));
+        Ort::AllocatorWithDefaultOptions allocator;
+        model.input_name = session->GetInputNameAllocated(0, allocator).get();
+        model.output_name = session->GetOutputNameAllocated(0, allocator).get();
+        model.n_mels = (int)session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape().back();
+        model.visemes = (int)session->GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape().back();
+    }
+
+    std::vector<std::vector<float>> voices;
+    for (int v = 0; v < VOICES; v++) {
+        voices.push_back(_make_voice(v));
+    }
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    printf("%u cores, %.0f fps, context %d frames, %.1f s per point; latency in ms from the frame start\n",
+            cores, options.fps, CONTEXT_FRAMES, options.seconds);
+    printf("%-7s %6s %8s %6s %8s %8s %8s %8s %8s %8s %8s %7s %6s %6s\n", "mode", "N", "inf/s", "rt", "call p50", "p50",
+            "p90", "p99", "p99.9", "max", "RSS +MB", "peak", "CPU", "setup");
+    for (const std::string &mode : options.modes) {
+        if (mode != "sync" && mode != "shared" && mode != "async" && mode != "daemon") {
+            fprintf(stderr, "Unknown mode %s\n", mode.c_str());
+            return 2;
+        }
+        for (int count : options.contexts) {
+            const int threads = std::min(count, options.threads > 0 ? options.threads : (int)cores);
+            if (!_run_point(options, model, voices, mode, count, threads) && mode == "daemon") {
+                break;
+            }
+        }
+    }
+    return 0;
+}
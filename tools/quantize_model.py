@@ -0,0 +1,134 @@
+#!/usr/bin/env python
+"""Produce a dynamically quantized (INT8) copy of the OpenLipSync model and
+report how closely its visemes agree with the fp32 original.
+
+    python tools/quantize_model.py model.onnx model.int8.onnx [--wav clip.wav]
+
+Requires: onnxruntime, onnx, numpy.
+
+Without --wav the comparison runs on random standard-normal feature windows,
+which is what the per-frame normalisation in AudioProcessor produces on
+average. With --wav the clip is run through a numpy port of the AudioProcessor
+frontend so the comparison uses real speech.
+"""
+
+import argparse
+import sys
+import wave
+
+import numpy as np
+
+
+def quantize(src, dst, per_channel):
+    from onnxruntime.quantization import QuantType, quantize_dynamic
+
+    # ORT's CPU ConvInteger kernel only takes uint8 weights
+    quantize_dynamic(
+        src,
+        dst,
+        weight_type=QuantType.QUInt8,
+        per_channel=per_channel,
+    )
+
+
+# --- numpy port of AudioProcessor (16 kHz, hop 160, window 400, n_fft 1024, 80 mels) ---
+
+
+def _hz_to_mel(hz):
+    return 2595.0 * np.log10(1.0 + hz / 700.0)
+
+
+def _mel_to_hz(mel):
+    return 700.0 * (10.0 ** (mel / 2595.0) - 1.0)
+
+
+def _mel_bank(sample_rate=16000, n_fft=1024, n_mels=80, f_min=50.0, f_max=8000.0):
+    num_spectra = n_fft // 2 + 1
+    mel_points = np.linspace(_hz_to_mel(f_min), _hz_to_mel(f_max), n_mels + 2)
+    bin_points = (n_fft + 1) * _mel_to_hz(mel_points) / sample_rate
+    bank = np.zeros((n_mels, num_spectra), dtype=np.float32)
+    bins = np.arange(num_spectra)
+    for i in range(n_mels):
+        left, center, right = bin_points[i], bin_points[i + 1], bin_points[i + 2]
+        rising = (bins >= left) & (bins <= center)
+        falling = (bins > center) & (bins <= right)
+        bank[i, rising] = (bins[rising] - left) / (center - left)
+        bank[i, falling] = (right - bins[falling]) / (right - center)
+    return bank
+
+
+def wav_features(path, hop=160, win=400, n_fft=1024):
+    with wave.open(path, "rb") as f:
+        if f.getsampwidth() != 2:
+            sys.exit("Only 16-bit PCM WAV files are supported")
+        rate = f.getframerate()
+        channels = f.getnchannels()
+        pcm = np.frombuffer(f.readframes(f.getnframes()), dtype=np.int16).astype(np.float32) / 32768.0
+    mono = pcm.reshape(-1, channels).mean(axis=1)
+    if rate != 16000:
+        positions = np.arange(0, len(mono) - 1, rate / 16000.0)
+        mono = np.interp(positions, np.arange(len(mono)), mono)
+
+    # Streaming frontend starts with (win - hop) zeros of overlap
+    padded = np.concatenate([np.zeros(win - hop, dtype=np.float32), mono])
+    n_frames = len(mono) // hop
+    window = 0.5 * (1.0 - np.cos(2.0 * np.pi * np.arange(win) / (win - 1)))
+    frames = np.stack([padded[i * hop : i * hop + win] * window for i in range(n_frames)])
+    power = np.abs(np.fft.rfft(frames, n=n_fft)) ** 2
+    mel = 10.0 * np.log10(np.maximum(power @ _mel_bank(n_fft=n_fft).T, 1e-10))
+    std = np.maximum(mel.std(axis=1, keepdims=True), 1e-8)
+    return ((mel - mel.mean(axis=1, keepdims=True)) / std).astype(np.float32)
+
+
+# --- comparison ---
+
+
+def compare(fp32_path, int8_path, windows, context):
+    import onnxruntime as ort
+
+    options = ort.SessionOptions()
+    options.intra_op_num_threads = 1
+    reference = ort.InferenceSession(fp32_path, options, providers=["CPUExecutionProvider"])
+    quantized = ort.InferenceSession(int8_path, options, providers=["CPUExecutionProvider"])
+    input_name = reference.get_inputs()[0].name
+
+    agree = 0
+    abs_errors = []
+    for window in windows:
+        feed = {input_name: window[np.newaxis, -context:, :]}
+        ref = reference.run(None, feed)[0][0, -1]
+        out = quantized.run(None, feed)[0][0, -1]
+        agree += int(np.argmax(ref) == np.argmax(out))
+        abs_errors.append(np.abs(ref - out))
+
+    abs_errors = np.stack(abs_errors)
+    print("Compared {} frames (context {})".format(len(windows), context))
+    print("  Top viseme agreement: {:.2f}%".format(100.0 * agree / len(windows)))
+    print("  Mean abs error:       {:.4f}".format(abs_errors.mean()))
+    print("  Max abs error:        {:.4f}".format(abs_errors.max()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="fp32 model")
+    parser.add_argument("target", help="quantized model to write")
+    parser.add_argument("--per-channel", action="store_true", help="per-channel weight scales")
+    parser.add_argument("--wav", help="16-bit PCM WAV to compare on instead of random features")
+    parser.add_argument("--context", type=int, default=100, help="context size in frames (default 100)")
+    parser.add_argument("--frames", type=int, default=500, help="random frames to compare when no --wav is given")
+    args = parser.parse_args()
+
+    quantize(args.source, args.target, args.per_channel)
+    print("Wrote", args.target)
+
+    if args.wav:
+        features = wav_features(args.wav)
+        windows = [features[max(0, t - args.context + 1) : t + 1] for t in range(len(features))]
+    else:
+        rng = np.random.default_rng(0)
+        windows = [rng.standard_normal((args.context, 80)).astype(np.float32) for _ in range(args.frames)]
+    compare(args.source, args.target, windows, args.context)
+
+
+if __name__ == "__main__":
+    main()